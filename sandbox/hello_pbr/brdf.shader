@@ -1,20 +1,9 @@
-#![version("430 core")]
+#![version("450 core")]
 
-#![vertex]
-layout (location = 0) in vec3 aPos;
-layout (location = 2) in vec2 aTexCoord;
-
-out vec2 vTexCoord;
-
-void main() {
-    gl_Position = vec4(aPos, 1.0);
-    vTexCoord = aTexCoord;
-}
-
-#![fragment]
+#![compute]
 #![use("specular.utils")]
-out vec2 FragColor;
-in vec2 vTexCoord;
+layout (local_size_x = 8, local_size_y = 8) in;
+layout (rg32f, binding = 0) uniform writeonly image2D BRDFLUTMap;
 
 vec2 IntegrateBRDF(float NdotV, float roughness) {
     vec3 V;
@@ -54,5 +43,12 @@ vec2 IntegrateBRDF(float NdotV, float roughness) {
 }
 
 void main() {
-    FragColor = IntegrateBRDF(vTexCoord.x, vTexCoord.y);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(BRDFLUTMap);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    // Sample at texel centers, same as rasterizing a full-screen plane.
+    vec2 texCoord = (vec2(texel) + 0.5) / vec2(size);
+    imageStore(BRDFLUTMap, texel, vec4(IntegrateBRDF(texCoord.x, texCoord.y), 0.0, 0.0));
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#![version("430 core")]
+
+#![vertex]
+#![use("frame.utils")]
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 vColor;
+
+void main() {
+    gl_Position = projection * view * vec4(aPos, 1.0);
+    vColor = aColor;
+}
+
+#![fragment]
+out vec4 FragColor;
+
+in vec3 vColor;
+
+void main() {
+    FragColor = vec4(vColor, 1.0);
+}
@@ -1,3 +1,7 @@
+#include <chrono>
+#include <functional>
+#include <filesystem>
+
 #include <glm/common.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -9,58 +13,142 @@
 #include "cabin/utils/model.h"
 #include "cabin/utils/shape.h"
 #include "cabin/utils/camera.h"
+#include "cabin/utils/memorypanel.h"
 #include "cabin/core/shader.h"
+#include "cabin/core/shaderwatcher.h"
 #include "cabin/core/texture.h"
 #include "cabin/core/framebuffer.h"
+#include "cabin/core/ringbuffer.h"
+#include "cabin/core/streambuffer.h"
+#include "cabin/core/parameterblock.h"
 using namespace cabin;
 
 const int ENVIRONMENT_RESOLUTION = 2048;
 
-class HelloPBR: public Sandbox {
-public:
-    HelloPBR() : Sandbox("Hello PBR", 800, 600) {
-        m_et2cubeShader = core::Shader::Builder()
-                            .fromFile("hello_pbr/et2cube.shader")
-                            .build();
-        
-        m_irradianceShader = core::Shader::Builder()
-                                .fromFile("hello_pbr/irradiance.shader")
-                                .build();
+// Directory of cached shader program binaries (relative to sandbox).
+const char* SHADER_CACHE_DIRECTORY = ".cache/hello_pbr";
 
-        m_prefilterShader = core::Shader::Builder()
-                                .fromFile("hello_pbr/prefilter.shader")
-                                .build();
+// Directory of BCn compressed model textures (relative to sandbox).
+const char* TEXTURE_CACHE_DIRECTORY = ".cache/hello_pbr_textures";
 
-        m_BRDFLUTShader = core::Shader::Builder()
-                            .fromFile("hello_pbr/brdf.shader")
-                            .build();
+// Directory of SPIR-V modules compiled by "xmake.lua" after build (relative to sandbox).
+const char* SHADER_SPIRV_DIRECTORY = "hello_pbr/spirv";
 
-        m_shapePBRShader = core::Shader::Builder()
-                            .fromFile("hello_pbr/shapePBR.shader")
-                            .build();
+// Capacity of per-frame parameters, enough for the largest spheres grid.
+const GLsizeiptr PARAMETER_FRAME_SIZE = 64 * 1024;
 
-        m_modelPBRShader = core::Shader::Builder()
-                            .fromFile("hello_pbr/modelPBR.shader")
-                            .build();
+// Half length of the axis lines drawn at each light.
+const float LIGHT_GIZMO_SIZE = 0.5f;
 
-        m_skyboxShader = core::Shader::Builder()
-                            .fromFile("hello_pbr/skybox.shader")
-                            .build();
+//! Matches `Frame` block in "frame.utils".
+struct FrameParameters {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 lightPositions[4];
+    glm::vec3 cameraPosition;
+    float padding0;
+    glm::vec3 lightColor;
+    float padding1;
+};
+CABIN_BLOCK_MEMBER(core::layout::Std140, FrameParameters, view);
+CABIN_BLOCK_MEMBER(core::layout::Std140, FrameParameters, projection);
+CABIN_BLOCK_MEMBER(core::layout::Std140, FrameParameters, lightPositions);
+CABIN_BLOCK_MEMBER(core::layout::Std140, FrameParameters, cameraPosition);
+CABIN_BLOCK_MEMBER(core::layout::Std140, FrameParameters, lightColor);
+
+//! Matches `Sphere` block in "sphere.utils".
+struct SphereParameters {
+    glm::mat4 model;
+    core::layout::Mat3 normalMatrix;
+    glm::vec3 baseColorFactor;
+    float metallicFactor;
+    float roughnessFactor;
+    float occlusionFactor;
+    float padding[2];
+};
+CABIN_BLOCK_MEMBER(core::layout::Std140, SphereParameters, model);
+CABIN_BLOCK_MEMBER(core::layout::Std140, SphereParameters, normalMatrix);
+CABIN_BLOCK_MEMBER(core::layout::Std140, SphereParameters, baseColorFactor);
+CABIN_BLOCK_MEMBER(core::layout::Std140, SphereParameters, metallicFactor);
+CABIN_BLOCK_MEMBER(core::layout::Std140, SphereParameters, roughnessFactor);
+CABIN_BLOCK_MEMBER(core::layout::Std140, SphereParameters, occlusionFactor);
+
+//! Matches `Object` block in "object.utils".
+struct ObjectParameters {
+    glm::mat4 model;
+    core::layout::Mat3 normalMatrix;
+};
+CABIN_BLOCK_MEMBER(core::layout::Std140, ObjectParameters, model);
+CABIN_BLOCK_MEMBER(core::layout::Std140, ObjectParameters, normalMatrix);
+
+//! Vertex of light gizmos, matches "gizmo.shader".
+struct GizmoVertex {
+    glm::vec3 position;
+    glm::vec3 color;
+};
+using GizmoLayout = core::vertex::Layout<&GizmoVertex::position, &GizmoVertex::color>;
+
+class HelloPBR: public Sandbox {
+public:
+    HelloPBR() : Sandbox("Hello PBR", 800, 600) {
+        // Cold start compiles all shaders, warm start loads them from binary cache.
+        m_isWarmStart = std::filesystem::exists(SHADER_CACHE_DIRECTORY);
+        auto shaderSubmitBegin = std::chrono::steady_clock::now();
+
+        // Submit all shaders up front, and keep loading while the driver compiles them.
+        // Only shaders without loose uniforms can use SPIR-V, which drops uniform names.
+        // Targets are assigned through their own type, so that `ComputeShader` checks its program.
+        auto buildShaderAsync = [&]<typename T>(const std::string& path, T& target, bool useSpirv = false) {
+            auto pending = core::Shader::Builder()
+                            .fromFile(path)
+                            .setBinaryCache(SHADER_CACHE_DIRECTORY)
+                            .setSpirvDirectory(useSpirv ? SHADER_SPIRV_DIRECTORY : "")
+                            .buildAsync();
+            auto assign = [&target](core::Shader&& shader) { target = T(std::move(shader)); };
+            m_pendingShaders.push_back({ std::move(pending), assign });
+        };
+
+        buildShaderAsync("hello_pbr/et2cube.shader", m_et2cubeShader);
+        buildShaderAsync("hello_pbr/irradiance.shader", m_irradianceShader);
+        buildShaderAsync("hello_pbr/prefilter.shader", m_prefilterShader);
+        buildShaderAsync("hello_pbr/brdf.shader", m_BRDFLUTShader, true);
+        buildShaderAsync("hello_pbr/shapePBR.shader", m_shapePBRShader);
+        buildShaderAsync("hello_pbr/modelPBR.shader", m_modelPBRShader);
+        buildShaderAsync("hello_pbr/skybox.shader", m_skyboxShader);
+        buildShaderAsync("hello_pbr/gizmo.shader", m_gizmoShader);
+        m_shaderCount = static_cast<int>(m_pendingShaders.size());
+
+        // Preprocessing, binary cache loads and compile submits block here, the rest overlaps loading.
+        auto shaderSubmitEnd = std::chrono::steady_clock::now();
+        m_shaderSubmitTime = std::chrono::duration<double, std::milli>(shaderSubmitEnd - shaderSubmitBegin).count();
 
         m_sphere = utils::Shape::Builder().asShpere(1.0, 64).build();
 
         m_cube = utils::Shape::Builder().asCube().build();
 
-        m_sponzaModel = utils::Model::Builder().fromGLB("assets/models/Sponza.glb").build();
+        m_sponzaModel = utils::Model::Builder()
+                                .setTextureCache(TEXTURE_CACHE_DIRECTORY)
+                                .fromGLB("assets/models/Sponza.glb")
+                                .build();
+
+        m_coffeeCartModel = utils::Model::Builder()
+                                .setTextureCache(TEXTURE_CACHE_DIRECTORY)
+                                .fromGLB("assets/models/CoffeeCart.glb")
+                                .build();
 
-        m_coffeeCartModel = utils::Model::Builder().fromGLB("assets/models/CoffeeCart.glb").build();
+        m_parameterRing = core::RingBuffer(PARAMETER_FRAME_SIZE);
+        m_frameBlock = core::UniformBlock<FrameParameters>(m_parameterRing, 0);
+        m_sphereBlock = core::UniformBlock<SphereParameters>(m_parameterRing, 1);
+        m_objectBlock = core::UniformBlock<ObjectParameters>(m_parameterRing, 2);
 
-        lightPositions = {
-            { "lightPositions[0]", {} },
-            { "lightPositions[1]", {} },
-            { "lightPositions[2]", {} },
-            { "lightPositions[3]", {} },
-        };
+        // Light gizmos are rewritten every frame, into the same ring as parameters.
+        m_gizmoStream = core::StreamBuffer::Builder()
+                                .setRingBuffer(m_parameterRing)
+                                .setLayout(GizmoLayout {})
+                                .build();
+
+        // Shaders still compiling past this point delay the first frame.
+        m_shaderWaitBegin = std::chrono::steady_clock::now();
 
         enableImGui();
         ImGui::GetIO().IniFilename = nullptr;
@@ -78,7 +166,39 @@ public:
         });
 
         glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    }
+
+    /** Take shaders finished by the driver.
+     * 
+     * @return Whether all shaders are built.
+     */
+    bool pollPendingShaders() {
+        std::erase_if(m_pendingShaders, [](PendingShaderBuild& build) {
+            if (!build.pending.isReady())
+                return false;
+
+            build.assign(build.pending.get());
+            return true;
+        });
+
+        if (!m_pendingShaders.empty())
+            return false;
+
+        auto shaderWaitEnd = std::chrono::steady_clock::now();
+        m_shaderWaitTime = std::chrono::duration<double, std::milli>(shaderWaitEnd - m_shaderWaitBegin).count();
+        utils::Console::info(std::format("submitted shaders in {:.2f} ms, waited {:.2f} ms after loading ({} start)",
+                                         m_shaderSubmitTime, m_shaderWaitTime, m_isWarmStart ? "warm" : "cold"));
+
+        // Rebuild shaders on file changes, instead of restarting the app.
+        std::initializer_list<core::Shader*> watchedShaders = {
+            &m_et2cubeShader, &m_irradianceShader, &m_prefilterShader, &m_BRDFLUTShader,
+            &m_shapePBRShader, &m_modelPBRShader, &m_skyboxShader, &m_gizmoShader
+        };
+        for (core::Shader* shader : watchedShaders)
+            m_shaderWatcher.watch(*shader);
+        
         generateIBLCubeMaps();
+        return true;
     }
 
     void generateIBLCubeMaps() {
@@ -117,15 +237,16 @@ public:
         int mapLength {};
 
         /* From Equirectangular To CubeMap */
+        // Half floats are plenty for the source of the cube map, at half the memory.
         auto hdrTexture = core::Texture::Builder()
-                                .fromFile2D(HDRIPath, GL_RGB32F)
+                                .fromFile2D(HDRIPath, GL_RGB16F)
                                 .setWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)
                                 .setFilter(GL_LINEAR, GL_LINEAR)
                                 .build();
         
         mapLength = ENVIRONMENT_RESOLUTION;
         m_envCubeMap = core::Texture::Builder()
-                            .asEmptyCubeMap(mapLength, GL_RGB32F)
+                            .asEmptyCubeMap(mapLength, GL_RGB32F, core::Texture::ALL_MIPMAP_LEVELS)
                             .setWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)
                             .setFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR)
                             .build();
@@ -167,12 +288,14 @@ public:
         }
 
         /* Prefilter Map */
+        int maxMipmapLevel = 5;
+
+        // Every level is rendered below, so only allocate them, without generating.
         mapLength = ENVIRONMENT_RESOLUTION / 8;
         m_prefilterMap = core::Texture::Builder()
-                                .asEmptyCubeMap(mapLength, GL_RGB32F)
+                                .asEmptyCubeMap(mapLength, GL_RGB32F, maxMipmapLevel)
                                 .setWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)
                                 .setFilter(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR)
-                                .genMipmap()
                                 .build();
         
         m_envCubeMap.active(0);
@@ -181,8 +304,6 @@ public:
         m_prefilterShader.setFloat("envResolution", static_cast<float>(ENVIRONMENT_RESOLUTION));
         m_prefilterShader.setInt("envCubeMap", 0);
 
-        int maxMipmapLevel = 5;
-
         for (int level = 0; level < maxMipmapLevel; level++) {
             int mipmapWidth = static_cast<int>(mapLength * pow(0.5, level));
             int mipmapHeight = static_cast<int>(mapLength * pow(0.5, level));
@@ -206,12 +327,10 @@ public:
                                 .setWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE)
                                 .setFilter(GL_LINEAR, GL_LINEAR)
                                 .build();
-        auto planeShape = utils::Shape::Builder().asPlane().build();
 
-        m_BRDFLUTShader.bind();
-        glViewport(0, 0, mapLength, mapLength);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_BRDFLUTMap.id.value(), 0);
-        planeShape.draw();
+        m_BRDFLUTMap.bindImage(0, GL_WRITE_ONLY);
+        m_BRDFLUTShader.dispatchThreads(mapLength, mapLength);
+        core::ComputeShader::barrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 
         // Resize viewport to window's size
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -222,30 +341,52 @@ public:
     }
 
     void renderFrame() override {
-        processInput();
-
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        lightPositions[0].second = {  lightSpacing,  lightSpacing, lightDistance };
-        lightPositions[1].second = { -lightSpacing,  lightSpacing, lightDistance };
-        lightPositions[2].second = {  lightSpacing, -lightSpacing, lightDistance };
-        lightPositions[3].second = { -lightSpacing, -lightSpacing, lightDistance };
+        // Show loading screen until all shaders are built.
+        if (!m_isLoaded) {
+            m_isLoaded = pollPendingShaders();
+            return;
+        }
+
+        auto shaderReloadBegin = std::chrono::steady_clock::now();
+        if (size_t reloadCount = m_shaderWatcher.poll()) {
+            auto shaderReloadEnd = std::chrono::steady_clock::now();
+            m_shaderReloadTime = std::chrono::duration<double, std::milli>(shaderReloadEnd - shaderReloadBegin).count();
+            utils::Console::info(std::format("reloaded {} shaders in {:.2f} ms", reloadCount, m_shaderReloadTime));
+        }
+
+        processInput();
+
+        // Uniform uploads issued and skipped during last frame.
+        m_uniformStatistics = core::Shader::getUniformStatistics();
+        core::Shader::resetUniformStatistics();
+
+        m_parameterRing.beginFrame();
 
         glm::mat4 view = m_camera.getLookAt();
         glm::mat4 projection;
         auto [width, height] = getWindowSize();
         float aspect = static_cast<float>(width) / (height != 0.0f ? height : 1.0f);
         projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 50.0f);
+
+        FrameParameters frameParameters {};
+        frameParameters.view = view;
+        frameParameters.projection = projection;
+        frameParameters.lightPositions[0] = {  lightSpacing,  lightSpacing, lightDistance, 1.0f };
+        frameParameters.lightPositions[1] = { -lightSpacing,  lightSpacing, lightDistance, 1.0f };
+        frameParameters.lightPositions[2] = {  lightSpacing, -lightSpacing, lightDistance, 1.0f };
+        frameParameters.lightPositions[3] = { -lightSpacing, -lightSpacing, lightDistance, 1.0f };
+        frameParameters.cameraPosition = m_camera.position;
+        frameParameters.lightColor = lightIntensity * lightColor;
+        m_frameBlock.update(frameParameters);
         
         /* Render Scene */
         glEnable(GL_CULL_FACE);
 
         if (sceneIndex == 0 || sceneIndex == 1) {
             m_shapePBRShader.bind();
-            m_shapePBRShader.setMat4("view", view);
-            m_shapePBRShader.setMat4("projection", projection);
-            m_shapePBRShader.setVec3("cameraPosition", m_camera.position);
             
             m_irradianceMap.active(0);
             m_shapePBRShader.setInt("irradianceMap", 0);
@@ -254,11 +395,6 @@ public:
             m_BRDFLUTMap.active(2);
             m_shapePBRShader.setInt("BRDFLUTMap", 2);
 
-            m_shapePBRShader.setVec3("lightColor", lightIntensity * lightColor);
-            for (auto& [name, value] : lightPositions) {
-                m_shapePBRShader.setVec3(name, value);
-            }
-
             if (sceneIndex == 0) {
                 for (int i = 0; i < sphereRowCount; i++) {
                     for (int j = 0; j < sphereColCount; j++) {
@@ -273,16 +409,14 @@ public:
                         glm::mat3 normalMatrix = glm::mat3(model);
                         normalMatrix = glm::transpose(glm::inverse(normalMatrix));
 
-                        m_shapePBRShader.setMat4("model", model);
-                        m_shapePBRShader.setMat3("normalMatrix", normalMatrix);
-
-                        float metallicFactor = static_cast<float>(j) / sphereColCount;
-                        float roughnessFactor = 1.0f - static_cast<float>(i) / sphereRowCount;
-                        
-                        m_shapePBRShader.setVec3("baseColorFactor", { 0.5f, 0.0f, 0.0f });
-                        m_shapePBRShader.setFloat("metallicFactor", metallicFactor);
-                        m_shapePBRShader.setFloat("roughnessFactor", roughnessFactor);
-                        m_shapePBRShader.setFloat("occlusionFactor", 1.0f);
+                        SphereParameters sphereParameters {};
+                        sphereParameters.model = model;
+                        sphereParameters.normalMatrix = normalMatrix;
+                        sphereParameters.baseColorFactor = { 0.5f, 0.0f, 0.0f };
+                        sphereParameters.metallicFactor = static_cast<float>(j) / sphereColCount;
+                        sphereParameters.roughnessFactor = 1.0f - static_cast<float>(i) / sphereRowCount;
+                        sphereParameters.occlusionFactor = 1.0f;
+                        m_sphereBlock.update(sphereParameters);
 
                         m_sphere.draw();
                     }
@@ -295,13 +429,14 @@ public:
                 glm::mat3 normalMatrix = glm::mat3(model);
                 normalMatrix = glm::transpose(glm::inverse(normalMatrix));
 
-                m_shapePBRShader.setMat4("model", model);
-                m_shapePBRShader.setMat3("normalMatrix", normalMatrix);
-                
-                m_shapePBRShader.setVec3("baseColorFactor", mtBaseColor);
-                m_shapePBRShader.setFloat("metallicFactor", mtORM.b);
-                m_shapePBRShader.setFloat("roughnessFactor", mtORM.g);
-                m_shapePBRShader.setFloat("occlusionFactor", mtORM.r);
+                SphereParameters sphereParameters {};
+                sphereParameters.model = model;
+                sphereParameters.normalMatrix = normalMatrix;
+                sphereParameters.baseColorFactor = mtBaseColor;
+                sphereParameters.metallicFactor = mtORM.b;
+                sphereParameters.roughnessFactor = mtORM.g;
+                sphereParameters.occlusionFactor = mtORM.r;
+                m_sphereBlock.update(sphereParameters);
 
                 m_sphere.draw();
             }            
@@ -323,24 +458,15 @@ public:
             glm::mat3 normalMatrix = glm::mat3(model);
             normalMatrix = glm::transpose(glm::inverse(normalMatrix));
 
-            m_modelPBRShader.bind();
-            m_modelPBRShader.setMat4("model", model);
-            m_modelPBRShader.setMat4("view", view);
-            m_modelPBRShader.setMat4("projection", projection);
-            m_modelPBRShader.setMat3("normalMatrix", normalMatrix);
-            m_modelPBRShader.setVec3("cameraPosition", m_camera.position);
+            // Shared by all variants of model's shader, which are picked by `utils::Model::draw`.
+            ObjectParameters objectParameters {};
+            objectParameters.model = model;
+            objectParameters.normalMatrix = normalMatrix;
+            m_objectBlock.update(objectParameters);
 
             m_irradianceMap.active(5);
-            m_modelPBRShader.setInt("irradianceMap", 5);
             m_prefilterMap.active(6);
-            m_modelPBRShader.setInt("prefilterMap", 6);
             m_BRDFLUTMap.active(7);
-            m_modelPBRShader.setInt("BRDFLUTMap", 7);
-
-            m_modelPBRShader.setVec3("lightColor", lightIntensity * lightColor);
-            for (auto& [name, value] : lightPositions) {
-                m_modelPBRShader.setVec3(name, value);
-            }
 
             if (sceneIndex == 2) {
                 m_sponzaModel.draw(m_modelPBRShader);
@@ -355,6 +481,22 @@ public:
             }
         }
 
+        /* Render Light Gizmos */
+        if (showLightGizmos) {
+            std::vector<GizmoVertex> gizmoVertices {};
+            for (const glm::vec4& lightPosition : frameParameters.lightPositions) {
+                for (int axis = 0; axis < 3; axis++) {
+                    glm::vec3 offset { 0.0f };
+                    offset[axis] = LIGHT_GIZMO_SIZE;
+                    gizmoVertices.push_back({ glm::vec3(lightPosition) - offset, lightColor });
+                    gizmoVertices.push_back({ glm::vec3(lightPosition) + offset, lightColor });
+                }
+            }
+
+            m_gizmoShader.bind();
+            m_gizmoStream.draw(m_gizmoStream.push(gizmoVertices.data(), gizmoVertices.size()), GL_LINES);
+        }
+
         /* Render Skybox */
         glDisable(GL_CULL_FACE);
         glDepthFunc(GL_LEQUAL);
@@ -375,13 +517,27 @@ public:
 
         m_skyboxShader.bind();
         m_skyboxShader.setInt("envCubeMap", 0);
-        m_skyboxShader.setMat4("view", glm::mat4(glm::mat3(view)));
-        m_skyboxShader.setMat4("projection", projection);
         m_cube.draw();
+
+        m_parameterRing.endFrame();
     }
 
     void interfaceFrame() override {
 
+        if (!m_isLoaded) {
+            auto [width, height] = getWindowSize();
+            ImGui::SetNextWindowPos(ImVec2(width * 0.5f, height * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+            ImGui::SetNextWindowSize(ImVec2(240, 0), ImGuiCond_Always);
+
+            int builtCount = m_shaderCount - static_cast<int>(m_pendingShaders.size());
+            if (ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove)) {
+                ImGui::Text("Building shaders... (%d/%d)", builtCount, m_shaderCount);
+                ImGui::ProgressBar(static_cast<float>(builtCount) / m_shaderCount);
+            }
+            ImGui::End();
+            return;
+        }
+
         ImGui::SetNextWindowSize(ImVec2(320, 490), ImGuiCond_FirstUseEver);
 
         if (ImGui::Begin("Inspector")) {
@@ -401,6 +557,7 @@ public:
                 ImGui::InputFloat("Spacing##lights", &lightSpacing, 1.0f);
                 ImGui::InputFloat("Intensity##lights", &lightIntensity, 10.0f);
                 ImGui::ColorEdit3("Color##lights", &lightColor[0]);
+                ImGui::Checkbox("Gizmos##lights", &showLightGizmos);
 
                 lightDistance  =  glm::clamp(lightDistance, 0.0f, 1000.0f);
                 lightSpacing   =  glm::clamp(lightSpacing,  0.0f, 1000.0f);
@@ -408,6 +565,18 @@ public:
             }
 
 
+            ImGui::SeparatorText("Startup");
+            ImGui::BulletText("Shaders: %.2f ms submit, %.2f ms wait (%s start)",
+                              m_shaderSubmitTime, m_shaderWaitTime, m_isWarmStart ? "warm" : "cold");
+            ImGui::BulletText("Last Reload: %.2f ms", m_shaderReloadTime);
+            ImGui::BulletText("Uniforms: %zu uploaded, %zu skipped", m_uniformStatistics.uploads, m_uniformStatistics.skips);
+
+
+            ImGui::SeparatorText("Memory");
+            ImGui::BulletText("GPU: %.1f MiB resident", core::MemoryBudget::getShared().getResidentSize() / (1024.0 * 1024.0));
+            ImGui::Checkbox("Memory Panel", &showMemoryPanel);
+
+
             ImGui::SeparatorText("Scene");
             static const char* scenes[] = { "Spheres", "Material Sandbox", "Sponza", "Coffee Cart" };
             ImGui::Combo("Scene", &sceneIndex, scenes, IM_ARRAYSIZE(scenes));
@@ -454,6 +623,10 @@ public:
             }
         }
         ImGui::End();
+
+        // Textures of scenes not shown are evicted first, once a budget is set.
+        if (showMemoryPanel)
+            m_memoryPanel.draw(&showMemoryPanel);
     }
 
     void processInput() {
@@ -475,7 +648,7 @@ private:
     float lightDistance = 10.0f;
     glm::vec3 lightColor { 1.0f };
     float lightIntensity = 100.0f;
-    std::vector<std::pair<std::string, glm::vec3>> lightPositions {};
+    bool showLightGizmos = false;
 
     // Spheres Settings
     int sphereRowCount = 5;
@@ -495,6 +668,9 @@ private:
     float coffeeCartScaleFactor = 1.0f;
     float coffeeCartRotationSpeed = 1.0f;
     float coffeeCartRotationAngle = 0.0f;
+
+    // Memory Settings
+    bool showMemoryPanel = false;
     
 private:
     utils::Camera m_camera {
@@ -510,16 +686,41 @@ private:
     core::Shader m_et2cubeShader {};
     core::Shader m_irradianceShader {};
     core::Shader m_prefilterShader {};
-    core::Shader m_BRDFLUTShader {};
+    core::ComputeShader m_BRDFLUTShader {};
 
     core::Shader m_shapePBRShader {};
     core::Shader m_modelPBRShader {};
     core::Shader m_skyboxShader {};
+    core::Shader m_gizmoShader {};
+
+    struct PendingShaderBuild {
+        core::PendingShader pending;
+        std::function<void(core::Shader&&)> assign;
+    };
+
+    std::vector<PendingShaderBuild> m_pendingShaders {};
+    int m_shaderCount { 0 };
+    bool m_isLoaded { false };
+    bool m_isWarmStart { false };
+    double m_shaderSubmitTime { 0.0 };
+    double m_shaderWaitTime { 0.0 };
+    double m_shaderReloadTime { 0.0 };
+    core::Shader::UniformStatistics m_uniformStatistics {};
+    core::ShaderWatcher m_shaderWatcher {};
+    std::chrono::steady_clock::time_point m_shaderWaitBegin {};
 
     core::Texture m_envCubeMap {};
     core::Texture m_irradianceMap {};
     core::Texture m_prefilterMap {};
     core::Texture m_BRDFLUTMap {};
+
+    core::RingBuffer m_parameterRing {};
+    core::UniformBlock<FrameParameters> m_frameBlock {};
+    core::UniformBlock<SphereParameters> m_sphereBlock {};
+    core::UniformBlock<ObjectParameters> m_objectBlock {};
+    core::StreamBuffer m_gizmoStream {};
+
+    utils::MemoryPanel m_memoryPanel {};
 };
 
 int main() {
@@ -2,16 +2,19 @@
 
 #![version("430 core")]
 
+// Material textures, enabled per primitive by `utils::Model::draw`.
+#![feature("BASE_COLOR_TEXTURE")]
+#![feature("METALLIC_ROUGHNESS_TEXTURE")]
+#![feature("NORMAL_TEXTURE")]
+#![feature("OCCLUSION_TEXTURE")]
+
 #![vertex]
+#![use("frame.utils")]
+#![use("object.utils")]
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat3 normalMatrix;
-
 out vec3 vPosition;
 out vec3 vNormal;
 out vec2 vTexCoord;
@@ -25,36 +28,39 @@ void main() {
 
 #![fragment]
 #![use("PBR.utils")]
+#![use("frame.utils")]
 out vec4 FragColor;
 
 in vec3 vPosition;
 in vec3 vNormal;
 in vec2 vTexCoord;
 
-uniform vec3 cameraPosition;
-uniform vec3 lightPositions[4];
-uniform vec3 lightColor;
-
-uniform int normalTexMarker;
-uniform int baseColorTexMarker;
-uniform int metallicRoughnessTexMarker;
-uniform int occulsionTexMarker;
-
 uniform vec4 baseColorFactor;
 uniform float metallicFactor;
 uniform float roughnessFactor;
 
-uniform sampler2D normalTexture;
-uniform sampler2D baseColorTexture;
-uniform sampler2D metallicRoughnessTexture;
-uniform sampler2D occlusionTexture;
+// Material textures are layers of texture arrays, shared by primitives.
+uniform sampler2DArray normalTexture;
+uniform sampler2DArray baseColorTexture;
+uniform sampler2DArray metallicRoughnessTexture;
+uniform sampler2DArray occlusionTexture;
+
+uniform int normalLayer;
+uniform int baseColorLayer;
+uniform int metallicRoughnessLayer;
+uniform int occlusionLayer;
 
-uniform samplerCube irradianceMap;
-uniform samplerCube prefilterMap;
-uniform sampler2D BRDFLUTMap;
+// Shared by all variants, bound by main.cc.
+layout (binding = 5) uniform samplerCube irradianceMap;
+layout (binding = 6) uniform samplerCube prefilterMap;
+layout (binding = 7) uniform sampler2D BRDFLUTMap;
 
+#ifdef NORMAL_TEXTURE
 vec3 getNormalFromMap() {
-    vec3 tangentNormal = texture(normalTexture, vTexCoord).rgb * 2.0 - 1.0;
+    // Z is reconstructed, since BC5 compressed normal maps only keep X and Y.
+    vec3 tangentNormal;
+    tangentNormal.xy = texture(normalTexture, vec3(vTexCoord, normalLayer)).rg * 2.0 - 1.0;
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
     vec3 Q1  = dFdx(vPosition);
     vec3 Q2  = dFdy(vPosition);
@@ -68,32 +74,35 @@ vec3 getNormalFromMap() {
 
     return normalize(TBN * tangentNormal);
 }
+#endif
 
 void main() {
+#ifdef NORMAL_TEXTURE
+    vec3 normal = getNormalFromMap();
+#else
     vec3 normal = vNormal;
-    if (normalTexMarker == 1)
-        normal = getNormalFromMap();
-
-    vec3 baseColor;
-    if (baseColorTexMarker == 1) {
-        baseColor = texture(baseColorTexture, vTexCoord).rgb;
-    }
-    else
-        baseColor = baseColorFactor.rgb;
-
-    float metallic, roughness;
-    if (metallicRoughnessTexMarker == 1) {
-        metallic = texture(metallicRoughnessTexture, vTexCoord).b;
-        roughness = texture(metallicRoughnessTexture, vTexCoord).g;
-    }
-    else {
-        metallic = metallicFactor;
-        roughness = roughnessFactor;
-    }
-    
+#endif
+
+#ifdef BASE_COLOR_TEXTURE
+    vec3 baseColor = texture(baseColorTexture, vec3(vTexCoord, baseColorLayer)).rgb;
+#else
+    vec3 baseColor = baseColorFactor.rgb;
+#endif
+
+#ifdef METALLIC_ROUGHNESS_TEXTURE
+    vec2 metallicRoughness = texture(metallicRoughnessTexture, vec3(vTexCoord, metallicRoughnessLayer)).bg;
+    float metallic = metallicRoughness.x;
+    float roughness = metallicRoughness.y;
+#else
+    float metallic = metallicFactor;
+    float roughness = roughnessFactor;
+#endif
+
+#ifdef OCCLUSION_TEXTURE
+    float occlusion = texture(occlusionTexture, vec3(vTexCoord, occlusionLayer)).r;
+#else
     float occlusion = 1.0f;
-    if (occulsionTexMarker == 1)
-        occlusion = texture(occlusionTexture, vTexCoord).r;
+#endif
 
     vec3 N = normalize(normal);
     vec3 V = normalize(cameraPosition - vPosition);
@@ -104,10 +113,10 @@ void main() {
 
     vec3 lightLo = vec3(0.0);
     for (int i = 0; i < 4; i++) {
-        vec3 L = normalize(lightPositions[i] - vPosition);
+        vec3 L = normalize(lightPositions[i].xyz - vPosition);
         vec3 H = normalize(V + L);
 
-        float distance = length(lightPositions[i] - vPosition);
+        float distance = length(lightPositions[i].xyz - vPosition);
         float attenuation = 1.0 / (distance * distance);
         vec3 radiance = lightColor * attenuation;
 
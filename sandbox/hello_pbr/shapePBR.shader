@@ -3,14 +3,11 @@
 #![version("430 core")]
 
 #![vertex]
+#![use("frame.utils")]
+#![use("sphere.utils")]
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aNormal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat3 normalMatrix;
-
 out vec3 vPosition;
 out vec3 vNormal;
 
@@ -22,20 +19,13 @@ void main() {
 
 #![fragment]
 #![use("PBR.utils")]
+#![use("frame.utils")]
+#![use("sphere.utils")]
 out vec4 FragColor;
 
 in vec3 vPosition;
 in vec3 vNormal;
 
-uniform vec3 cameraPosition;
-uniform vec3 lightPositions[4];
-uniform vec3 lightColor;
-
-uniform vec3 baseColorFactor;
-uniform float metallicFactor;
-uniform float roughnessFactor;
-uniform float occlusionFactor;
-
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D BRDFLUTMap;
@@ -50,10 +40,10 @@ void main() {
 
     vec3 lightLo = vec3(0.0);
     for (int i = 0; i < 4; i++) {
-        vec3 L = normalize(lightPositions[i] - vPosition);
+        vec3 L = normalize(lightPositions[i].xyz - vPosition);
         vec3 H = normalize(V + L);
 
-        float distance = length(lightPositions[i] - vPosition);
+        float distance = length(lightPositions[i].xyz - vPosition);
         float attenuation = 1.0 / (distance * distance);
         vec3 radiance = lightColor * attenuation;
 
@@ -1,15 +1,13 @@
 #![version("430 core")]
 
 #![vertex]
+#![use("frame.utils")]
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 view;
-uniform mat4 projection;
-
 out vec3 vPos;
 
 void main() {
-    gl_Position = (projection * view * vec4(aPos, 1.0)).xyww;
+    gl_Position = (projection * mat4(mat3(view)) * vec4(aPos, 1.0)).xyww;
     vPos = aPos;
 }
 
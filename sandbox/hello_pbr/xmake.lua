@@ -1,3 +1,34 @@
 target("hello_pbr")
     set_kind("binary")
-    add_files("main.cc")
\ No newline at end of file
+    add_files("main.cc")
+
+    -- Validate shaders offline, so that syntax errors fail the build.
+    add_deps("cabin-shaderc")
+    add_packages("glslang")
+    after_build(function (target)
+        import("lib.detect.find_tool")
+
+        local shaderc = target:dep("cabin-shaderc"):targetfile()
+        os.execv(shaderc, os.files(path.join(target:scriptdir(), "*.shader")))
+
+        -- Compile SPIR-V modules of shaders loaded with `SHADER_SPIRV_DIRECTORY` (relative to sandbox).
+        local spirvdir = path.join(target:scriptdir(), "spirv")
+        os.execv(shaderc, {"-m", spirvdir, path.join(target:scriptdir(), "brdf.shader")})
+
+        local glslang = target:pkg("glslang")
+        local validator = find_tool("glslangValidator", {paths = glslang and path.join(glslang:installdir(), "bin")})
+        if not validator then
+            cprint("${color.warning}glslangValidator not found, SPIR-V stages of hello_pbr fall back to GLSL")
+            return
+        end
+
+        -- Modules are named by the hash of their source, so existing ones are up to date.
+        for _, extension in ipairs({"vert", "geom", "frag", "comp"}) do
+            for _, source in ipairs(os.files(path.join(spirvdir, "*." .. extension))) do
+                local module = path.join(spirvdir, path.basename(source) .. ".spv")
+                if not os.isfile(module) then
+                    os.vrunv(validator.program, {"-G", "--quiet", "-o", module, source})
+                end
+            end
+        end
+    end)
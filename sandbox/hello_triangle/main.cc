@@ -40,7 +40,7 @@ static std::vector<Vertex> vertices = {
     { { 0.0f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }
 };
 
-static std::vector<unsigned int> indices = { 0, 1, 2 };
+static const unsigned char indices[] = { 0, 1, 2 };
 
 class HelloTriangle: public Sandbox {
 public:
@@ -54,8 +54,8 @@ public:
         m_vertexBuffer = std::make_unique<core::VertexBuffer>(
             core::VertexBuffer::Builder()
                                 .setBuffer(static_cast<void*>(vertices.data()), sizeof(Vertex) * vertices.size(), GL_STATIC_DRAW)
-                                .addAttribute<float>(0, 3)
-                                .addAttribute<float>(1, 3)
+                                .setIndices(indices, std::size(indices))
+                                .setLayout(core::vertex::Layout<&Vertex::position, &Vertex::color> {})
                                 .build()
         );
 
@@ -91,7 +91,6 @@ public:
         glClear(GL_COLOR_BUFFER_BIT);
 
         m_shader->bind();
-        m_vertexBuffer->bind();
 
         glm::mat4 model { 1.0f };
         model = glm::translate(model, glm::vec3(0.0, 0.0, -1.0));
@@ -109,8 +108,7 @@ public:
         m_shader->setMat4("view", view);
         m_shader->setMat4("projection", projection);
 
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), 
-                        GL_UNSIGNED_INT, static_cast<void*>(indices.data()));
+        m_vertexBuffer->draw(GL_TRIANGLES);
     }
 
     void interfaceFrame() override {
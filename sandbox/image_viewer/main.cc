@@ -5,11 +5,14 @@
  * Licensed under the MIT License.
  *
  * `Image Viewer` is a image preview application,
- *  showing a simple usage of `core::Framebuffer`.
+ *  showing a simple usage of `core::Framebuffer`, decoding
+ *  dropped images in background, and streaming them to the
+ *  GPU with `core::TextureUploader`.
  */
 
 #include <memory>
 #include <vector>
+#include <optional>
 
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -20,6 +23,7 @@
 #include "cabin/sandbox.h"
 #include "cabin/core/shader.h"
 #include "cabin/core/texture.h"
+#include "cabin/core/textureuploader.h"
 #include "cabin/core/framebuffer.h"
 #include "cabin/core/vertexbuffer.h"
 using namespace cabin;
@@ -36,10 +40,13 @@ std::vector<Vertex> squareVertices = {
     { { -1.0f,  1.0f }, { 0.0f, 1.0f } },
 };
 
-std::vector<unsigned int> indices = {
+const unsigned char squareIndices[] = {
     0, 1, 2, 0, 2, 3
 };
 
+//! Capacity of each staging buffer, larger images are uploaded in row bands.
+constexpr GLsizeiptr IMAGE_STAGING_SIZE = 16 * 1024 * 1024;
+
 
 class ImageViewer: public Sandbox {
 public:
@@ -47,6 +54,7 @@ public:
         m_vertexBuffer = std::make_unique<core::VertexBuffer>(
             core::VertexBuffer::Builder()
                             .setBuffer(squareVertices.data(), squareVertices.size() * sizeof(Vertex), GL_STATIC_DRAW)
+                            .setIndices(squareIndices, std::size(squareIndices))
                             .addAttribute<float>(0, 2)
                             .addAttribute<float>(1, 2)
                             .build()
@@ -63,13 +71,13 @@ public:
         );
         m_imageTexture = std::make_unique<core::Texture>(
             core::Texture::Builder()
-                        .fromFile2D("image_viewer/awesomeface.png")
+                        .fromFile2D("image_viewer/awesomeface.png", GL_RGBA8, true, core::Texture::ALL_MIPMAP_LEVELS)
                         .setWrap(GL_REPEAT, GL_REPEAT)
                         .setFilter(GL_LINEAR, GL_LINEAR)
-                        .genMipmap()
                         .build()
         );
         m_subFramebuffer = std::make_unique<core::FrameBuffer>();
+        m_textureUploader = core::TextureUploader(IMAGE_STAGING_SIZE);
 
         glfwSetWindowUserPointer(window, reinterpret_cast<void*>(this));
         glfwSwapInterval(true);
@@ -113,23 +121,13 @@ public:
                 app->m_showError = true;
             }
             else {
-                try {
-                    auto inputImage = std::make_unique<core::Texture>(
-                        core::Texture::Builder()
-                                    .fromFile2D(paths[0])
-                                    .setWrap(GL_REPEAT, GL_REPEAT)
-                                    .setFilter(GL_LINEAR, GL_LINEAR)
-                                    .genMipmap()
-                                    .build()
-                    );
-                    app->m_imageTexture = std::move(inputImage);
-                    app->m_imagePath = paths[0];
-                    app->resetImageParameters();
-                    app->genPixelizedTexture();
-                } catch (const std::exception& e) {
-                    app->m_openErrorInfo = e.what();
-                    app->m_showError = true;
-                }
+                // Decode in background, the current image stays until the new one is uploaded.
+                app->m_pendingImage = core::Texture::Builder()
+                                            .fromFile2DAsync(paths[0], GL_RGBA8, true, core::Texture::ALL_MIPMAP_LEVELS)
+                                            .setWrap(GL_REPEAT, GL_REPEAT)
+                                            .setFilter(GL_LINEAR, GL_LINEAR)
+                                            .buildAsync();
+                app->m_pendingImagePath = paths[0];
             }
         });
 
@@ -168,8 +166,7 @@ public:
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), 
-                        GL_UNSIGNED_INT, static_cast<void*>(indices.data()));
+        m_vertexBuffer->draw(GL_TRIANGLES);
 
         auto [width, height] = getWindowSize();
         glViewport(0, 0, width, height);
@@ -194,7 +191,25 @@ public:
         }
     }
 
+    //! Take the dropped image once decoded.
+    void pollPendingImage() {
+        if (!m_pendingImage.has_value() || !m_pendingImage->isReady())
+            return;
+
+        try {
+            m_imageTexture = std::make_unique<core::Texture>(m_pendingImage->get(m_textureUploader));
+            m_imagePath = m_pendingImagePath;
+            resetImageParameters();
+            genPixelizedTexture();
+        } catch (const std::exception& e) {
+            m_openErrorInfo = e.what();
+            m_showError = true;
+        }
+        m_pendingImage.reset();
+    }
+
     void renderFrame() override {
+        pollPendingImage();
         processInput();
 
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -219,8 +234,10 @@ public:
         else
             m_imageTexture->active(0);
 
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), 
-                        GL_UNSIGNED_INT, static_cast<void*>(indices.data()));
+        m_vertexBuffer->draw(GL_TRIANGLES);
+
+        // Fence this frame's uploads, so their staging buffer is reused only once consumed.
+        m_textureUploader.flush();
     }
 
     void interfaceFrame() override {
@@ -248,8 +265,10 @@ public:
         if (ImGui::Begin("menu", nullptr, windowFlags))
         {
             ImGui::Text("%s", m_imagePath.c_str());
+            if (m_pendingImage.has_value())
+                ImGui::Text("Loading \"%s\"...", m_pendingImagePath.c_str());
             ImGui::BulletText("Size: %d * %d", m_imageTexture->width, m_imageTexture->height);
-            ImGui::BulletText("Format: %s", m_imageTexture->format == GL_RGB ? "RGB" : "RGBA");
+            ImGui::BulletText("Format: %s", m_imageTexture->format == GL_RGB8 ? "RGB" : "RGBA");
 
             ImGui::SeparatorText("Style");
             ImGui::RadioButton("Raw", &m_imageStyle, 0); ImGui::SameLine();
@@ -309,6 +328,9 @@ private:
     bool m_showError = false;
     std::string m_imagePath {  "awesomeface.png" };
     std::string m_openErrorInfo {};
+
+    std::optional<core::PendingTexture> m_pendingImage {};
+    std::string m_pendingImagePath {};
     
     bool m_underMove = false;
     glm::vec2 m_clickPosition {};
@@ -327,6 +349,7 @@ private:
     std::unique_ptr<core::FrameBuffer> m_subFramebuffer;
     std::unique_ptr<core::Texture> m_imageTexture;
     std::unique_ptr<core::Texture> m_pixelateTexture;
+    core::TextureUploader m_textureUploader {};
 };
 
 int main() {
@@ -0,0 +1,266 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ *
+ *
+ * The regex-based shader preprocessor which `core::ShaderProcesser`
+ *  replaced, kept here as the baseline of `preprocess_bench`.
+ */
+
+#pragma once
+#include <regex>
+#include <format>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "cabin/utils/console.h"
+
+namespace legacy {
+    class ShaderProcesser {
+    public:
+        struct Result {
+            std::string version {};
+            std::string vertex {};
+            std::string geometory {};
+            std::string fragment {};
+        };
+
+    public:
+        ShaderProcesser(const std::string& path) {
+            std::ifstream sourceFile(path);
+            if (!sourceFile.is_open())
+                throw std::runtime_error("failed to open shader file.");
+
+            m_sourceContent << sourceFile.rdbuf();
+            m_baseDirectory = std::filesystem::path(path).parent_path().string();
+            m_entryFileName = std::filesystem::path(path).filename().string();
+            m_blockFileStack = { std::format("{}/{}", m_baseDirectory, m_entryFileName) };
+        }
+
+        Result process() {
+            std::string versionStr = "#version ";
+            std::optional<size_t> versionMarker {};
+
+            std::string vertexBlock {}, geometoryBlock {}, fragmentBlock {};
+            std::optional<size_t> vertexMarker {}, geometoryMarker {}, fragmentMarker {};  
+
+
+            std::string line {};
+            size_t lineNumber = 0;
+            std::string* targetBlock = nullptr;
+
+            try {
+                while (std::getline(m_sourceContent, line)) {
+                    lineNumber += 1;
+
+                    if (isMacro(line)) {
+                        auto [name, param] = idMacro(line);
+                        
+                        if (name.empty()) {
+                            throw std::runtime_error("macro syntax error");
+                        }
+                        else if (name == "version") {
+                            if (versionMarker.has_value())
+                                throw std::runtime_error(std::format(
+                                "version re-decleration (v.s. line {})", versionMarker.value()
+                            ));
+                            
+                            if (param.empty())
+                                throw std::runtime_error("macro \"version\" requires a version string as parameter. (helps: \"#![version(\"...\")]\")");
+
+                            versionStr.append(param);
+                            versionMarker = lineNumber;
+                        }
+                        else if (name == "vertex") {
+                            if (vertexMarker.has_value())
+                                throw std::runtime_error(std::format(
+                                "vertex block re-decleration (v.s. line {})", vertexMarker.value()
+                            ));
+
+                            if (!param.empty())
+                                throw std::runtime_error("extra \"vertex\" macro parameter. (helps: \"#![vertex]\")");
+                            
+                            targetBlock = &vertexBlock;
+                            vertexMarker = lineNumber;
+                        }
+                        else if (name == "geometory") {
+                            if (geometoryMarker.has_value())
+                                throw std::runtime_error(std::format(
+                                "geometory block re-decleration (v.s. line {})", geometoryMarker.value()
+                            ));
+
+                            if (!param.empty())
+                                throw std::runtime_error("extra \"geometory\" macro parameter. (helps: \"#![geometory]\")");
+                            
+                            targetBlock = &geometoryBlock;
+                            geometoryMarker = lineNumber;
+                        }
+                        else if (name == "fragment") {
+                            if (fragmentMarker.has_value())
+                                throw std::runtime_error(std::format(
+                                "fragment block re-decleration (v.s. line {})", fragmentMarker.value()
+                            ));
+
+                            if (!param.empty())
+                                throw std::runtime_error("extra \"fragment\" macro parameter. (helps: \"#![fragment]\")");
+                            
+                            targetBlock = &fragmentBlock;
+                            fragmentMarker = lineNumber;
+                        }
+                        else {
+                            if (!targetBlock)
+                                throw std::runtime_error("out-block macro detected");
+
+                            targetBlock->append(line);
+                            targetBlock->append("\n");
+                        }
+                    }
+                    else if (targetBlock) {
+                        targetBlock->append(line);
+                        targetBlock->append("\n");
+                    }
+                }
+            } catch (const std::exception& e) {
+                throw std::runtime_error(std::format(
+                    "failed to parse shader \"{}\", at line {}: \n    \"{}\"\n  error: {}.",
+                    m_entryFileName, lineNumber, line, e.what()
+                ));
+            }
+            
+            Result processResult {};
+
+            if (versionMarker.has_value())
+                processResult.version = versionStr;
+            else
+                throw std::runtime_error("necessary \"version\" decleration is missing.");
+
+            m_blockFileStack.erase(m_blockFileStack.begin() + 1, m_blockFileStack.end());
+            if (vertexMarker.has_value())
+                processResult.vertex = processBlock(vertexBlock, m_entryFileName, vertexMarker.value());
+            else
+                throw std::runtime_error("necessary \"vertex\" block is missing.");
+
+            m_blockFileStack.erase(m_blockFileStack.begin() + 1, m_blockFileStack.end());
+            if (geometoryMarker.has_value())
+                processResult.geometory = processBlock(geometoryBlock, m_entryFileName, geometoryMarker.value());
+
+            m_blockFileStack.erase(m_blockFileStack.begin() + 1, m_blockFileStack.end());
+            if (fragmentMarker.has_value())
+                processResult.fragment = processBlock(fragmentBlock, m_entryFileName, fragmentMarker.value());
+            else
+                throw std::runtime_error("necessary \"fragment\" block is missing.");
+
+            return processResult;
+        }
+
+    private:
+        std::string processBlock(const std::string& raw, const std::string& fileName, size_t lineOffset) {
+            std::string result {};
+
+            std::stringstream rawStream {};
+            rawStream << raw;
+
+            std::string line {};
+            size_t lineNumber = lineOffset;
+
+            try {
+                while (std::getline(rawStream, line)) {
+                    lineNumber += 1;
+
+                    if (isMacro(line)) {
+                        auto [name, param] = idMacro(line);
+                        
+                        if (name.empty()) {
+                            throw std::runtime_error("macro syntax error");
+                        }
+                        else if (name == "use") {
+                            if (param.empty())
+                                throw std::runtime_error("macro \"use\" requires a path as parameter. (helps: \"#![use(\"...\")]\")");
+
+                            std::string absolutePath = std::format("{}/{}", m_baseDirectory, param);
+                            absolutePath = std::filesystem::absolute(absolutePath).string();
+
+                            // Prevent self-use
+                            if (absolutePath == std::filesystem::absolute(std::format("{}/{}", m_baseDirectory, fileName))) {
+                                throw std::runtime_error("self-use detected");
+                            }
+
+                            // Prevent multi-use
+                            if (std::find(m_blockFileStack.begin(), m_blockFileStack.end(), absolutePath) != m_blockFileStack.end()) {
+                                cabin::utils::Console::info(std::format("muti-use file detected in \"{}\", line {}; ignored.", fileName, lineNumber));\
+                                continue;
+                            }
+
+                            std::ifstream usedFile(absolutePath);
+                            if (!usedFile.is_open())
+                                throw std::runtime_error(std::format("failed to open used file: \"{}\"", param));
+
+                            std::stringstream usedStream {};
+                            usedStream << usedFile.rdbuf();
+
+                            m_blockFileStack.push_back(absolutePath);
+                            result.append(std::format("// ------------- BEGIN QUOTE, FROM {} -------------\n", param));
+                            result.append(processBlock(usedStream.str(), param, 0));
+                            result.append(std::format("// -------------  END QUOTE, FROM {} -------------\n", param));
+                        }
+                        else {
+                            for (auto& macro : std::vector<std::string> { "version", "vertex", "geometory", "fragment" }) {
+                                if (name == macro)
+                                    throw std::runtime_error(std::format("macro \"{}\" only allowed in entry shader", macro));
+                            }
+
+                            throw std::runtime_error(std::format("unrecognized macro \"{}\"", name));
+                        }
+                    }
+                    else {
+                        result.append(line);
+                        result.append("\n");
+                    }
+                }
+            } catch (const std::exception& e) {
+                throw std::runtime_error(std::format(
+                    "failed to parse shader block, in \"{}\", at line {}: \n    \"{}\"\n  error: {}",
+                    fileName, lineNumber, line, e.what()
+                ));
+            }
+
+            return result;
+        }
+
+        bool isMacro(const std::string& line) {
+            return std::regex_match(line, m_macroRe);
+        }
+
+        std::pair<std::string, std::string> idMacro(const std::string& line) {
+            std::smatch matchRes {};
+
+            if (std::regex_match(line, matchRes, m_hintMacroRe)) {
+                return std::make_pair(matchRes[1], "");
+            }
+            else if (std::regex_match(line, matchRes, m_declMacroRe)) {
+                return std::make_pair(matchRes[1], matchRes[2]);
+            }
+            else {
+                return std::make_pair("", "");
+            }
+        }
+
+    private:
+        std::stringstream m_sourceContent {};
+        std::string m_baseDirectory {};
+        std::string m_entryFileName {};
+
+        std::vector<std::string> m_blockFileStack {};
+
+        std::regex m_macroRe { R"(^\s*#![\S\s]*$)" }; 
+        std::regex m_hintMacroRe { R"(^\s*#!\[\s*(\w+)\s*\]$)" };
+        std::regex m_declMacroRe { R"(^\s*#!\[\s*(\w+)\s*\(\s*\"([\w\s\.\\//]*)\"\s*\)\s*\]$)"};
+    };
+}
@@ -0,0 +1,130 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ *
+ *
+ * `Preprocess Bench` measures `core::ShaderProcesser` against the
+ *  former regex-based preprocessor, by preprocessing the bundled
+ *  hello_pbr shaders many times. The scanner is measured both with
+ *  a cold and a warm include cache, and against loading the same
+ *  shaders from bundles.
+ *
+ *  Usage: `xmake run preprocess_bench [iterations]`
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <filesystem>
+
+#include "cabin/utils/console.h"
+#include "cabin/core/shaderprocesser.h"
+#include "legacy_processer.h"
+using namespace cabin;
+
+// Shaders using `#![feature]` or `#![compute]` are left out,
+// since the former preprocessor doesn't know these macros.
+static const std::vector<std::string> shaderPaths = {
+    "hello_pbr/et2cube.shader",
+    "hello_pbr/irradiance.shader",
+    "hello_pbr/prefilter.shader",
+    "hello_pbr/shapePBR.shader",
+    "hello_pbr/skybox.shader"
+};
+
+template <typename Processer>
+std::string processAll(const std::vector<std::string>& paths = shaderPaths) {
+    std::string output {};
+    for (auto& path : paths) {
+        auto result = Processer(path).process();
+        output.append(result.version);
+        output.append(result.vertex);
+        output.append(result.geometory);
+        output.append(result.fragment);
+    }
+    return output;
+}
+
+template <typename Processer>
+double measure(int iterations, bool coldCache = false, const std::vector<std::string>& paths = shaderPaths) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        if (coldCache)
+            core::ShaderProcesser::clearCache();
+        processAll<Processer>(paths);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    if (iterations <= 0) {
+        utils::Console::error("iterations should be a positive number.");
+        return EXIT_FAILURE;
+    }
+
+    try {
+        // Both preprocessors should produce identical stages.
+        if (processAll<legacy::ShaderProcesser>() != processAll<core::ShaderProcesser>()) {
+            utils::Console::error("preprocessed sources mismatch!");
+            return EXIT_FAILURE;
+        }
+
+        // The include cache is shared, concurrent builds should produce identical stages as well.
+        std::string expected = processAll<core::ShaderProcesser>();
+        std::vector<std::string> outputs (std::thread::hardware_concurrency() > 1 ? 4 : 1);
+        {
+            std::vector<std::jthread> workers {};
+            for (auto& output : outputs)
+                workers.emplace_back([&output] { output = processAll<core::ShaderProcesser>(); });
+        }
+        for (auto& output : outputs) {
+            if (output != expected) {
+                utils::Console::error("preprocessed sources mismatch between threads!");
+                return EXIT_FAILURE;
+            }
+        }
+
+        double legacyTime = measure<legacy::ShaderProcesser>(iterations);
+        double coldTime = measure<core::ShaderProcesser>(iterations, true);
+
+        core::ShaderProcesser::clearCache();
+        double warmTime = measure<core::ShaderProcesser>(iterations);
+        auto statistics = core::ShaderProcesser::getCacheStatistics();
+
+        // Bundles hold the flattened stages, as written by `cabin-shaderc`.
+        std::vector<std::string> bundlePaths {};
+        for (auto& path : shaderPaths) {
+            std::string bundlePath = std::format(".cache/preprocess_bench/{}.shaderbundle", std::filesystem::path(path).stem().string());
+            core::ShaderProcesser::saveBundle(core::ShaderProcesser(path).process(), bundlePath);
+            bundlePaths.push_back(bundlePath);
+        }
+
+        if (processAll<core::ShaderProcesser>(bundlePaths) != expected) {
+            utils::Console::error("bundled sources mismatch!");
+            return EXIT_FAILURE;
+        }
+        double bundleTime = measure<core::ShaderProcesser>(iterations, false, bundlePaths);
+
+        utils::Console::info(std::format("{} shaders x {} iterations", shaderPaths.size(), iterations));
+        utils::Console::info(std::format("regex:          {:.2f} ms ({:.3f} ms/iteration)", legacyTime, legacyTime / iterations));
+        utils::Console::info(std::format("scanner (cold): {:.2f} ms ({:.3f} ms/iteration)", coldTime, coldTime / iterations));
+        utils::Console::info(std::format("scanner (warm): {:.2f} ms ({:.3f} ms/iteration)", warmTime, warmTime / iterations));
+        utils::Console::info(std::format("bundle:         {:.2f} ms ({:.3f} ms/iteration)", bundleTime, bundleTime / iterations));
+        utils::Console::info(std::format("speedup: {:.2f}x (cold), {:.2f}x (warm), {:.2f}x (bundle)",
+                                         legacyTime / coldTime, legacyTime / warmTime, legacyTime / bundleTime));
+        utils::Console::info(std::format("include cache: {} hits, {} misses, {} files",
+                                         statistics.hits, statistics.misses, statistics.files));
+    } catch (const std::exception& e) {
+        utils::Console::error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
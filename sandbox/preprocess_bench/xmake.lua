@@ -0,0 +1,3 @@
+target("preprocess_bench")
+    set_kind("binary")
+    add_files("main.cc")
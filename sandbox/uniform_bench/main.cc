@@ -0,0 +1,181 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ *
+ *
+ * `Uniform Bench` is a micro-benchmark comparing the uniform
+ *  setting paths of `core::Shader`:
+ *
+ *   - Legacy: `glGetUniformLocation` with a `std::string` per call.
+ *   - Name:   cached location looked up by `std::string_view`.
+ *   - Handle: location resolved once by `Shader::getUniform`.
+ *
+ *  Uniforms are the samplers and layers `utils::Model::draw` sets on
+ *  the variant of `modelPBR.shader` with all material textures.
+ *  Name and Handle set the same values every draw, so their uploads
+ *  are skipped by the uniform shadow. Changing switches layers every
+ *  draw like primitives of a model, which measures the uploads.
+ */
+
+#include <chrono>
+#include <string>
+#include <format>
+#include <vector>
+#include <functional>
+
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <imgui.h>
+
+#include "cabin/sandbox.h"
+#include "cabin/core/shader.h"
+using namespace cabin;
+
+// Number of simulated primitive draws per run.
+const int BENCH_ITERATIONS = 100000;
+
+class UniformBench: public Sandbox {
+public:
+    UniformBench() : Sandbox("Uniform Bench", 640, 360) {
+        m_shader = core::Shader::Builder()
+                        .fromFile("hello_pbr/modelPBR.shader")
+                        .build();
+
+        enableImGui();
+        ImGui::GetIO().IniFilename = nullptr;
+
+        runBenchmark();
+    }
+
+    void runBenchmark() {
+        // Same uniforms as `utils::Model::draw` sets per primitive with all material textures.
+        // Material factors are compiled out of this variant, so only samplers and layers are active.
+        uint32_t featureMask = m_shader.getFeature("BASE_COLOR_TEXTURE").mask |
+                               m_shader.getFeature("METALLIC_ROUGHNESS_TEXTURE").mask |
+                               m_shader.getFeature("NORMAL_TEXTURE").mask |
+                               m_shader.getFeature("OCCLUSION_TEXTURE").mask;
+        const core::Shader& shader = m_shader.getVariant(featureMask);
+
+        GLuint program = shader.id.value();
+        shader.bind();
+
+        auto legacySetInt = [&](const std::string& name, int value) {
+            glUniform1i(glGetUniformLocation(program, name.c_str()), value);
+        };
+
+        core::Shader::Uniform baseColorTexture = shader.getUniform("baseColorTexture");
+        core::Shader::Uniform baseColorLayer = shader.getUniform("baseColorLayer");
+        core::Shader::Uniform metallicRoughnessTexture = shader.getUniform("metallicRoughnessTexture");
+        core::Shader::Uniform metallicRoughnessLayer = shader.getUniform("metallicRoughnessLayer");
+        core::Shader::Uniform normalTexture = shader.getUniform("normalTexture");
+        core::Shader::Uniform normalLayer = shader.getUniform("normalLayer");
+        core::Shader::Uniform occlusionTexture = shader.getUniform("occlusionTexture");
+        core::Shader::Uniform occlusionLayer = shader.getUniform("occlusionLayer");
+
+        auto measure = [](const std::function<void(int)>& body, core::Shader::UniformStatistics* statistics = nullptr) {
+            glFinish();
+            core::Shader::resetUniformStatistics();
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < BENCH_ITERATIONS; i++)
+                body(i);
+            glFinish();
+            auto end = std::chrono::steady_clock::now();
+            if (statistics)
+                *statistics = core::Shader::getUniformStatistics();
+            return std::chrono::duration<double, std::milli>(end - begin).count();
+        };
+
+        m_legacyTime = measure([&](int) {
+            legacySetInt("baseColorTexture", 0);
+            legacySetInt("baseColorLayer", 0);
+            legacySetInt("metallicRoughnessTexture", 1);
+            legacySetInt("metallicRoughnessLayer", 1);
+            legacySetInt("normalTexture", 2);
+            legacySetInt("normalLayer", 2);
+            legacySetInt("occlusionTexture", 4);
+            legacySetInt("occlusionLayer", 4);
+        });
+
+        m_nameTime = measure([&](int) {
+            shader.setInt("baseColorTexture", 0);
+            shader.setInt("baseColorLayer", 0);
+            shader.setInt("metallicRoughnessTexture", 1);
+            shader.setInt("metallicRoughnessLayer", 1);
+            shader.setInt("normalTexture", 2);
+            shader.setInt("normalLayer", 2);
+            shader.setInt("occlusionTexture", 4);
+            shader.setInt("occlusionLayer", 4);
+        });
+
+        m_handleTime = measure([&](int) {
+            shader.setInt(baseColorTexture, 0);
+            shader.setInt(baseColorLayer, 0);
+            shader.setInt(metallicRoughnessTexture, 1);
+            shader.setInt(metallicRoughnessLayer, 1);
+            shader.setInt(normalTexture, 2);
+            shader.setInt(normalLayer, 2);
+            shader.setInt(occlusionTexture, 4);
+            shader.setInt(occlusionLayer, 4);
+        }, &m_handleStatistics);
+
+        // Layers change per primitive, while samplers keep their units, as in `utils::Model::draw`.
+        m_changingTime = measure([&](int i) {
+            int layer = i % 16;
+            shader.setInt(baseColorTexture, 0);
+            shader.setInt(baseColorLayer, layer);
+            shader.setInt(metallicRoughnessTexture, 1);
+            shader.setInt(metallicRoughnessLayer, layer);
+            shader.setInt(normalTexture, 2);
+            shader.setInt(normalLayer, layer);
+            shader.setInt(occlusionTexture, 4);
+            shader.setInt(occlusionLayer, layer);
+        }, &m_changingStatistics);
+
+        utils::Console::info(std::format("legacy: {:.2f} ms, name: {:.2f} ms ({:.2f}x), handle: {:.2f} ms ({:.2f}x), changing: {:.2f} ms ({:.2f}x)",
+                                         m_legacyTime, m_nameTime, m_legacyTime / m_nameTime,
+                                         m_handleTime, m_legacyTime / m_handleTime,
+                                         m_changingTime, m_legacyTime / m_changingTime));
+        utils::Console::info(std::format("handle: {} uploads, {} skips; changing: {} uploads, {} skips",
+                                         m_handleStatistics.uploads, m_handleStatistics.skips,
+                                         m_changingStatistics.uploads, m_changingStatistics.skips));
+    }
+
+    void renderFrame() override {
+        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    void interfaceFrame() override {
+        if (ImGui::Begin("Uniform Bench")) {
+            ImGui::Text("%d primitives, 8 uniforms each (all material textures)", BENCH_ITERATIONS);
+
+            ImGui::SeparatorText("Results");
+            ImGui::BulletText("Legacy: %.2f ms", m_legacyTime);
+            ImGui::BulletText("Name:   %.2f ms (%.2fx)", m_nameTime, m_legacyTime / m_nameTime);
+            ImGui::BulletText("Handle: %.2f ms (%.2fx)", m_handleTime, m_legacyTime / m_handleTime);
+            ImGui::BulletText("Changing: %.2f ms (%.2fx)", m_changingTime, m_legacyTime / m_changingTime);
+
+            ImGui::SeparatorText("Uploads");
+            ImGui::BulletText("Handle: %zu issued, %zu skipped", m_handleStatistics.uploads, m_handleStatistics.skips);
+            ImGui::BulletText("Changing: %zu issued, %zu skipped", m_changingStatistics.uploads, m_changingStatistics.skips);
+
+            if (ImGui::Button("Run Again"))
+                runBenchmark();
+        }
+        ImGui::End();
+    }
+
+private:
+    double m_legacyTime {}, m_nameTime {}, m_handleTime {}, m_changingTime {};
+    core::Shader::UniformStatistics m_handleStatistics {}, m_changingStatistics {};
+    core::Shader m_shader {};
+};
+
+int main() {
+    return SandboxApp<UniformBench>::run();
+}
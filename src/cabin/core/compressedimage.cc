@@ -0,0 +1,621 @@
+#include "compressedimage.h"
+
+#include <cmath>
+#include <array>
+#include <format>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#include "cabin/utils/threadpool.h"
+
+namespace {
+    using namespace cabin;
+
+    struct FormatInfo {
+        GLenum format;
+        uint32_t vkFormat;
+        uint32_t colorModel;    // `KHR_DF_MODEL_*` of the data format descriptor
+        bool isSrgb;
+        GLsizei blockSize;
+    };
+
+    constexpr uint32_t MODEL_BC1 = 128, MODEL_BC3 = 130, MODEL_BC4 = 131,
+                       MODEL_BC5 = 132, MODEL_BC6H = 133, MODEL_BC7 = 134;
+
+    constexpr FormatInfo FORMAT_INFOS[] = {
+        { GL_COMPRESSED_RGB_S3TC_DXT1_EXT,        131, MODEL_BC1,  false, 8  },
+        { GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,       132, MODEL_BC1,  true,  8  },
+        { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,       133, MODEL_BC1,  false, 8  },
+        { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 134, MODEL_BC1,  true,  8  },
+        { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,       137, MODEL_BC3,  false, 16 },
+        { GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 138, MODEL_BC3,  true,  16 },
+        { GL_COMPRESSED_RED_RGTC1,                139, MODEL_BC4,  false, 8  },
+        { GL_COMPRESSED_SIGNED_RED_RGTC1,         140, MODEL_BC4,  false, 8  },
+        { GL_COMPRESSED_RG_RGTC2,                 141, MODEL_BC5,  false, 16 },
+        { GL_COMPRESSED_SIGNED_RG_RGTC2,          142, MODEL_BC5,  false, 16 },
+        { GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,  143, MODEL_BC6H, false, 16 },
+        { GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,    144, MODEL_BC6H, false, 16 },
+        { GL_COMPRESSED_RGBA_BPTC_UNORM,          145, MODEL_BC7,  false, 16 },
+        { GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,    146, MODEL_BC7,  true,  16 },
+    };
+
+    const FormatInfo* findFormat(GLenum format) {
+        for (const auto& info : FORMAT_INFOS) {
+            if (info.format == format)
+                return &info;
+        }
+        return nullptr;
+    }
+
+    const FormatInfo* findVkFormat(uint32_t vkFormat) {
+        for (const auto& info : FORMAT_INFOS) {
+            if (info.vkFormat == vkFormat)
+                return &info;
+        }
+        return nullptr;
+    }
+
+    bool isSignedFormat(const FormatInfo& info) {
+        return info.vkFormat == 140 || info.vkFormat == 142 || info.vkFormat == 144;
+    }
+
+    /* ---------------- KTX2 Container ---------------- */
+
+    constexpr unsigned char KTX2_IDENTIFIER[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+    };
+
+    // Fields are little-endian, as the hosts cabin runs on.
+    struct KTX2Header {
+        unsigned char identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth, pixelHeight, pixelDepth;
+        uint32_t layerCount, faceCount, levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset, dfdByteLength;
+        uint32_t kvdByteOffset, kvdByteLength;
+        uint64_t sgdByteOffset, sgdByteLength;
+    };
+    static_assert(sizeof(KTX2Header) == 80);
+
+    struct KTX2Level {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    size_t getLevelSize(GLsizei width, GLsizei height, size_t level, GLsizei blockSize) {
+        size_t levelWidth = std::max<size_t>(static_cast<size_t>(width) >> level, 1);
+        size_t levelHeight = std::max<size_t>(static_cast<size_t>(height) >> level, 1);
+        return (levelWidth + 3) / 4 * ((levelHeight + 3) / 4) * blockSize;
+    }
+
+    //! Build the basic data format descriptor, which KTX2 requires besides `vkFormat`.
+    std::vector<uint32_t> buildDataFormatDescriptor(const FormatInfo& info) {
+        struct Sample { uint32_t bitOffset, bitLength, channel; };
+
+        std::vector<Sample> samples {};
+        if (info.colorModel == MODEL_BC3)
+            samples = { { 0, 64, 15 }, { 64, 64, 0 } };     // alpha block, then color block
+        else if (info.colorModel == MODEL_BC5)
+            samples = { { 0, 64, 0 }, { 64, 64, 1 } };      // red block, then green block
+        else
+            samples = { { 0, info.blockSize * 8u, 0 } };
+
+        bool isFloat = info.colorModel == MODEL_BC6H;
+        bool isSigned = isSignedFormat(info);
+        uint32_t qualifiers = (isFloat ? 0x80 : 0) | (isSigned ? 0x40 : 0);
+
+        uint32_t lower = 0, upper = 0xFFFFFFFF;
+        if (isFloat) {
+            lower = isSigned ? 0xBF800000 : 0;
+            upper = 0x3F800000;
+        } else if (isSigned) {
+            lower = 0x80000000;
+            upper = 0x7FFFFFFF;
+        }
+
+        uint32_t blockBytes = 24 + 16 * static_cast<uint32_t>(samples.size());
+        std::vector<uint32_t> dfd {
+            4 + blockBytes,
+            0,                                                  // vendor: Khronos, type: basic
+            2 | (blockBytes << 16),                             // version 1.3
+            info.colorModel | (1u << 8) | ((info.isSrgb ? 2u : 1u) << 16),  // BT.709 primaries, transfer
+            3 | (3u << 8),                                      // 4x4 texel blocks
+            static_cast<uint32_t>(info.blockSize), 0,           // bytes of plane 0
+        };
+        for (const auto& sample : samples) {
+            dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | ((sample.channel | qualifiers) << 24));
+            dfd.push_back(0);
+            dfd.push_back(lower);
+            dfd.push_back(upper);
+        }
+        return dfd;
+    }
+
+    /* ---------------- BCn Encoder ---------------- */
+
+    using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+    //! Gather a 4x4 block of RGBA texels, clamping at the right and bottom edges.
+    void gatherBlock(const uint8_t* texels, GLsizei width, GLsizei height, GLsizei blockX, GLsizei blockY, Block& block) {
+        for (GLsizei y = 0; y < 4; y++) {
+            GLsizei srcY = std::min(blockY * 4 + y, height - 1);
+            for (GLsizei x = 0; x < 4; x++) {
+                GLsizei srcX = std::min(blockX * 4 + x, width - 1);
+                std::memcpy(block[y * 4 + x].data(), texels + (static_cast<size_t>(srcY) * width + srcX) * 4, 4);
+            }
+        }
+    }
+
+    uint16_t packColor565(const float color[3]) {
+        auto quantize = [](float value, int maxValue) {
+            return static_cast<uint16_t>(std::clamp(static_cast<int>(std::lround(value * maxValue / 255.0f)), 0, maxValue));
+        };
+        return static_cast<uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+    }
+
+    void unpackColor565(uint16_t packed, int color[3]) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    void writeLittleEndian(std::byte* out, uint64_t value, int byteCount) {
+        for (int i = 0; i < byteCount; i++)
+            out[i] = static_cast<std::byte>((value >> (i * 8)) & 0xFF);
+    }
+
+    //! Encode a BC1 color block, fitting the endpoints along the principal axis of the colors.
+    void encodeColorBlock(const Block& block, std::byte* out) {
+        float mean[3] {};
+        for (const auto& texel : block) {
+            for (int c = 0; c < 3; c++)
+                mean[c] += texel[c] / 16.0f;
+        }
+
+        float covariance[6] {};     // xx, xy, xz, yy, yz, zz
+        for (const auto& texel : block) {
+            float d[3] = { texel[0] - mean[0], texel[1] - mean[1], texel[2] - mean[2] };
+            covariance[0] += d[0] * d[0]; covariance[1] += d[0] * d[1]; covariance[2] += d[0] * d[2];
+            covariance[3] += d[1] * d[1]; covariance[4] += d[1] * d[2]; covariance[5] += d[2] * d[2];
+        }
+
+        // Power iteration converges to the principal axis within a few steps.
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int i = 0; i < 8; i++) {
+            float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2],
+            };
+            float length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < 3; c++)
+                axis[c] = next[c] / length;
+        }
+        float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (int c = 0; c < 3; c++)
+            axis[c] /= axisLength;
+
+        float minProjection = 0.0f, maxProjection = 0.0f;
+        for (const auto& texel : block) {
+            float projection = (texel[0] - mean[0]) * axis[0] + (texel[1] - mean[1]) * axis[1] + (texel[2] - mean[2]) * axis[2];
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        float endpoint0[3], endpoint1[3];
+        for (int c = 0; c < 3; c++) {
+            endpoint0[c] = mean[c] + axis[c] * maxProjection;
+            endpoint1[c] = mean[c] + axis[c] * minProjection;
+        }
+
+        // The 4-color mode requires color0 > color1.
+        uint16_t color0 = packColor565(endpoint0), color1 = packColor565(endpoint1);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            int palette[4][3];
+            unpackColor565(color0, palette[0]);
+            unpackColor565(color1, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; i++) {
+                int bestIndex = 0, bestDistance = INT32_MAX;
+                for (int p = 0; p < 4; p++) {
+                    int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+            }
+        }
+
+        writeLittleEndian(out, color0, 2);
+        writeLittleEndian(out + 2, color1, 2);
+        writeLittleEndian(out + 4, indices, 4);
+    }
+
+    //! Encode a BC4 block of a single channel, with the 8-value interpolation mode.
+    void encodeChannelBlock(const Block& block, int channel, std::byte* out) {
+        int minValue = 255, maxValue = 0;
+        for (const auto& texel : block) {
+            minValue = std::min<int>(minValue, texel[channel]);
+            maxValue = std::max<int>(maxValue, texel[channel]);
+        }
+
+        uint64_t indices = 0;
+        if (maxValue != minValue) {
+            // Steps from value0 (max) to value1 (min), and their indices in the block.
+            constexpr uint64_t STEP_INDICES[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+            for (int i = 0; i < 16; i++) {
+                int step = static_cast<int>(std::lround((maxValue - block[i][channel]) * 7.0f / (maxValue - minValue)));
+                indices |= STEP_INDICES[step] << (i * 3);
+            }
+        }
+
+        writeLittleEndian(out, static_cast<uint64_t>(maxValue), 1);
+        writeLittleEndian(out + 1, static_cast<uint64_t>(minValue), 1);
+        writeLittleEndian(out + 2, indices, 6);
+    }
+
+    /* ---------------- BCn Decoder ---------------- */
+
+    uint64_t readLittleEndian(const std::byte* in, int byteCount) {
+        uint64_t value = 0;
+        for (int i = 0; i < byteCount; i++)
+            value |= static_cast<uint64_t>(in[i]) << (i * 8);
+        return value;
+    }
+
+    //! Decode a BC1 color block, `hasAlpha` enables the transparent black of the 3-color mode.
+    void decodeColorBlock(const std::byte* in, bool isBC1, bool hasAlpha, Block& block) {
+        auto color0 = static_cast<uint16_t>(readLittleEndian(in, 2));
+        auto color1 = static_cast<uint16_t>(readLittleEndian(in + 2, 2));
+        auto indices = static_cast<uint32_t>(readLittleEndian(in + 4, 4));
+
+        int palette[4][4];
+        unpackColor565(color0, palette[0]);
+        unpackColor565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+        // BC3 color blocks always use the 4-color mode.
+        if (!isBC1 || color0 > color1) {
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+        } else {
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            palette[3][3] = hasAlpha ? 0 : 255;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            const int* color = palette[(indices >> (i * 2)) & 3];
+            for (int c = 0; c < 4; c++)
+                block[i][c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+
+    //! Decode a BC4 block into a single channel.
+    void decodeChannelBlock(const std::byte* in, int channel, Block& block) {
+        int value0 = static_cast<int>(readLittleEndian(in, 1));
+        int value1 = static_cast<int>(readLittleEndian(in + 1, 1));
+        uint64_t indices = readLittleEndian(in + 2, 6);
+
+        int palette[8] = { value0, value1 };
+        if (value0 > value1) {
+            for (int i = 1; i < 7; i++)
+                palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+        } else {
+            for (int i = 1; i < 5; i++)
+                palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        for (int i = 0; i < 16; i++)
+            block[i][channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+    }
+
+    bool hasExtension(const char* name) {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+        for (GLint i = 0; i < extensionCount; i++) {
+            auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+namespace cabin::core {
+
+    CompressedImage CompressedImage::loadKTX2(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            throw std::runtime_error(std::format("failed to open KTX2 file: {}", path));
+
+        std::vector<std::byte> content(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(content.data()), content.size());
+
+        KTX2Header header {};
+        if (!file || content.size() < sizeof(header))
+            throw std::runtime_error(std::format("broken KTX2 file: {}", path));
+        std::memcpy(&header, content.data(), sizeof(header));
+
+        if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+            throw std::runtime_error(std::format("not a KTX2 file: {}", path));
+
+        const FormatInfo* info = findVkFormat(header.vkFormat);
+        if (!info)
+            throw std::runtime_error(std::format("KTX2 file has an unsupported format ({}): {}", header.vkFormat, path));
+
+        if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 ||
+            header.layerCount > 1 || header.faceCount != 1)
+            throw std::runtime_error(std::format("KTX2 file isn't a 2D image: {}", path));
+
+        if (header.supercompressionScheme != 0)
+            throw std::runtime_error(std::format("KTX2 file is supercompressed: {}", path));
+
+        size_t levelCount = std::max<uint32_t>(header.levelCount, 1);
+        if (content.size() < sizeof(header) + levelCount * sizeof(KTX2Level))
+            throw std::runtime_error(std::format("broken KTX2 file: {}", path));
+
+        CompressedImage image {};
+        image.format = info->format;
+        image.width = static_cast<GLsizei>(header.pixelWidth);
+        image.height = static_cast<GLsizei>(header.pixelHeight);
+
+        for (size_t i = 0; i < levelCount; i++) {
+            KTX2Level level {};
+            std::memcpy(&level, content.data() + sizeof(header) + i * sizeof(KTX2Level), sizeof(level));
+
+            size_t levelSize = getLevelSize(image.width, image.height, i, info->blockSize);
+            if (level.byteLength != levelSize || level.byteOffset > content.size() ||
+                content.size() - level.byteOffset < level.byteLength)
+                throw std::runtime_error(std::format("broken KTX2 file: {}", path));
+
+            auto levelData = content.begin() + static_cast<ptrdiff_t>(level.byteOffset);
+            image.levels.emplace_back(levelData, levelData + static_cast<ptrdiff_t>(levelSize));
+        }
+
+        return image;
+    }
+
+    void CompressedImage::saveKTX2(const std::string& path) const {
+        const FormatInfo* info = findFormat(format);
+        if (!info || levels.empty())
+            throw std::runtime_error(std::format("failed to save KTX2 file with format 0x{:x}: {}", format, path));
+
+        std::vector<uint32_t> dfd = buildDataFormatDescriptor(*info);
+
+        KTX2Header header {};
+        std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+        header.vkFormat = info->vkFormat;
+        header.typeSize = 1;
+        header.pixelWidth = static_cast<uint32_t>(width);
+        header.pixelHeight = static_cast<uint32_t>(height);
+        header.faceCount = 1;
+        header.levelCount = static_cast<uint32_t>(levels.size());
+        header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levels.size() * sizeof(KTX2Level));
+        header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+        // Levels are stored from the smallest one, each aligned to the block size.
+        std::vector<KTX2Level> levelIndex(levels.size());
+        size_t offset = header.dfdByteOffset + header.dfdByteLength;
+        for (size_t i = levels.size(); i-- > 0;) {
+            offset = (offset + info->blockSize - 1) / info->blockSize * info->blockSize;
+            levelIndex[i] = KTX2Level { offset, levels[i].size(), levels[i].size() };
+            offset += levels[i].size();
+        }
+
+        std::vector<std::byte> content(offset);
+        std::memcpy(content.data(), &header, sizeof(header));
+        std::memcpy(content.data() + sizeof(header), levelIndex.data(), levelIndex.size() * sizeof(KTX2Level));
+        std::memcpy(content.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+        for (size_t i = 0; i < levels.size(); i++)
+            std::memcpy(content.data() + levelIndex[i].byteOffset, levels[i].data(), levels[i].size());
+
+        // Write into a temporary file first, so that a broken write never leaves a truncated image.
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(content.data()), content.size());
+            if (!file.good())
+                throw std::runtime_error(std::format("failed to write KTX2 file: {}", path));
+        }
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+            throw std::runtime_error(std::format("failed to write KTX2 file: {}", path));
+    }
+
+    CompressedImage CompressedImage::encode(const Texture::Image& image, GLenum format, GLsizei levels) {
+        if (image.compType != GL_UNSIGNED_BYTE)
+            throw std::runtime_error("only 8-bit images can be encoded to BCn formats");
+
+        const FormatInfo* info = findFormat(format);
+        bool isSrgb = info && info->isSrgb;
+        return encode(MipmapChain::generate(image, levels, isSrgb), format);
+    }
+
+    CompressedImage CompressedImage::encode(const MipmapChain& chain, GLenum format) {
+        const FormatInfo* info = findFormat(format);
+        bool isEncodable = info && !isSignedFormat(*info) &&
+                           (info->colorModel == MODEL_BC1 || info->colorModel == MODEL_BC3 ||
+                            info->colorModel == MODEL_BC4 || info->colorModel == MODEL_BC5);
+        if (!isEncodable)
+            throw std::runtime_error(std::format("format 0x{:x} can't be encoded on the CPU", format));
+
+        if (chain.levels.empty())
+            throw std::runtime_error("mipmap chain has no level to encode");
+
+        CompressedImage result {};
+        result.format = format;
+        result.width = chain.levels.front().width;
+        result.height = chain.levels.front().height;
+
+        for (const auto& image : chain.levels) {
+            if (image.compType != GL_UNSIGNED_BYTE)
+                throw std::runtime_error("only 8-bit images can be encoded to BCn formats");
+
+            int compCount;
+            switch (image.srcFormat) {
+                case GL_RED:  compCount = 1; break;
+                case GL_RG:   compCount = 2; break;
+                case GL_RGB:  compCount = 3; break;
+                case GL_RGBA: compCount = 4; break;
+                default:
+                    throw std::runtime_error(std::format("unsupported image format for encoding: 0x{:x}", image.srcFormat));
+            }
+
+            // Expand to RGBA, so that all formats gather blocks the same way.
+            GLsizei width = image.width, height = image.height;
+            auto pixels = static_cast<const uint8_t*>(image.pixels.get());
+            std::vector<uint8_t> texels(static_cast<size_t>(width) * height * 4);
+            for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+                uint8_t texel[4] = { 0, 0, 0, 255 };
+                std::memcpy(texel, pixels + i * compCount, compCount);
+                std::memcpy(texels.data() + i * 4, texel, 4);
+            }
+
+            GLsizei blockCountX = (width + 3) / 4, blockCountY = (height + 3) / 4;
+            std::vector<std::byte>& data = result.levels.emplace_back(
+                static_cast<size_t>(blockCountX) * blockCountY * info->blockSize);
+
+            utils::ThreadPool::getShared().parallelFor(blockCountY, [&](size_t begin, size_t end) {
+                Block block {};
+                for (size_t blockY = begin; blockY < end; blockY++) {
+                    for (GLsizei blockX = 0; blockX < blockCountX; blockX++) {
+                        gatherBlock(texels.data(), width, height, blockX, static_cast<GLsizei>(blockY), block);
+                        std::byte* out = data.data() + (blockY * blockCountX + blockX) * info->blockSize;
+
+                        if (info->colorModel == MODEL_BC1) {
+                            encodeColorBlock(block, out);
+                        } else if (info->colorModel == MODEL_BC3) {
+                            encodeChannelBlock(block, 3, out);
+                            encodeColorBlock(block, out + 8);
+                        } else if (info->colorModel == MODEL_BC4) {
+                            encodeChannelBlock(block, 0, out);
+                        } else {
+                            encodeChannelBlock(block, 0, out);
+                            encodeChannelBlock(block, 1, out + 8);
+                        }
+                    }
+                }
+            });
+        }
+
+        return result;
+    }
+
+    MipmapChain CompressedImage::decode() const {
+        const FormatInfo* info = findFormat(format);
+        if (!info || (info->colorModel != MODEL_BC1 && info->colorModel != MODEL_BC3))
+            throw std::runtime_error(std::format("format 0x{:x} can't be decoded on the CPU", format));
+
+        bool hasAlpha = format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT && format != GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+
+        MipmapChain result {};
+        for (GLsizei level = 0; level < static_cast<GLsizei>(levels.size()); level++) {
+            GLsizei width = std::max(this->width >> level, 1), height = std::max(this->height >> level, 1);
+            GLsizei blockCountX = (width + 3) / 4, blockCountY = (height + 3) / 4;
+
+            const std::vector<std::byte>& data = levels[level];
+            if (data.size() < static_cast<size_t>(blockCountX) * blockCountY * info->blockSize)
+                throw std::runtime_error(std::format("level {} of compressed image is truncated", level));
+
+            auto texels = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(width) * height * 4);
+
+            utils::ThreadPool::getShared().parallelFor(blockCountY, [&](size_t begin, size_t end) {
+                Block block {};
+                for (size_t blockY = begin; blockY < end; blockY++) {
+                    for (GLsizei blockX = 0; blockX < blockCountX; blockX++) {
+                        const std::byte* in = data.data() + (blockY * blockCountX + blockX) * info->blockSize;
+                        if (info->colorModel == MODEL_BC1) {
+                            decodeColorBlock(in, true, hasAlpha, block);
+                        } else {
+                            decodeColorBlock(in + 8, false, false, block);
+                            decodeChannelBlock(in, 3, block);
+                        }
+
+                        // Texels of edge blocks beyond the image are dropped.
+                        for (GLsizei y = 0; y < 4 && blockY * 4 + y < static_cast<size_t>(height); y++) {
+                            for (GLsizei x = 0; x < 4 && blockX * 4 + x < width; x++) {
+                                size_t texel = (blockY * 4 + y) * width + blockX * 4 + x;
+                                std::memcpy(texels->data() + texel * 4, block[y * 4 + x].data(), 4);
+                            }
+                        }
+                    }
+                }
+            });
+
+            Texture::Image& image = result.levels.emplace_back();
+            image.pixels = std::shared_ptr<void>(texels, texels->data());
+            image.width = width;
+            image.height = height;
+            image.srcFormat = GL_RGBA;
+            image.compType = GL_UNSIGNED_BYTE;
+        }
+
+        return result;
+    }
+
+    GLenum CompressedImage::getDecodedFormat() const {
+        const FormatInfo* info = findFormat(format);
+        return info && info->isSrgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    }
+
+    bool CompressedImage::isSupported(GLenum format) {
+        const FormatInfo* info = findFormat(format);
+        if (!info)
+            return false;
+        if (info->colorModel != MODEL_BC1 && info->colorModel != MODEL_BC3)
+            return true;
+
+        static const bool hasS3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+        static const bool hasSrgbS3tc = hasS3tc && (hasExtension("GL_EXT_texture_sRGB") ||
+                                                    hasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+        return info->isSrgb ? hasSrgbS3tc : hasS3tc;
+    }
+
+    GLsizei CompressedImage::getBlockSize(GLenum format) {
+        const FormatInfo* info = findFormat(format);
+        if (!info)
+            throw std::runtime_error(std::format("0x{:x} isn't a BCn format", format));
+        return info->blockSize;
+    }
+
+    size_t CompressedImage::getSize() const {
+        size_t size = 0;
+        for (const auto& level : levels)
+            size += level.size();
+        return size;
+    }
+}
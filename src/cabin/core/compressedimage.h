@@ -0,0 +1,111 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "cabin/core/texture.h"
+#include "cabin/core/mipmapchain.h"
+
+// S3TC formats are an extension of the desktop GL specification.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT        0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT       0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT       0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT       0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace cabin::core {
+
+    /** Block-Compressed Image
+     *
+     * --------------------------
+     * `CompressedImage` holds the mipmap levels of an image in one of
+     *  the BCn formats, which are sampled by the GPU without being
+     *  decompressed, in 4 (BC1, BC4) or 8 (others) bits per texel:
+     *
+     *   - BC1: `GL_COMPRESSED_RGB_S3TC_DXT1_EXT` (`SRGB` and `RGBA` variants)
+     *   - BC3: `GL_COMPRESSED_RGBA_S3TC_DXT5_EXT` (`SRGB_ALPHA` variant)
+     *   - BC4: `GL_COMPRESSED_RED_RGTC1` (`SIGNED` variant)
+     *   - BC5: `GL_COMPRESSED_RG_RGTC2` (`SIGNED` variant), e.g. normal maps
+     *   - BC6H: `GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT` (`SIGNED` variant), HDR images
+     *   - BC7: `GL_COMPRESSED_RGBA_BPTC_UNORM` (`SRGB_ALPHA` variant)
+     *
+     *  Images are stored as KTX2 files, and BC1/BC3/BC4/BC5 can be
+     *  encoded on the CPU, e.g. to cook texture caches offline. BC1/BC3
+     *  can be decoded on the CPU as well, for drivers without S3TC.
+     *
+     * @see Usage example:
+     *       src/cabin/utils/model.cc (glTF texture cache)
+     *       tools/texturec/main.cc
+     */
+    class CompressedImage {
+    public:
+        /** Load a KTX2 file holding a 2D image in a BCn format.
+         *
+         * @throw `std::runtime_error` if the file is broken, supercompressed,
+         *        or holds an array, a cube map or an unsupported format.
+         */
+        static CompressedImage loadKTX2(const std::string& path);
+
+        //! Save as a KTX2 file, throws if the file can't be written.
+        void saveKTX2(const std::string& path) const;
+
+        /** Encode a decoded 8-bit image, in parallel on the shared thread pool.
+         *
+         * @param format One of the BC1, BC3, BC4 or BC5 formats.
+         * @param levels Number of mipmap levels to encode, generated by `MipmapChain`
+         *               (in linear space for sRGB formats), or `Texture::ALL_MIPMAP_LEVELS`.
+         *
+         * @note BC4 takes the red channel, BC5 the red and green channels.
+         *
+         * @throw `std::runtime_error` if the image isn't 8-bit, or the format can't be encoded.
+         */
+        static CompressedImage encode(const Texture::Image& image, GLenum format, GLsizei levels = 1);
+
+        //! Encode every level of a mipmap chain of 8-bit images, e.g. generated with the Kaiser filter.
+        static CompressedImage encode(const MipmapChain& chain, GLenum format);
+
+        /** Decode the levels of a BC1 or BC3 image into 8-bit RGBA, in parallel on the shared thread pool.
+         *
+         * @note Used where the driver can't sample S3TC formats, see `isSupported`.
+         *
+         * @throw `std::runtime_error` if the image is in another format.
+         */
+        MipmapChain decode() const;
+
+        //! Get the format of decoded levels, `GL_SRGB8_ALPHA8` for sRGB formats, `GL_RGBA8` otherwise.
+        GLenum getDecodedFormat() const;
+
+        /** Check whether the driver can sample the format, on the OpenGL thread.
+         *
+         * @note S3TC (BC1, BC3) formats aren't core OpenGL, and require
+         *       `GL_EXT_texture_compression_s3tc` (and `GL_EXT_texture_sRGB`
+         *       for sRGB variants). RGTC and BPTC formats are core.
+         */
+        static bool isSupported(GLenum format);
+
+        //! Get the size of a 4x4 texel block (in byte), throws on non-BCn formats.
+        static GLsizei getBlockSize(GLenum format);
+
+        //! Get the size of all levels (in byte).
+        size_t getSize() const;
+
+    public:
+        GLenum format {};
+        GLsizei width {0}, height {0};
+        std::vector<std::vector<std::byte>> levels {};
+    };
+}
@@ -0,0 +1,310 @@
+#include "geometrypool.h"
+
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "memorybudget.h"
+
+namespace {
+    GLsizeiptr getIndexSize(GLenum type) {
+        return type == GL_UNSIGNED_BYTE ? 1 : (type == GL_UNSIGNED_SHORT ? 2 : 4);
+    }
+}
+
+namespace cabin::core {
+    GeometryPool::Builder& GeometryPool::Builder::setPageSize(GLsizeiptr vertexSize, GLsizeiptr indexSize) {
+        vertexPageSize = vertexSize;
+        indexPageSize = indexSize;
+        return *this;
+    }
+
+    GeometryPool GeometryPool::Builder::build() {
+        if (format.attributes.empty())
+            throw std::runtime_error("failed to build GeometryPool without any attribute!");
+
+        // Every page is attached to binding point `0` of the same vertex array.
+        GLuint vertexArrayID;
+        glCreateVertexArrays(1, &vertexArrayID);
+        format.apply(vertexArrayID);
+
+        GeometryPool result {};
+        result.VAO = vertexArrayID;
+        result.stride = format.stride;
+        result.m_vertexPageSize = vertexPageSize;
+        result.m_indexPageSize = indexPageSize;
+        return result;
+    }
+
+    GeometryPool::GeometryPool(GeometryPool&& right) noexcept {
+        *this = std::move(right);
+    }
+
+    GeometryPool& GeometryPool::operator=(GeometryPool&& right) noexcept {
+        release();
+
+        VAO = right.VAO;
+        stride = right.stride;
+        m_vertexPageSize = right.m_vertexPageSize;
+        m_indexPageSize = right.m_indexPageSize;
+        m_pages.swap(right.m_pages);
+        m_meshes.swap(right.m_meshes);
+        m_unusedMeshes.swap(right.m_unusedMeshes);
+        m_boundPage = right.m_boundPage;
+
+        right.VAO.reset();
+        right.m_boundPage.reset();
+
+        return *this;
+    }
+
+    GeometryPool::~GeometryPool() {
+        release();
+    }
+
+    GeometryPool::MeshID GeometryPool::allocate(const void* vertices, size_t vertexCount) {
+        return allocateMesh(vertices, vertexCount, nullptr, 0, 0);
+    }
+
+    GeometryPool::MeshID GeometryPool::allocateMesh(const void* vertices, size_t vertexCount, const void* indices,
+                                                    size_t indexCount, GLenum indexType) {
+        if (!VAO.has_value())
+            throw std::runtime_error("failed to allocate mesh in GeometryPool which isn't built!");
+        if (vertexCount == 0 || vertexCount > UINT32_MAX)
+            throw std::runtime_error("failed to allocate mesh in GeometryPool with invalid vertex count!");
+
+        GLsizeiptr indexSize = indexCount > 0 ? static_cast<GLsizeiptr>(indexCount) * getIndexSize(indexType) : 0;
+        size_t indexUnits = (indexSize + INDEX_UNIT - 1) / INDEX_UNIT;
+
+        MeshID mesh;
+        if (m_unusedMeshes.empty()) {
+            mesh = m_meshes.size();
+            m_meshes.emplace_back();
+        } else {
+            mesh = m_unusedMeshes.back();
+            m_unusedMeshes.pop_back();
+            m_meshes[mesh] = MeshEntry {};
+        }
+
+        MeshEntry& entry = m_meshes[mesh];
+        entry.mesh.vertexCount = static_cast<GLsizei>(vertexCount);
+        entry.mesh.indexCount = static_cast<GLsizei>(indexCount);
+        entry.mesh.indexType = indexType;
+
+        // The handle only becomes used with its ranges, so that `free` never releases ranges it doesn't own.
+        try {
+            place(m_pages, entry, vertexCount, indexUnits);
+        } catch (...) {
+            m_unusedMeshes.push_back(mesh);
+            throw;
+        }
+        entry.isUsed = true;
+
+        const Page& page = m_pages[entry.mesh.page];
+        glNamedBufferSubData(page.vertexBuffer, static_cast<GLintptr>(entry.mesh.baseVertex) * stride,
+                             static_cast<GLsizeiptr>(vertexCount) * stride, vertices);
+        if (entry.indices.has_value())
+            glNamedBufferSubData(page.indexBuffer, entry.indices->offset * INDEX_UNIT, indexSize, indices);
+
+        return mesh;
+    }
+
+    void GeometryPool::place(std::vector<Page>& pages, MeshEntry& entry, size_t vertexCount, size_t indexUnits) {
+        auto tryPlace = [&](size_t pageIndex) -> bool {
+            Page& page = pages[pageIndex];
+            auto vertexRange = page.vertexAllocator.allocate(static_cast<uint32_t>(vertexCount));
+            if (!vertexRange.has_value())
+                return false;
+
+            std::optional<RangeAllocator::Allocation> indexRange {};
+            if (indexUnits > 0) {
+                indexRange = page.indexAllocator.allocate(static_cast<uint32_t>(indexUnits));
+                if (!indexRange.has_value()) {
+                    page.vertexAllocator.free(vertexRange.value());
+                    return false;
+                }
+            }
+
+            entry.vertices = vertexRange.value();
+            entry.indices = indexRange;
+            entry.mesh.page = pageIndex;
+            entry.mesh.baseVertex = static_cast<GLint>(vertexRange->offset);
+            if (indexRange.has_value())
+                entry.mesh.firstIndex = static_cast<GLuint>(indexRange->offset * INDEX_UNIT / getIndexSize(entry.mesh.indexType));
+            return true;
+        };
+
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++) {
+            if (tryPlace(pageIndex))
+                return;
+        }
+
+        if (!tryPlace(createPage(pages, vertexCount, indexUnits)))
+            throw std::runtime_error("failed to place mesh in a new page of GeometryPool!");
+    }
+
+    size_t GeometryPool::createPage(std::vector<Page>& pages, size_t vertexCount, size_t indexUnits) {
+        // Vertex and index capacities are counted in allocator units, which must fit `uint32_t`.
+        size_t vertexCapacity = std::max<size_t>(m_vertexPageSize / stride, vertexCount);
+        size_t indexCapacity = std::max<size_t>(m_indexPageSize / INDEX_UNIT, indexUnits);
+        vertexCapacity = std::min<size_t>(vertexCapacity, UINT32_MAX);
+        indexCapacity = std::min<size_t>(indexCapacity, UINT32_MAX);
+
+        pages.emplace_back();
+        Page& page = pages.back();
+        glCreateBuffers(1, &page.vertexBuffer);
+        glNamedBufferStorage(page.vertexBuffer, static_cast<GLsizeiptr>(vertexCapacity) * stride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        MemoryBudget::getShared().track(MemoryBudget::Category::VertexBuffer, page.vertexBuffer,
+                                        vertexCapacity * stride);
+        page.vertexAllocator = RangeAllocator(static_cast<uint32_t>(vertexCapacity));
+
+        if (indexCapacity > 0) {
+            glCreateBuffers(1, &page.indexBuffer);
+            glNamedBufferStorage(page.indexBuffer, static_cast<GLsizeiptr>(indexCapacity) * INDEX_UNIT, nullptr, GL_DYNAMIC_STORAGE_BIT);
+            MemoryBudget::getShared().track(MemoryBudget::Category::VertexBuffer, page.indexBuffer,
+                                            indexCapacity * INDEX_UNIT);
+            page.indexAllocator = RangeAllocator(static_cast<uint32_t>(indexCapacity));
+        }
+
+        return pages.size() - 1;
+    }
+
+    void GeometryPool::free(MeshID mesh) {
+        MeshEntry& entry = m_meshes.at(mesh);
+        if (!entry.isUsed)
+            return;
+
+        Page& page = m_pages[entry.mesh.page];
+        page.vertexAllocator.free(entry.vertices);
+        if (entry.indices.has_value())
+            page.indexAllocator.free(entry.indices.value());
+
+        entry.isUsed = false;
+        m_unusedMeshes.push_back(mesh);
+    }
+
+    void GeometryPool::defragment() {
+        // Larger meshes go first, so that smaller ones fill the rest of the pages.
+        std::vector<MeshID> meshes {};
+        for (MeshID mesh = 0; mesh < m_meshes.size(); mesh++) {
+            if (m_meshes[mesh].isUsed)
+                meshes.push_back(mesh);
+        }
+        auto getMeshSize = [&](MeshID mesh) {
+            const MeshEntry& entry = m_meshes[mesh];
+            return static_cast<size_t>(entry.mesh.vertexCount) * stride +
+                   (entry.mesh.indexCount > 0 ? entry.mesh.indexCount * getIndexSize(entry.mesh.indexType) : 0);
+        };
+        std::stable_sort(meshes.begin(), meshes.end(), [&](MeshID a, MeshID b) {
+            return getMeshSize(a) > getMeshSize(b);
+        });
+
+        // Meshes are placed into new pages first, the pool is only changed once every mesh is copied.
+        std::vector<Page> newPages {};
+        std::vector<MeshEntry> newMeshes = m_meshes;
+        try {
+            for (MeshID mesh : meshes) {
+                const MeshEntry& oldEntry = m_meshes[mesh];
+                MeshEntry& entry = newMeshes[mesh];
+                GLsizeiptr indexSize = entry.mesh.indexCount > 0 ? entry.mesh.indexCount * getIndexSize(entry.mesh.indexType) : 0;
+                place(newPages, entry, entry.mesh.vertexCount, (indexSize + INDEX_UNIT - 1) / INDEX_UNIT);
+
+                const Page& oldPage = m_pages[oldEntry.mesh.page];
+                const Page& newPage = newPages[entry.mesh.page];
+                glCopyNamedBufferSubData(oldPage.vertexBuffer, newPage.vertexBuffer,
+                                         static_cast<GLintptr>(oldEntry.mesh.baseVertex) * stride,
+                                         static_cast<GLintptr>(entry.mesh.baseVertex) * stride,
+                                         static_cast<GLsizeiptr>(entry.mesh.vertexCount) * stride);
+                if (entry.indices.has_value())
+                    glCopyNamedBufferSubData(oldPage.indexBuffer, newPage.indexBuffer, oldEntry.indices->offset * INDEX_UNIT,
+                                             entry.indices->offset * INDEX_UNIT, indexSize);
+            }
+        } catch (...) {
+            for (Page& page : newPages)
+                deletePage(page);
+            throw;
+        }
+
+        m_pages.swap(newPages);
+        m_meshes.swap(newMeshes);
+        m_boundPage.reset();
+
+        for (Page& page : newPages)
+            deletePage(page);
+    }
+
+    void GeometryPool::draw(MeshID mesh, GLenum mode) const {
+        const MeshEntry& entry = m_meshes.at(mesh);
+        if (!entry.isUsed)
+            throw std::runtime_error("failed to draw mesh which is freed from GeometryPool!");
+
+        // The vertex array belongs to the pool, so it only changes when switching pages.
+        glBindVertexArray(VAO.value());
+        if (m_boundPage != entry.mesh.page) {
+            const Page& page = m_pages[entry.mesh.page];
+            glVertexArrayVertexBuffer(VAO.value(), 0, page.vertexBuffer, 0, stride);
+            glVertexArrayElementBuffer(VAO.value(), page.indexBuffer);
+            m_boundPage = entry.mesh.page;
+        }
+
+        if (!entry.indices.has_value()) {
+            glDrawArrays(mode, entry.mesh.baseVertex, entry.mesh.vertexCount);
+            return;
+        }
+
+        glDrawElementsBaseVertex(mode, entry.mesh.indexCount, entry.mesh.indexType,
+                                 reinterpret_cast<const void*>(static_cast<GLintptr>(entry.indices->offset) * INDEX_UNIT),
+                                 entry.mesh.baseVertex);
+    }
+
+    const GeometryPool::Mesh& GeometryPool::getMesh(MeshID mesh) const {
+        return m_meshes.at(mesh).mesh;
+    }
+
+    size_t GeometryPool::getPageCount() const {
+        return m_pages.size();
+    }
+
+    size_t GeometryPool::getUsedSize() const {
+        size_t size = 0;
+        for (const Page& page : m_pages)
+            size += static_cast<size_t>(page.vertexAllocator.getUsedSize()) * stride +
+                    static_cast<size_t>(page.indexAllocator.getUsedSize()) * INDEX_UNIT;
+        return size;
+    }
+
+    size_t GeometryPool::getCapacity() const {
+        size_t size = 0;
+        for (const Page& page : m_pages)
+            size += static_cast<size_t>(page.vertexAllocator.getCapacity()) * stride +
+                    static_cast<size_t>(page.indexAllocator.getCapacity()) * INDEX_UNIT;
+        return size;
+    }
+
+    void GeometryPool::deletePage(Page& page) {
+        if (page.vertexBuffer != 0) {
+            MemoryBudget::getShared().untrack(MemoryBudget::Category::VertexBuffer, page.vertexBuffer);
+            glDeleteBuffers(1, &page.vertexBuffer);
+            page.vertexBuffer = 0;
+        }
+
+        if (page.indexBuffer != 0) {
+            MemoryBudget::getShared().untrack(MemoryBudget::Category::VertexBuffer, page.indexBuffer);
+            glDeleteBuffers(1, &page.indexBuffer);
+            page.indexBuffer = 0;
+        }
+    }
+
+    void GeometryPool::release() {
+        for (Page& page : m_pages)
+            deletePage(page);
+        m_pages.clear();
+        m_meshes.clear();
+        m_unusedMeshes.clear();
+        m_boundPage.reset();
+
+        if (VAO.has_value()) {
+            glDeleteVertexArrays(1, &VAO.value());
+            VAO.reset();
+        }
+    }
+}
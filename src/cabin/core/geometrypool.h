@@ -0,0 +1,196 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+#include <glad/glad.h>
+#include "rangeallocator.h"
+#include "vertexlayout.h"
+
+namespace cabin::core {
+
+    /** Geometry Pool
+     *
+     * --------------------------
+     * `GeometryPool` packs the vertices and indices of many static
+     *  meshes (of one vertex layout) into a few large immutable buffer
+     *  pages, sub-allocated by `RangeAllocator`. All pages are drawn
+     *  through one vertex array, with `glDrawElementsBaseVertex`, so
+     *  meshes of the same page are drawn without rebinding anything.
+     *
+     *  Vertices are allocated in whole vertices, so that the base vertex
+     *  of a mesh is its offset. The vertices and indices of a mesh always
+     *  live in the same page.
+     *
+     * @see Usage example:
+     *       src/cabin/utils/model.cc
+     */
+    class GeometryPool {
+    public:
+        //! Handle of a mesh allocated from the pool.
+        using MeshID = size_t;
+
+        //! Where a mesh lives in the pool, e.g. to build indirect draw commands.
+        struct Mesh {
+            size_t page { 0 };
+            GLint baseVertex { 0 };
+            GLsizei vertexCount { 0 };
+            GLuint firstIndex { 0 };    //!< Offset into the index buffer of the page (in indices).
+            GLsizei indexCount { 0 };   //!< `0` if the mesh draws arrays.
+            GLenum indexType { 0 };
+        };
+
+        class Builder {
+        public:
+            Builder() = default;
+            Builder(Builder&&) = delete;
+            Builder(const Builder&) = delete;
+
+            /** Set the capacity of buffer pages.
+             *
+             * @param vertexSize Capacity of the vertex buffer of a page (in byte).
+             * @param indexSize  Capacity of the index buffer of a page (in byte).
+             *
+             * @note Meshes larger than a page get a page of their own size.
+             */
+            Builder& setPageSize(GLsizeiptr vertexSize, GLsizeiptr indexSize);
+
+            /** Add a vertex attribute, same as `VertexBuffer::Builder::addAttribute`.
+             *
+             * @tparam T         Attribute component type.
+             * @param index      Attribute location index.
+             * @param count      Attribute component count.
+             * @param normalized Whether normalize attribute components.
+             */
+            template <vertex::Component T>
+            Builder& addAttribute(GLuint index, GLuint count, bool normalized = false) {
+                format.add<T>(index, count, normalized);
+                return *this;
+            }
+
+            //! Set all attributes from the layout of a vertex struct, same as `VertexBuffer::Builder::setLayout`.
+            template <auto... Members>
+            Builder& setLayout(vertex::Layout<Members...> layout) {
+                format = vertex::Format::from(layout);
+                return *this;
+            }
+
+            GeometryPool build();
+
+        private:
+            GLsizeiptr vertexPageSize { 64 * 1024 * 1024 };
+            GLsizeiptr indexPageSize { 16 * 1024 * 1024 };
+            vertex::Format format {};
+        };
+
+    public:
+        GeometryPool() = default;
+
+        GeometryPool(GeometryPool&& right) noexcept;
+        GeometryPool& operator=(GeometryPool&& right) noexcept;
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        ~GeometryPool();
+
+        /** Copy a mesh into the pool.
+         *
+         * @param vertices    Pointer to vertices, in the layout of the pool.
+         * @param vertexCount Number of vertices.
+         * @param indices     Pointer to indices, whose width is kept on the GPU.
+         * @param indexCount  Number of indices.
+         *
+         * @note Opens a new page if no page has room for the mesh.
+         */
+        template <typename T>
+            requires std::is_same_v<T, unsigned char> || std::is_same_v<T, unsigned short> ||
+                     std::is_same_v<T, unsigned int>
+        MeshID allocate(const void* vertices, size_t vertexCount, const T* indices, size_t indexCount) {
+            GLenum type;
+            if constexpr (std::is_same_v<T, unsigned char>)
+                type = GL_UNSIGNED_BYTE;
+            else if constexpr (std::is_same_v<T, unsigned short>)
+                type = GL_UNSIGNED_SHORT;
+            else
+                type = GL_UNSIGNED_INT;
+
+            return allocateMesh(vertices, vertexCount, indices, indexCount, type);
+        }
+
+        //! Copy a mesh without indices into the pool, drawn with `glDrawArrays`.
+        MeshID allocate(const void* vertices, size_t vertexCount);
+
+        //! Release the ranges of a mesh, the handle may be reused by later allocations.
+        void free(MeshID mesh);
+
+        /** Repack all meshes into as few pages as possible.
+         *
+         * @note Meshes are copied on the GPU into new pages before the old pages are
+         *       deleted, so memory of the pool doubles during the call. Handles stay valid,
+         *       and the pool is left unchanged if the call throws.
+         */
+        void defragment();
+
+        //! Bind the vertex array and the page of the mesh, and draw it.
+        void draw(MeshID mesh, GLenum mode = GL_TRIANGLES) const;
+
+        const Mesh& getMesh(MeshID mesh) const;
+
+        size_t getPageCount() const;
+
+        //! Size of the vertices and indices allocated by meshes (in byte).
+        size_t getUsedSize() const;
+
+        //! Size of all pages (in byte).
+        size_t getCapacity() const;
+
+    public:
+        std::optional<GLuint> VAO;
+        GLsizei stride { 0 };           //!< Size of a vertex (in byte).
+
+    private:
+        //! Indices are allocated in 4-byte units, so that every index type is aligned.
+        static constexpr GLsizeiptr INDEX_UNIT = 4;
+
+        struct Page {
+            GLuint vertexBuffer { 0 };
+            GLuint indexBuffer { 0 };
+            RangeAllocator vertexAllocator {};  //!< In vertices.
+            RangeAllocator indexAllocator {};   //!< In `INDEX_UNIT`s.
+        };
+
+        struct MeshEntry {
+            Mesh mesh {};
+            RangeAllocator::Allocation vertices {};
+            std::optional<RangeAllocator::Allocation> indices {};
+            bool isUsed { false };
+        };
+
+        MeshID allocateMesh(const void* vertices, size_t vertexCount, const void* indices,
+                            size_t indexCount, GLenum indexType);
+
+        //! Allocate ranges of a mesh in an existing page of `pages` or a new one, and fill its location.
+        void place(std::vector<Page>& pages, MeshEntry& entry, size_t vertexCount, size_t indexUnits);
+
+        size_t createPage(std::vector<Page>& pages, size_t vertexCount, size_t indexUnits);
+        void deletePage(Page& page);
+        void release();
+
+    private:
+        GLsizeiptr m_vertexPageSize { 0 };
+        GLsizeiptr m_indexPageSize { 0 };
+        std::vector<Page> m_pages {};
+        std::vector<MeshEntry> m_meshes {};
+        std::vector<MeshID> m_unusedMeshes {};
+        mutable std::optional<size_t> m_boundPage {};
+    };
+}
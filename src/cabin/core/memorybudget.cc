@@ -0,0 +1,274 @@
+#include "memorybudget.h"
+#include <format>
+#include <algorithm>
+#include "texture.h"
+#include "compressedimage.h"
+#include "cabin/utils/console.h"
+
+namespace {
+    //! Get the size of a 4x4 block of BCn formats, or `0` for uncompressed formats.
+    size_t getBlockSize(GLenum format) {
+        switch (format) {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RED_RGTC1:
+            case GL_COMPRESSED_SIGNED_RED_RGTC1:
+                return 8;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            case GL_COMPRESSED_RG_RGTC2:
+            case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+            case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+            case GL_COMPRESSED_RGBA_BPTC_UNORM:
+            case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    size_t getTexelSize(GLenum format) {
+        switch (format) {
+            case GL_RED: case GL_R8: case GL_R8_SNORM: case GL_R8I: case GL_R8UI:
+            case GL_STENCIL_INDEX8:
+                return 1;
+            case GL_RG: case GL_RG8: case GL_RG8_SNORM: case GL_RG8I: case GL_RG8UI:
+            case GL_R16: case GL_R16_SNORM: case GL_R16F: case GL_R16I: case GL_R16UI:
+            case GL_RGB565: case GL_RGB5_A1: case GL_RGBA4: case GL_DEPTH_COMPONENT16:
+                return 2;
+            case GL_RGB: case GL_RGB8: case GL_SRGB8: case GL_RGB8_SNORM: case GL_RGB8I: case GL_RGB8UI:
+                return 3;
+            case GL_RGB16: case GL_RGB16_SNORM: case GL_RGB16F: case GL_RGB16I: case GL_RGB16UI:
+                return 6;
+            case GL_RGBA16: case GL_RGBA16_SNORM: case GL_RGBA16F: case GL_RGBA16I: case GL_RGBA16UI:
+            case GL_RG32F: case GL_RG32I: case GL_RG32UI: case GL_DEPTH32F_STENCIL8:
+                return 8;
+            case GL_RGB32F: case GL_RGB32I: case GL_RGB32UI:
+                return 12;
+            case GL_RGBA32F: case GL_RGBA32I: case GL_RGBA32UI:
+                return 16;
+            default:
+                // 32-bit formats, e.g. `GL_RGBA8`, `GL_R11F_G11F_B10F` and `GL_DEPTH24_STENCIL8`.
+                return 4;
+        }
+    }
+}
+
+namespace cabin::core {
+    MemoryBudget& MemoryBudget::getShared() {
+        static MemoryBudget budget {};
+        return budget;
+    }
+
+    void MemoryBudget::setBudget(size_t size) {
+        m_budget = size;
+    }
+
+    size_t MemoryBudget::getBudget() const {
+        return m_budget;
+    }
+
+    size_t MemoryBudget::getResidentSize() const {
+        size_t size = 0;
+        for (size_t categorySize : m_residentSizes)
+            size += categorySize;
+        return size;
+    }
+
+    size_t MemoryBudget::getResidentSize(Category category) const {
+        return m_residentSizes[static_cast<size_t>(category)];
+    }
+
+    size_t MemoryBudget::getEvictedSize() const {
+        return m_evictedSize;
+    }
+
+    size_t MemoryBudget::getEvictionCount() const {
+        return m_evictionCount;
+    }
+
+    size_t MemoryBudget::getReloadCount() const {
+        return m_reloadCount;
+    }
+
+    uint64_t MemoryBudget::getFrame() const {
+        return m_frame;
+    }
+
+    std::vector<MemoryBudget::Allocation> MemoryBudget::getAllocations() const {
+        std::vector<Allocation> allocations {};
+        allocations.reserve(m_textures.size() + m_objects.size());
+
+        for (const auto& [key, entry] : m_textures) {
+            const Texture& texture = *entry.texture;
+            Allocation allocation {};
+            allocation.category = Category::Texture;
+            allocation.id = texture.id.value_or(0);
+            allocation.format = texture.format;
+            allocation.width = texture.width;
+            allocation.height = texture.height;
+            allocation.depth = texture.depth;
+            allocation.levels = texture.levels;
+            allocation.size = entry.size;
+            allocation.lastUsedFrame = entry.lastUsedFrame;
+            allocation.isEvictable = static_cast<bool>(texture.m_reloader);
+            allocation.isResident = texture.id.has_value();
+            allocations.push_back(allocation);
+        }
+
+        for (const auto& [key, allocation] : m_objects)
+            allocations.push_back(allocation);
+
+        return allocations;
+    }
+
+    void MemoryBudget::endFrame() {
+        if (m_budget != 0 && getResidentSize() > m_budget)
+            evict(m_budget);
+        m_frame++;
+    }
+
+    size_t MemoryBudget::getTextureSize(GLenum target, GLenum format, GLsizei width, GLsizei height,
+                                        GLsizei depth, GLsizei levels) {
+        size_t size = 0;
+        for (GLsizei level = 0; level < levels; level++) {
+            GLsizei levelDepth;
+            switch (target) {
+                case GL_TEXTURE_3D:             levelDepth = std::max(depth >> level, 1); break;
+                case GL_TEXTURE_2D_ARRAY:       levelDepth = std::max(depth, 1); break;
+                case GL_TEXTURE_CUBE_MAP:       levelDepth = 6; break;
+                case GL_TEXTURE_CUBE_MAP_ARRAY: levelDepth = std::max(depth, 6); break;
+                default:                        levelDepth = 1; break;
+            }
+
+            size += getImageSize(format, std::max(width >> level, 1), std::max(height >> level, 1)) * levelDepth;
+        }
+        return size;
+    }
+
+    size_t MemoryBudget::getImageSize(GLenum format, GLsizei width, GLsizei height) {
+        if (size_t blockSize = getBlockSize(format))
+            return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+
+        return static_cast<size_t>(width) * height * getTexelSize(format);
+    }
+
+    void MemoryBudget::track(Texture& texture) {
+        size_t size = getTextureSize(texture.target, texture.format, texture.width, texture.height,
+                                     texture.depth, texture.levels);
+
+        auto [it, isInserted] = m_textures.try_emplace(&texture);
+        TextureEntry& entry = it->second;
+        if (isInserted)
+            entry.lastUsedFrame = m_frame;
+        else
+            m_residentSizes[static_cast<size_t>(Category::Texture)] -= entry.size;
+
+        entry.texture = &texture;
+        entry.size = size;
+        m_residentSizes[static_cast<size_t>(Category::Texture)] += size;
+    }
+
+    void MemoryBudget::untrack(const Texture& texture) {
+        auto it = m_textures.find(&texture);
+        if (it == m_textures.end())
+            return;
+
+        if (texture.id.has_value())
+            m_residentSizes[static_cast<size_t>(Category::Texture)] -= it->second.size;
+        else
+            m_evictedSize -= it->second.size;
+        m_textures.erase(it);
+    }
+
+    void MemoryBudget::relocate(const Texture& from, Texture& to) {
+        auto node = m_textures.extract(&from);
+        if (node.empty())
+            return;
+
+        node.key() = &to;
+        node.mapped().texture = &to;
+        m_textures.insert(std::move(node));
+    }
+
+    void MemoryBudget::use(const Texture& texture) {
+        auto it = m_textures.find(&texture);
+        if (it == m_textures.end())
+            return;
+
+        TextureEntry& entry = it->second;
+        if (!entry.texture->id.has_value()) {
+            // Make room first, so that the reloaded texture doesn't push the budget further.
+            if (m_budget != 0)
+                evict(m_budget > entry.size ? m_budget - entry.size : 0);
+
+            entry.texture->reload();
+            m_evictedSize -= entry.size;
+            m_residentSizes[static_cast<size_t>(Category::Texture)] += entry.size;
+            m_reloadCount++;
+        }
+        entry.lastUsedFrame = m_frame;
+    }
+
+    void MemoryBudget::track(Category category, GLuint id, size_t size, GLenum format,
+                             GLsizei width, GLsizei height) {
+        Allocation& allocation = m_objects[{ category, id }];
+        m_residentSizes[static_cast<size_t>(category)] -= allocation.size;
+
+        allocation.category = category;
+        allocation.id = id;
+        allocation.format = format;
+        allocation.width = width;
+        allocation.height = height;
+        allocation.levels = 1;
+        allocation.size = size;
+        m_residentSizes[static_cast<size_t>(category)] += size;
+    }
+
+    void MemoryBudget::untrack(Category category, GLuint id) {
+        auto it = m_objects.find({ category, id });
+        if (it == m_objects.end())
+            return;
+
+        m_residentSizes[static_cast<size_t>(category)] -= it->second.size;
+        m_objects.erase(it);
+    }
+
+    void MemoryBudget::evict(size_t limit) {
+        size_t residentSize = getResidentSize();
+        if (residentSize <= limit)
+            return;
+
+        std::vector<TextureEntry*> candidates {};
+        for (auto& [key, entry] : m_textures) {
+            if (entry.lastUsedFrame < m_frame && entry.texture->id.has_value() && entry.texture->m_reloader)
+                candidates.push_back(&entry);
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const TextureEntry* a, const TextureEntry* b) {
+            return a->lastUsedFrame < b->lastUsedFrame;
+        });
+
+        size_t evictedCount = 0, evictedSize = 0;
+        for (TextureEntry* entry : candidates) {
+            if (residentSize <= limit)
+                break;
+
+            entry->texture->evict();
+            residentSize -= entry->size;
+            evictedSize += entry->size;
+            evictedCount++;
+        }
+
+        m_residentSizes[static_cast<size_t>(Category::Texture)] -= evictedSize;
+        m_evictedSize += evictedSize;
+        m_evictionCount += evictedCount;
+
+        if (evictedCount > 0) {
+            utils::Console::info(std::format("evicted {} textures ({:.1f} MiB) to fit the memory budget",
+                                             evictedCount, evictedSize / (1024.0 * 1024.0)));
+        }
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+namespace cabin::core {
+
+    class Texture;
+
+    /** GPU Memory Budget
+     *
+     * --------------------------
+     * `MemoryBudget` accounts the video memory held by `Texture`,
+     *  `VertexBuffer` and `RenderBuffer` objects, which register
+     *  themselves when created, sized by their formats, extents and
+     *  mipmap levels.
+     *
+     *  When the resident size exceeds the budget, textures which can
+     *  be reloaded (e.g. decoded from files) are evicted at the end
+     *  of frames, least recently bound first. Evicted textures are
+     *  reloaded when bound again, by `Texture::active` or
+     *  `Texture::bindImage`.
+     *
+     * @note Sizes are estimated as the formats are specified, drivers
+     *       may pad or compress the storage. Only used on the thread
+     *       owning the OpenGL context.
+     *
+     * @see Usage example:
+     *       src/cabin/utils/memorypanel.cc
+     *       sandbox/hello_pbr/main.cc
+     */
+    class MemoryBudget {
+    public:
+        enum class Category {
+            Texture,
+            VertexBuffer,
+            RenderBuffer,
+        };
+
+        static constexpr size_t CATEGORY_COUNT = 3;
+
+        //! Snapshot of a tracked object, see `getAllocations`.
+        struct Allocation {
+            Category category {};
+            GLuint id { 0 };                            //!< Object name, `0` while evicted.
+            GLenum format { 0 };                        //!< Internal format, `0` for buffers.
+            GLsizei width {0}, height {0}, depth {0};
+            GLsizei levels { 0 };
+            size_t size { 0 };                          //!< Estimated size (in byte).
+            uint64_t lastUsedFrame { 0 };
+            bool isEvictable { false };
+            bool isResident { true };
+        };
+
+    public:
+        MemoryBudget() = default;
+        MemoryBudget(MemoryBudget&&) = delete;
+        MemoryBudget(const MemoryBudget&) = delete;
+
+        //! Get the budget shared by cabin objects.
+        static MemoryBudget& getShared();
+
+        /** Set the budget of resident objects (in byte), `0` for unlimited.
+         *
+         * @note Textures are evicted at the end of the frame, not right away.
+         */
+        void setBudget(size_t size);
+        size_t getBudget() const;
+
+        //! Get the size of all resident objects (in byte).
+        size_t getResidentSize() const;
+        size_t getResidentSize(Category category) const;
+
+        //! Get the size of evicted textures, which would be reloaded when bound (in byte).
+        size_t getEvictedSize() const;
+
+        size_t getEvictionCount() const;
+        size_t getReloadCount() const;
+        uint64_t getFrame() const;
+
+        //! Take a snapshot of all tracked objects.
+        std::vector<Allocation> getAllocations() const;
+
+        /** End the frame, and evict textures until the resident size fits the budget.
+         *
+         * @note Called by `Sandbox` after each frame. Textures bound in the
+         *       ending frame aren't evicted, the budget can be exceeded then.
+         */
+        void endFrame();
+
+        /** Get the size of a texture, with all its levels (in byte).
+         *
+         * @param depth Depth of 3D textures, or layers of array textures.
+         */
+        static size_t getTextureSize(GLenum target, GLenum format, GLsizei width, GLsizei height,
+                                     GLsizei depth, GLsizei levels);
+
+        //! Get the size of an image in a sized internal format, BCn formats included (in byte).
+        static size_t getImageSize(GLenum format, GLsizei width, GLsizei height);
+
+    private:
+        friend class Texture;
+        friend class VertexBuffer;
+        friend class RenderBuffer;
+        friend class GeometryPool;
+
+        //! Register a texture, or update its size.
+        void track(Texture& texture);
+        void untrack(const Texture& texture);
+
+        //! Keep tracking a texture moved to another object.
+        void relocate(const Texture& from, Texture& to);
+
+        //! Record a texture being bound, and reload it first if evicted.
+        void use(const Texture& texture);
+
+        //! Register a buffer or renderbuffer by its name, or update its size.
+        void track(Category category, GLuint id, size_t size, GLenum format = 0,
+                   GLsizei width = 0, GLsizei height = 0);
+        void untrack(Category category, GLuint id);
+
+        //! Evict textures unused in the current frame, until the resident size fits the limit.
+        void evict(size_t limit);
+
+    private:
+        struct TextureEntry {
+            Texture* texture { nullptr };
+            size_t size { 0 };
+            uint64_t lastUsedFrame { 0 };
+        };
+
+        std::unordered_map<const Texture*, TextureEntry> m_textures {};
+        std::map<std::pair<Category, GLuint>, Allocation> m_objects {};
+
+        size_t m_budget { 0 };
+        size_t m_residentSizes[CATEGORY_COUNT] {};
+        size_t m_evictedSize { 0 };
+        size_t m_evictionCount { 0 };
+        size_t m_reloadCount { 0 };
+        uint64_t m_frame { 0 };
+    };
+}
@@ -0,0 +1,313 @@
+#include "mipmapchain.h"
+
+#include <cmath>
+#include <array>
+#include <limits>
+#include <format>
+#include <future>
+#include <memory>
+#include <cstdint>
+#include <numbers>
+#include <algorithm>
+#include <stdexcept>
+
+#include "cabin/utils/threadpool.h"
+
+namespace {
+    using namespace cabin;
+    using core::MipmapChain;
+
+    //! Texels of a level in floating point, channels interleaved.
+    struct FloatImage {
+        std::vector<float> texels {};
+        GLsizei width { 0 }, height { 0 };
+    };
+
+    //! Source texels and weights of each destination texel, along one axis.
+    struct FilterTaps {
+        std::vector<size_t> offsets {};
+        std::vector<GLsizei> indices {};
+        std::vector<float> weights {};
+    };
+
+    int getChannelCount(GLenum srcFormat) {
+        switch (srcFormat) {
+            case GL_RED:  return 1;
+            case GL_RG:   return 2;
+            case GL_RGB:  return 3;
+            case GL_RGBA: return 4;
+            default:
+                throw std::runtime_error(std::format("unsupported image format for mipmap: 0x{:x}", srcFormat));
+        }
+    }
+
+    const std::array<float, 256>& getSrgbTable() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> result {};
+            for (int i = 0; i < 256; i++) {
+                float value = i / 255.0f;
+                result[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    float linearToSrgb(float value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    //! Modified Bessel function of the first kind, order 0, by its power series.
+    float besselI0(float x) {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 20; k++) {
+            float factor = x / (2.0f * k);
+            term *= factor * factor;
+            sum += term;
+        }
+        return sum;
+    }
+
+    //! Kaiser-windowed sinc, `x` in destination texels.
+    float kaiser(float x) {
+        constexpr float RADIUS = 3.0f, ALPHA = 4.0f;
+        if (std::abs(x) >= RADIUS)
+            return 0.0f;
+
+        float sinc = x == 0.0f ? 1.0f : std::sin(std::numbers::pi_v<float> * x) / (std::numbers::pi_v<float> * x);
+        float t = x / RADIUS;
+        return sinc * besselI0(ALPHA * std::sqrt(1.0f - t * t)) / besselI0(ALPHA);
+    }
+
+    FilterTaps buildTaps(GLsizei srcSize, GLsizei dstSize, MipmapChain::Filter filter) {
+        FilterTaps taps {};
+        float scale = static_cast<float>(srcSize) / dstSize;
+
+        for (GLsizei i = 0; i < dstSize; i++) {
+            size_t first = taps.weights.size();
+            taps.offsets.push_back(first);
+
+            // Texels beyond the edges are clamped, which keeps the weights of edge texels.
+            auto addTap = [&](GLsizei index, float weight) {
+                taps.indices.push_back(std::clamp(index, 0, srcSize - 1));
+                taps.weights.push_back(weight);
+            };
+
+            float begin = i * scale, end = (i + 1) * scale;
+            if (filter == MipmapChain::Filter::Box) {
+                for (auto j = static_cast<GLsizei>(std::floor(begin)); j < static_cast<GLsizei>(std::ceil(end)); j++) {
+                    float coverage = std::min(end, j + 1.0f) - std::max(begin, static_cast<float>(j));
+                    if (coverage > 0.0f)
+                        addTap(j, coverage);
+                }
+            } else {
+                float center = (begin + end) / 2.0f;
+                float radius = 3.0f * scale;
+                for (auto j = static_cast<GLsizei>(std::floor(center - radius)); j <= static_cast<GLsizei>(std::ceil(center + radius)); j++) {
+                    float weight = kaiser((j + 0.5f - center) / scale);
+                    if (weight != 0.0f)
+                        addTap(j, weight);
+                }
+            }
+
+            float total = 0.0f;
+            for (size_t t = first; t < taps.weights.size(); t++)
+                total += taps.weights[t];
+            for (size_t t = first; t < taps.weights.size(); t++)
+                taps.weights[t] /= total;
+        }
+        taps.offsets.push_back(taps.weights.size());
+
+        return taps;
+    }
+
+    //! Filter a row horizontally, the channel count is a constant so that texels unroll.
+    template <int CHANNELS>
+    void filterRow(const float* srcRow, float* dstRow, GLsizei dstWidth, const FilterTaps& taps) {
+        for (GLsizei x = 0; x < dstWidth; x++) {
+            float texel[CHANNELS] {};
+            for (size_t t = taps.offsets[x]; t < taps.offsets[x + 1]; t++) {
+                const float* srcTexel = srcRow + static_cast<size_t>(taps.indices[t]) * CHANNELS;
+                for (int c = 0; c < CHANNELS; c++)
+                    texel[c] += taps.weights[t] * srcTexel[c];
+            }
+            std::copy_n(texel, CHANNELS, dstRow + static_cast<size_t>(x) * CHANNELS);
+        }
+    }
+
+    FloatImage resample(const FloatImage& src, GLsizei dstWidth, GLsizei dstHeight, int channels, MipmapChain::Filter filter) {
+        utils::ThreadPool& pool = utils::ThreadPool::getShared();
+        FilterTaps tapsX = buildTaps(src.width, dstWidth, filter);
+        FilterTaps tapsY = buildTaps(src.height, dstHeight, filter);
+
+        // Horizontal pass, into rows of the destination width.
+        size_t rowSize = static_cast<size_t>(dstWidth) * channels;
+        std::vector<float> temp(src.height * rowSize);
+        pool.parallelFor(src.height, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++) {
+                const float* srcRow = src.texels.data() + y * src.width * channels;
+                float* dstRow = temp.data() + y * rowSize;
+                switch (channels) {
+                    case 1:  filterRow<1>(srcRow, dstRow, dstWidth, tapsX); break;
+                    case 2:  filterRow<2>(srcRow, dstRow, dstWidth, tapsX); break;
+                    case 3:  filterRow<3>(srcRow, dstRow, dstWidth, tapsX); break;
+                    default: filterRow<4>(srcRow, dstRow, dstWidth, tapsX); break;
+                }
+            }
+        });
+
+        // Vertical pass, accumulating whole rows so that the inner loop vectorizes.
+        FloatImage dst { std::vector<float>(dstHeight * rowSize), dstWidth, dstHeight };
+        pool.parallelFor(dstHeight, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++) {
+                float* dstRow = dst.texels.data() + y * rowSize;
+                for (size_t t = tapsY.offsets[y]; t < tapsY.offsets[y + 1]; t++) {
+                    const float* srcRow = temp.data() + static_cast<size_t>(tapsY.indices[t]) * rowSize;
+                    float weight = tapsY.weights[t];
+                    for (size_t i = 0; i < rowSize; i++)
+                        dstRow[i] += weight * srcRow[i];
+                }
+            }
+        });
+
+        return dst;
+    }
+
+    FloatImage toFloatImage(const core::Texture::Image& image, int channels, bool isSrgb) {
+        size_t texelCount = static_cast<size_t>(image.width) * image.height;
+        FloatImage result { std::vector<float>(texelCount * channels), image.width, image.height };
+        const auto& srgbTable = getSrgbTable();
+
+        // Branches are hoisted out of the loops, so that the conversions vectorize.
+        utils::ThreadPool::getShared().parallelFor(image.height, [&](size_t begin, size_t end) {
+            size_t first = begin * image.width * channels, last = end * image.width * channels;
+            float* texels = result.texels.data();
+            if (image.compType == GL_UNSIGNED_BYTE) {
+                auto pixels = static_cast<const uint8_t*>(image.pixels.get());
+                for (size_t i = first; i < last; i++)
+                    texels[i] = pixels[i] / 255.0f;
+
+                // Alpha stays linear.
+                if (isSrgb) {
+                    for (size_t i = first; i < last; i += channels) {
+                        for (int c = 0; c < std::min(channels, 3); c++)
+                            texels[i + c] = srgbTable[pixels[i + c]];
+                    }
+                }
+            } else if (image.compType == GL_UNSIGNED_SHORT) {
+                auto pixels = static_cast<const uint16_t*>(image.pixels.get());
+                for (size_t i = first; i < last; i++)
+                    texels[i] = pixels[i] / 65535.0f;
+            } else {
+                auto pixels = static_cast<const float*>(image.pixels.get());
+                std::copy(pixels + first, pixels + last, texels + first);
+            }
+        });
+        return result;
+    }
+
+    //! Allocate pixels owned by the returned pointer.
+    template <typename T>
+    std::shared_ptr<void> allocatePixels(size_t count, T*& data) {
+        auto buffer = std::make_shared<std::vector<T>>(count);
+        data = buffer->data();
+        return std::shared_ptr<void>(buffer, data);
+    }
+
+    core::Texture::Image toImage(const FloatImage& level, const core::Texture::Image& source, int channels, bool isSrgb,
+                                 const std::array<float, 4>& minValues, const std::array<float, 4>& maxValues) {
+        core::Texture::Image image {};
+        image.width = level.width;
+        image.height = level.height;
+        image.srcFormat = source.srcFormat;
+        image.compType = source.compType;
+
+        size_t count = level.texels.size();
+        uint8_t* bytes = nullptr;
+        uint16_t* shorts = nullptr;
+        float* floats = nullptr;
+        if (source.compType == GL_UNSIGNED_BYTE)
+            image.pixels = allocatePixels(count, bytes);
+        else if (source.compType == GL_UNSIGNED_SHORT)
+            image.pixels = allocatePixels(count, shorts);
+        else
+            image.pixels = allocatePixels(count, floats);
+
+        // Ringing of the Kaiser filter is clamped to the range of the source.
+        utils::ThreadPool::getShared().parallelFor(level.height, [&](size_t begin, size_t end) {
+            size_t first = begin * level.width * channels, last = end * level.width * channels;
+            std::vector<float> row(last - first);
+            for (size_t i = first; i < last; i += channels) {
+                for (int c = 0; c < channels; c++)
+                    row[i - first + c] = std::clamp(level.texels[i + c], minValues[c], maxValues[c]);
+            }
+
+            if (bytes) {
+                if (isSrgb) {
+                    for (size_t i = 0; i < row.size(); i += channels) {
+                        for (int c = 0; c < std::min(channels, 3); c++)
+                            row[i + c] = linearToSrgb(row[i + c]);
+                    }
+                }
+                for (size_t i = 0; i < row.size(); i++)
+                    bytes[first + i] = static_cast<uint8_t>(row[i] * 255.0f + 0.5f);
+            } else if (shorts) {
+                for (size_t i = 0; i < row.size(); i++)
+                    shorts[first + i] = static_cast<uint16_t>(row[i] * 65535.0f + 0.5f);
+            } else {
+                std::copy(row.begin(), row.end(), floats + first);
+            }
+        });
+        return image;
+    }
+}
+
+namespace cabin::core {
+
+    MipmapChain MipmapChain::generate(const Texture::Image& image, GLsizei levels, bool isSrgb, Filter filter) {
+        int channels = getChannelCount(image.srcFormat);
+        if (image.compType != GL_UNSIGNED_BYTE && image.compType != GL_UNSIGNED_SHORT && image.compType != GL_FLOAT)
+            throw std::runtime_error(std::format("unsupported image type for mipmap: 0x{:x}", image.compType));
+
+        if (levels == Texture::ALL_MIPMAP_LEVELS)
+            levels = Texture::getMipmapLevels(image.width, image.height);
+        isSrgb = isSrgb && image.compType == GL_UNSIGNED_BYTE;
+
+        MipmapChain chain {};
+        chain.levels.push_back(image);
+        if (levels <= 1)
+            return chain;
+
+        FloatImage level = toFloatImage(image, channels, isSrgb);
+
+        // Normalized formats are kept in [0, 1], floats in the range of the image.
+        std::array<float, 4> minValues {}, maxValues { 1.0f, 1.0f, 1.0f, 1.0f };
+        if (image.compType == GL_FLOAT) {
+            minValues.fill(std::numeric_limits<float>::max());
+            maxValues.fill(std::numeric_limits<float>::lowest());
+            for (size_t i = 0; i < level.texels.size(); i++) {
+                minValues[i % channels] = std::min(minValues[i % channels], level.texels[i]);
+                maxValues[i % channels] = std::max(maxValues[i % channels], level.texels[i]);
+            }
+        }
+
+        for (GLsizei i = 1; i < levels; i++) {
+            level = resample(level, std::max(level.width / 2, 1), std::max(level.height / 2, 1), channels, filter);
+            chain.levels.push_back(toImage(level, image, channels, isSrgb, minValues, maxValues));
+        }
+
+        return chain;
+    }
+
+    std::vector<MipmapChain> MipmapChain::generate(const std::vector<Texture::Image>& images, GLsizei levels,
+                                                   bool isSrgb, Filter filter) {
+        std::vector<MipmapChain> chains(images.size());
+
+        // Each image is a task, whose rows are then generated inline by the worker.
+        utils::ThreadPool::getShared().parallelFor(images.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                chains[i] = generate(images[i], levels, isSrgb, filter);
+        });
+        return chains;
+    }
+}
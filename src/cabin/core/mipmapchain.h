@@ -0,0 +1,65 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "cabin/core/texture.h"
+
+namespace cabin::core {
+
+    /** CPU Mipmap Chain
+     *
+     * --------------------------
+     * `MipmapChain` downsamples an image into its mipmap levels on
+     *  the CPU, instead of `glGenerateMipmap` on the GL thread, so
+     *  that the quality doesn't depend on the driver, and chains
+     *  can be generated in background or cooked offline.
+     *
+     *  Levels are filtered separably in floating point, rows spread
+     *  over the shared thread pool. 8-bit sRGB color channels are
+     *  filtered in linear space, and non-power-of-two sizes are
+     *  resampled by the covered area, without dropping texels.
+     *
+     * @see Usage example:
+     *       src/cabin/core/texture.cc
+     *       src/cabin/utils/model.cc
+     */
+    class MipmapChain {
+    public:
+        enum class Filter {
+            Box,        //!< Average of the covered texels, fast and never rings.
+            Kaiser,     //!< Kaiser-windowed sinc, sharper, slightly ringing (clamped).
+        };
+
+        /** Generate the mipmap chain of an image.
+         *
+         * @param image  Pixels of `GL_RED`, `GL_RG`, `GL_RGB` or `GL_RGBA`, in
+         *               `GL_UNSIGNED_BYTE`, `GL_UNSIGNED_SHORT` or `GL_FLOAT`.
+         * @param levels Number of levels including the image itself,
+         *               or `Texture::ALL_MIPMAP_LEVELS` for the complete chain.
+         * @param isSrgb Whether color channels are sRGB encoded, only for 8-bit
+         *               images, alpha stays linear.
+         *
+         * @note Levels keep the format of the image, and the first level shares its pixels.
+         *
+         * @throw `std::runtime_error` if the image format is unsupported.
+         */
+        static MipmapChain generate(const Texture::Image& image, GLsizei levels = Texture::ALL_MIPMAP_LEVELS,
+                                    bool isSrgb = false, Filter filter = Filter::Box);
+
+        //! Generate the chains of several images, in parallel across images.
+        static std::vector<MipmapChain> generate(const std::vector<Texture::Image>& images,
+                                                 GLsizei levels = Texture::ALL_MIPMAP_LEVELS,
+                                                 bool isSrgb = false, Filter filter = Filter::Box);
+
+    public:
+        std::vector<Texture::Image> levels {};
+    };
+}
@@ -0,0 +1,212 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "cabin/core/ringbuffer.h"
+
+namespace cabin::core::layout {
+
+    //! GLSL `std140` memory layout rule (uniform blocks).
+    struct Std140 {};
+
+    //! GLSL `std430` memory layout rule (shader storage blocks).
+    struct Std430 {};
+
+    /** `mat3` stored as three `vec4` columns.
+     *
+     * @note `glm::mat3` packs its columns tightly, which matches
+     *        neither `std140` nor `std430`.
+     */
+    struct Mat3 {
+        Mat3() = default;
+        Mat3(const glm::mat3& m)
+        : columns { glm::vec4(m[0], 0.0f), glm::vec4(m[1], 0.0f), glm::vec4(m[2], 0.0f) } {}
+
+        glm::vec4 columns[3];
+    };
+
+    /** Base alignment of a block member type under the layout rule.
+     *
+     * @return `0` if the C++ type can't represent the GLSL member.
+     */
+    template <typename Rule, typename T>
+    constexpr size_t baseAlignment() {
+        constexpr bool isStd140 = std::is_same_v<Rule, Std140>;
+
+        if constexpr (std::is_array_v<T>) {
+            // Array stride equals to the element size, which std140 rounds up to `vec4`.
+            using Element = std::remove_extent_t<T>;
+            constexpr size_t alignment = isStd140 ? 16 : baseAlignment<Rule, Element>();
+            if constexpr (baseAlignment<Rule, Element>() == 0 || sizeof(Element) % alignment != 0)
+                return 0;
+            else
+                return alignment;
+        }
+        else if constexpr (std::is_same_v<T, float> || std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t>)
+            return 4;
+        else if constexpr (std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::ivec2> || std::is_same_v<T, glm::uvec2>)
+            return 8;
+        else if constexpr (std::is_same_v<T, glm::vec3> || std::is_same_v<T, glm::ivec3> || std::is_same_v<T, glm::uvec3> ||
+                           std::is_same_v<T, glm::vec4> || std::is_same_v<T, glm::ivec4> || std::is_same_v<T, glm::uvec4>)
+            return 16;
+        else if constexpr (std::is_same_v<T, glm::mat4> || std::is_same_v<T, Mat3>)
+            return 16;
+        else if constexpr (std::is_same_v<T, glm::mat2>)
+            return isStd140 ? 0 : 8;
+        else if constexpr (std::is_class_v<T> && std::is_standard_layout_v<T>)
+            return isStd140 ? 16 : alignof(T);
+        else
+            return 0;
+    }
+
+    //! Whether a member of type `T` placed at `offset` follows the layout rule.
+    template <typename Rule, typename T>
+    constexpr bool isMemberAligned(size_t offset) {
+        constexpr size_t alignment = baseAlignment<Rule, T>();
+        return alignment != 0 && offset % alignment == 0;
+    }
+
+    /** Whether `T` can be copied into a block of the layout rule as a whole.
+     *
+     * @note The member offsets can't be inspected automatically,
+     *       use `CABIN_BLOCK_MEMBER` to check each of them.
+     */
+    template <typename Rule, typename T>
+    concept BlockLayout = std::is_standard_layout_v<T> &&
+                          std::is_trivially_copyable_v<T> &&
+                          sizeof(T) % (std::is_same_v<Rule, Std140> ? 16 : alignof(T)) == 0;
+}
+
+/** Check a block member against the layout rule at compile time.
+ *
+ * @note e.g. `CABIN_BLOCK_MEMBER(layout::Std140, FrameParameters, view);`
+ */
+#define CABIN_BLOCK_MEMBER(Rule, Type, member) \
+    static_assert(::cabin::core::layout::baseAlignment<Rule, decltype(Type::member)>() != 0, \
+                  "unsupported block member type: " #Type "::" #member); \
+    static_assert(::cabin::core::layout::isMemberAligned<Rule, decltype(Type::member)>(offsetof(Type, member)), \
+                  "misaligned block member: " #Type "::" #member)
+
+namespace cabin::core {
+
+    /** Uniform Block Parameters
+     *
+     * --------------------------
+     * Streams `std140` parameters into a `RingBuffer`, and binds
+     *  the written ranges to a uniform block binding point.
+     *
+     *  The matching GLSL declaration looks like:
+     *  `layout (std140, binding = N) uniform Name { ... };`
+     *
+     * @see Usage example:
+     *       sandbox/hello_pbr/main.cc
+     */
+    template <typename T>
+        requires layout::BlockLayout<layout::Std140, T>
+    class UniformBlock {
+    public:
+        UniformBlock() = default;
+
+        /** Create a uniform block.
+         *
+         * @param ring    Ring buffer to stream parameters into.
+         * @param binding Uniform block binding point.
+         */
+        UniformBlock(RingBuffer& ring, GLuint binding)
+        : m_ring(&ring), m_binding(binding) {
+            GLint alignment;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            m_alignment = alignment;
+        }
+
+        //! Write parameters into the ring buffer, without binding them.
+        RingBuffer::Range push(const T& value) const {
+            return m_ring->push(&value, sizeof(T), m_alignment);
+        }
+
+        //! Bind a written range to the block binding point. (wrapper of `glBindBufferRange`)
+        void bind(const RingBuffer::Range& range) const {
+            glBindBufferRange(GL_UNIFORM_BUFFER, m_binding, range.buffer, range.offset, range.size);
+        }
+
+        //! Write parameters and bind them immediately.
+        void update(const T& value) const {
+            bind(push(value));
+        }
+
+    private:
+        RingBuffer* m_ring { nullptr };
+        GLuint m_binding { 0 };
+        GLsizeiptr m_alignment { 1 };
+    };
+
+    /** Shader Storage Block Parameters
+     *
+     * --------------------------
+     * Streams `std430` parameters into a `RingBuffer`, and binds
+     *  the written ranges to a shader storage block binding point.
+     *
+     *  The matching GLSL declaration looks like:
+     *  `layout (std430, binding = N) buffer Name { T data[]; };`
+     */
+    template <typename T>
+        requires layout::BlockLayout<layout::Std430, T>
+    class StorageBlock {
+    public:
+        StorageBlock() = default;
+
+        /** Create a shader storage block.
+         *
+         * @param ring    Ring buffer to stream parameters into.
+         * @param binding Shader storage block binding point.
+         */
+        StorageBlock(RingBuffer& ring, GLuint binding)
+        : m_ring(&ring), m_binding(binding) {
+            GLint alignment;
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            m_alignment = alignment;
+        }
+
+        //! Write parameters into the ring buffer, without binding them.
+        RingBuffer::Range push(const T& value) const {
+            return m_ring->push(&value, sizeof(T), m_alignment);
+        }
+
+        //! Write an array of parameters into the ring buffer, without binding them.
+        RingBuffer::Range push(std::span<const T> values) const {
+            return m_ring->push(values.data(), values.size_bytes(), m_alignment);
+        }
+
+        //! Bind a written range to the block binding point. (wrapper of `glBindBufferRange`)
+        void bind(const RingBuffer::Range& range) const {
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, m_binding, range.buffer, range.offset, range.size);
+        }
+
+        //! Write parameters and bind them immediately.
+        void update(const T& value) const {
+            bind(push(value));
+        }
+
+        //! Write an array of parameters and bind them immediately.
+        void update(std::span<const T> values) const {
+            bind(push(values));
+        }
+
+    private:
+        RingBuffer* m_ring { nullptr };
+        GLuint m_binding { 0 };
+        GLsizeiptr m_alignment { 1 };
+    };
+}
@@ -0,0 +1,344 @@
+#include "radianceimage.h"
+
+#include <bit>
+#include <cmath>
+#include <array>
+#include <cstdio>
+#include <format>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+#include "cabin/utils/threadpool.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+    using namespace cabin;
+
+    //! Read-only view of a whole file, memory-mapped where supported, read otherwise.
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path) {
+#ifdef __linux__
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                struct stat status {};
+                if (fstat(fd, &status) == 0 && status.st_size > 0) {
+                    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (data != MAP_FAILED) {
+                        m_mapped = data;
+                        m_size = static_cast<size_t>(status.st_size);
+                        madvise(m_mapped, m_size, MADV_WILLNEED);
+                    }
+                }
+                close(fd);
+            }
+            if (m_mapped)
+                return;
+#endif
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+                throw std::runtime_error(std::format("failed to open image: {}", path));
+
+            m_content.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(m_content.data()), m_content.size());
+            if (!file)
+                throw std::runtime_error(std::format("failed to read image: {}", path));
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() {
+#ifdef __linux__
+            if (m_mapped)
+                munmap(m_mapped, m_size);
+#endif
+        }
+
+        const uint8_t* data() const {
+            return m_mapped ? static_cast<const uint8_t*>(m_mapped) : m_content.data();
+        }
+
+        size_t size() const {
+            return m_mapped ? m_size : m_content.size();
+        }
+
+    private:
+        void* m_mapped { nullptr };
+        size_t m_size { 0 };
+        std::vector<uint8_t> m_content {};
+    };
+
+    struct RadianceHeader {
+        int width, height;
+        bool isBottomUp;        // `+Y` images store the bottom scanline first
+        size_t dataOffset;
+    };
+
+    RadianceHeader parseHeader(const uint8_t* data, size_t size, const std::string& path) {
+        size_t offset = 0;
+        auto readLine = [&]() -> std::string_view {
+            size_t begin = offset;
+            while (offset < size && data[offset] != '\n')
+                offset++;
+            if (offset >= size)
+                throw std::runtime_error(std::format("broken HDR image: {}", path));
+            return { reinterpret_cast<const char*>(data) + begin, offset++ - begin };
+        };
+
+        std::string_view magic = readLine();
+        if (magic != "#?RADIANCE" && magic != "#?RGBE")
+            throw std::runtime_error(std::format("not a Radiance HDR image: {}", path));
+
+        // Variables end with an empty line, and only RGBE texels are supported (not XYZE).
+        for (std::string_view line = readLine(); !line.empty(); line = readLine()) {
+            if (line.starts_with("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe")
+                throw std::runtime_error(std::format("HDR image has an unsupported {}: {}", line, path));
+        }
+
+        std::string resolution { readLine() };
+        char ySign, xSign;
+        int width, height;
+        if (std::sscanf(resolution.c_str(), "%cY %d %cX %d", &ySign, &height, &xSign, &width) != 4 ||
+            (ySign != '-' && ySign != '+') || xSign != '+' || width <= 0 || height <= 0)
+            throw std::runtime_error(std::format("HDR image has an unsupported resolution \"{}\": {}", resolution, path));
+
+        return { width, height, ySign == '+', offset };
+    }
+
+    //! Check whether a scanline starts with the header of the adaptive run-length encoding,
+    //! which writers only use for widths in [8, 32767].
+    bool isRunLengthEncoded(const uint8_t* scanline, size_t remaining, int width) {
+        return width >= 8 && width < 32768 && remaining >= 4 &&
+               scanline[0] == 2 && scanline[1] == 2 && !(scanline[2] & 0x80);
+    }
+
+    //! Find where each scanline starts, by skipping over the runs instead of decoding them.
+    std::vector<size_t> locateScanlines(const uint8_t* data, size_t size, const RadianceHeader& header,
+                                        const std::string& path) {
+        auto broken = [&] { return std::runtime_error(std::format("broken HDR image: {}", path)); };
+
+        std::vector<size_t> offsets(header.height);
+        size_t offset = header.dataOffset;
+        for (int y = 0; y < header.height; y++) {
+            offsets[y] = offset;
+
+            if (!isRunLengthEncoded(data + offset, size - offset, header.width)) {
+                offset += static_cast<size_t>(header.width) * 4;
+                if (offset > size)
+                    throw broken();
+                continue;
+            }
+
+            if (((data[offset + 2] << 8) | data[offset + 3]) != header.width)
+                throw broken();
+            offset += 4;
+
+            // Each of the 4 components is encoded separately, as runs or literals.
+            for (int c = 0; c < 4; c++) {
+                for (int x = 0; x < header.width;) {
+                    if (offset >= size)
+                        throw broken();
+
+                    int count = data[offset];
+                    if (count > 128) {
+                        count -= 128;
+                        offset += 2;
+                    } else {
+                        if (count == 0)
+                            throw broken();
+                        offset += 1 + count;
+                    }
+
+                    x += count;
+                    if (x > header.width || offset > size)
+                        throw broken();
+                }
+            }
+        }
+        return offsets;
+    }
+
+    //! Decode a scanline located by `locateScanlines` into interleaved RGBE texels.
+    void decodeScanline(const uint8_t* scanline, int width, uint8_t* rgbe) {
+        if (!isRunLengthEncoded(scanline, 4, width)) {
+            std::memcpy(rgbe, scanline, static_cast<size_t>(width) * 4);
+            return;
+        }
+
+        const uint8_t* cursor = scanline + 4;
+        for (int c = 0; c < 4; c++) {
+            for (int x = 0; x < width;) {
+                int count = *cursor++;
+                if (count > 128) {
+                    uint8_t value = *cursor++;
+                    for (int end = x + count - 128; x < end; x++)
+                        rgbe[x * 4 + c] = value;
+                } else {
+                    for (int end = x + count; x < end; x++)
+                        rgbe[x * 4 + c] = *cursor++;
+                }
+            }
+        }
+    }
+
+    //! Scale of each shared exponent, the same as `stbi_loadf`.
+    const std::array<float, 256>& getExponentScales() {
+        static const std::array<float, 256> scales = [] {
+            std::array<float, 256> result {};
+            for (int e = 1; e < 256; e++)
+                result[e] = std::ldexp(1.0f, e - (128 + 8));
+            return result;
+        }();
+        return scales;
+    }
+
+    //! Convert a non-negative float to a half float, rounding to the nearest and clamping to 65504.
+    uint16_t toHalf(float value) {
+        if (!(value < 65504.0f))
+            return value >= 65504.0f ? 0x7BFF : 0;
+        if (value < 6.103515625e-05f)   // subnormal halves, in steps of 2^-24
+            return static_cast<uint16_t>(value * 16777216.0f + 0.5f);
+
+        uint32_t bits = std::bit_cast<uint32_t>(value);
+        uint32_t exponent = (bits >> 23) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+        uint32_t half = (exponent << 10) | (mantissa >> 13);
+
+        uint32_t rest = mantissa & 0x1FFF;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+            half++;
+        return static_cast<uint16_t>(std::min<uint32_t>(half, 0x7BFF));
+    }
+
+    //! Drop mantissa bits of a half float, for the 11-bit and 10-bit floats of `GL_R11F_G11F_B10F`.
+    uint32_t toSmallFloat(uint16_t half, int mantissaBits, uint32_t maxValue) {
+        int shift = 10 - mantissaBits;
+        uint32_t value = (static_cast<uint32_t>(half) + (1u << (shift - 1))) >> shift;
+        return std::min(value, maxValue);
+    }
+
+    size_t getTexelSize(GLenum compType) {
+        switch (compType) {
+            case GL_FLOAT:                         return 3 * sizeof(float);
+            case GL_HALF_FLOAT:                    return 3 * sizeof(uint16_t);
+            case GL_UNSIGNED_INT_10F_11F_11F_REV:  return sizeof(uint32_t);
+            default:
+                throw std::runtime_error(std::format("unsupported component type for HDR image: 0x{:x}", compType));
+        }
+    }
+
+    //! Convert a row of RGB floats into the component type.
+    void convertRow(const float* texels, int width, GLenum compType, std::byte* out) {
+        size_t count = static_cast<size_t>(width) * 3;
+        if (compType == GL_FLOAT) {
+            std::memcpy(out, texels, count * sizeof(float));
+        } else if (compType == GL_HALF_FLOAT) {
+            auto halves = reinterpret_cast<uint16_t*>(out);
+            for (size_t i = 0; i < count; i++)
+                halves[i] = toHalf(texels[i]);
+        } else {
+            auto packed = reinterpret_cast<uint32_t*>(out);
+            for (int x = 0; x < width; x++) {
+                const float* texel = texels + x * 3;
+                packed[x] = toSmallFloat(toHalf(texel[0]), 6, 0x7BF) |
+                            (toSmallFloat(toHalf(texel[1]), 6, 0x7BF) << 11) |
+                            (toSmallFloat(toHalf(texel[2]), 5, 0x3DF) << 22);
+            }
+        }
+    }
+
+    //! Allocate the pixels of an image, owned by the image.
+    std::byte* allocatePixels(core::Texture::Image& image, size_t size) {
+        auto buffer = std::make_shared<std::vector<std::byte>>(size);
+        image.pixels = std::shared_ptr<void>(buffer, buffer->data());
+        return buffer->data();
+    }
+}
+
+namespace cabin::core {
+
+    Texture::Image RadianceImage::load(const std::string& path, GLenum compType, bool flip) {
+        size_t texelSize = getTexelSize(compType);
+
+        MappedFile file(path);
+        RadianceHeader header = parseHeader(file.data(), file.size(), path);
+        std::vector<size_t> offsets = locateScanlines(file.data(), file.size(), header, path);
+
+        Texture::Image image {};
+        image.width = header.width;
+        image.height = header.height;
+        image.srcFormat = GL_RGB;
+        image.compType = compType;
+
+        size_t rowSize = static_cast<size_t>(header.width) * texelSize;
+        std::byte* pixels = allocatePixels(image, rowSize * header.height);
+
+        // Scanlines are independent once located, so rows decode in parallel.
+        const auto& scales = getExponentScales();
+        utils::ThreadPool::getShared().parallelFor(header.height, [&](size_t begin, size_t end) {
+            std::vector<uint8_t> rgbe(static_cast<size_t>(header.width) * 4);
+            std::vector<float> texels(static_cast<size_t>(header.width) * 3);
+
+            for (size_t y = begin; y < end; y++) {
+                decodeScanline(file.data() + offsets[y], header.width, rgbe.data());
+
+                for (int x = 0; x < header.width; x++) {
+                    float scale = scales[rgbe[x * 4 + 3]];
+                    for (int c = 0; c < 3; c++)
+                        texels[x * 3 + c] = rgbe[x * 4 + c] * scale;
+                }
+
+                size_t row = flip != header.isBottomUp ? header.height - 1 - y : y;
+                convertRow(texels.data(), header.width, compType, pixels + row * rowSize);
+            }
+        });
+
+        return image;
+    }
+
+    Texture::Image RadianceImage::convert(const Texture::Image& image, GLenum compType) {
+        if (image.srcFormat != GL_RGB || image.compType != GL_FLOAT)
+            throw std::runtime_error("only RGB float images can be converted");
+        if (compType == GL_FLOAT)
+            return image;
+
+        size_t texelSize = getTexelSize(compType);
+
+        Texture::Image result = image;
+        result.compType = compType;
+
+        size_t rowSize = static_cast<size_t>(image.width) * texelSize;
+        std::byte* pixels = allocatePixels(result, rowSize * image.height);
+        auto texels = static_cast<const float*>(image.pixels.get());
+
+        utils::ThreadPool::getShared().parallelFor(image.height, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++)
+                convertRow(texels + y * image.width * 3, image.width, compType, pixels + y * rowSize);
+        });
+        return result;
+    }
+
+    GLenum RadianceImage::getCompType(GLenum internalFormat) {
+        switch (internalFormat) {
+            case GL_RGB16F: case GL_RGBA16F:
+                return GL_HALF_FLOAT;
+            case GL_R11F_G11F_B10F:
+                return GL_UNSIGNED_INT_10F_11F_11F_REV;
+            default:
+                return GL_FLOAT;
+        }
+    }
+}
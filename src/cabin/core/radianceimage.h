@@ -0,0 +1,58 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <string>
+
+#include <glad/glad.h>
+
+#include "cabin/core/texture.h"
+
+namespace cabin::core {
+
+    /** Radiance HDR Image
+     *
+     * --------------------------
+     * `RadianceImage` decodes Radiance RGBE (`.hdr`) files, e.g. the
+     *  HDRIs of image based lighting, without `stbi_loadf`:
+     *
+     *   - The file is memory-mapped (on Linux), rather than read.
+     *   - Scanlines are located in one quick pass over the run
+     *     lengths, then decoded in parallel on the shared thread pool.
+     *   - Texels are converted straight into the component type
+     *     of the texture, so an image in `GL_RGB16F` takes half of
+     *     the memory of `GL_RGB32F`, and `GL_R11F_G11F_B10F` a quarter.
+     *
+     * @see Usage example:
+     *       src/cabin/core/texture.cc (`.hdr` files of `Texture::Builder::fromFile2D`)
+     */
+    class RadianceImage {
+    public:
+        /** Decode a Radiance RGBE file into `GL_RGB` pixels.
+         *
+         * @param compType `GL_FLOAT`, `GL_HALF_FLOAT`, or `GL_UNSIGNED_INT_10F_11F_11F_REV`
+         *                 (one packed `GLuint` per texel), see `getCompType`.
+         * @param flip     Whether the bottom row comes first, as `Texture::decodeFile`.
+         *
+         * @note Safe to call from any thread. Components beyond the range of
+         *       the type are clamped to its largest finite value.
+         *
+         * @throw `std::runtime_error` if the file is broken, or isn't in `32-bit_rle_rgbe` format.
+         */
+        static Texture::Image load(const std::string& path, GLenum compType = GL_HALF_FLOAT, bool flip = true);
+
+        //! Convert a `GL_RGB` float image into another component type of `load`.
+        static Texture::Image convert(const Texture::Image& image, GLenum compType);
+
+        /** Get the component type to decode for an internal format.
+         *
+         * @return `GL_HALF_FLOAT` for `GL_RGB16F` and `GL_RGBA16F`,
+         *         `GL_UNSIGNED_INT_10F_11F_11F_REV` for `GL_R11F_G11F_B10F`, otherwise `GL_FLOAT`.
+         */
+        static GLenum getCompType(GLenum internalFormat);
+    };
+}
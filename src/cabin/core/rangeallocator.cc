@@ -0,0 +1,186 @@
+#include "rangeallocator.h"
+
+#include <bit>
+#include <algorithm>
+
+namespace cabin::core {
+    RangeAllocator::RangeAllocator(uint32_t capacity)
+    : m_capacity(capacity) {
+        for (auto& heads : m_freeHeads)
+            std::fill(std::begin(heads), std::end(heads), NO_BLOCK);
+
+        if (capacity == 0)
+            return;
+
+        uint32_t block = createBlock();
+        m_blocks[block].size = capacity;
+        insertFreeBlock(block);
+    }
+
+    std::optional<RangeAllocator::Allocation> RangeAllocator::allocate(uint32_t size) {
+        if (size == 0 || size > m_capacity - m_usedSize)
+            return {};
+
+        uint32_t block = NO_BLOCK;
+
+        // Round the size up to the next list, so that the head of any list found is large enough.
+        uint64_t searchSize = size;
+        if (size >= SECOND_LEVEL_COUNT)
+            searchSize += (uint64_t(1) << (std::bit_width(size) - 1 - SECOND_LEVEL_LOG2)) - 1;
+
+        uint32_t firstLevel, secondLevel;
+        if (searchSize <= UINT32_MAX) {
+            getLevels(static_cast<uint32_t>(searchSize), firstLevel, secondLevel);
+
+            uint32_t secondMask = m_secondLevelMasks[firstLevel] & (~0u << secondLevel);
+            if (secondMask == 0) {
+                uint32_t firstMask = firstLevel + 1 < 32 ? m_firstLevelMask & (~0u << (firstLevel + 1)) : 0;
+                if (firstMask != 0) {
+                    firstLevel = std::countr_zero(firstMask);
+                    secondMask = m_secondLevelMasks[firstLevel];
+                }
+            }
+            if (secondMask != 0)
+                block = m_freeHeads[firstLevel][std::countr_zero(secondMask)];
+        }
+
+        // Blocks of the exact list may still fit, e.g. a single range of the whole capacity.
+        if (block == NO_BLOCK) {
+            getLevels(size, firstLevel, secondLevel);
+            for (uint32_t candidate = m_freeHeads[firstLevel][secondLevel]; candidate != NO_BLOCK;
+                 candidate = m_blocks[candidate].nextFree) {
+                if (m_blocks[candidate].size >= size) {
+                    block = candidate;
+                    break;
+                }
+            }
+            if (block == NO_BLOCK)
+                return {};
+        }
+
+        removeFreeBlock(block);
+
+        // Split off the remainder, which goes back to the free lists.
+        if (m_blocks[block].size > size) {
+            uint32_t rest = createBlock();
+            Block& allocated = m_blocks[block];
+            Block& remainder = m_blocks[rest];
+
+            remainder.offset = allocated.offset + size;
+            remainder.size = allocated.size - size;
+            remainder.prevPhysical = block;
+            remainder.nextPhysical = allocated.nextPhysical;
+            if (allocated.nextPhysical != NO_BLOCK)
+                m_blocks[allocated.nextPhysical].prevPhysical = rest;
+            allocated.nextPhysical = rest;
+            allocated.size = size;
+
+            insertFreeBlock(rest);
+        }
+
+        m_usedSize += size;
+        return Allocation { m_blocks[block].offset, block };
+    }
+
+    void RangeAllocator::free(const Allocation& allocation) {
+        uint32_t block = allocation.block;
+        m_usedSize -= m_blocks[block].size;
+
+        uint32_t prev = m_blocks[block].prevPhysical;
+        if (prev != NO_BLOCK && m_blocks[prev].isFree) {
+            removeFreeBlock(prev);
+            m_blocks[prev].size += m_blocks[block].size;
+            m_blocks[prev].nextPhysical = m_blocks[block].nextPhysical;
+            if (m_blocks[block].nextPhysical != NO_BLOCK)
+                m_blocks[m_blocks[block].nextPhysical].prevPhysical = prev;
+
+            m_unusedBlocks.push_back(block);
+            block = prev;
+        }
+
+        uint32_t next = m_blocks[block].nextPhysical;
+        if (next != NO_BLOCK && m_blocks[next].isFree) {
+            removeFreeBlock(next);
+            m_blocks[block].size += m_blocks[next].size;
+            m_blocks[block].nextPhysical = m_blocks[next].nextPhysical;
+            if (m_blocks[next].nextPhysical != NO_BLOCK)
+                m_blocks[m_blocks[next].nextPhysical].prevPhysical = block;
+
+            m_unusedBlocks.push_back(next);
+        }
+
+        insertFreeBlock(block);
+    }
+
+    uint32_t RangeAllocator::getCapacity() const {
+        return m_capacity;
+    }
+
+    uint32_t RangeAllocator::getUsedSize() const {
+        return m_usedSize;
+    }
+
+    void RangeAllocator::getLevels(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+        // Sizes below `SECOND_LEVEL_COUNT` get a list each, in the first level `0`.
+        if (size < SECOND_LEVEL_COUNT) {
+            firstLevel = 0;
+            secondLevel = size;
+            return;
+        }
+
+        uint32_t bits = std::bit_width(size);
+        firstLevel = bits - SECOND_LEVEL_LOG2;
+        secondLevel = (size >> (bits - 1 - SECOND_LEVEL_LOG2)) & (SECOND_LEVEL_COUNT - 1);
+    }
+
+    uint32_t RangeAllocator::createBlock() {
+        if (m_unusedBlocks.empty()) {
+            m_blocks.emplace_back();
+            return static_cast<uint32_t>(m_blocks.size() - 1);
+        }
+
+        uint32_t block = m_unusedBlocks.back();
+        m_unusedBlocks.pop_back();
+        m_blocks[block] = Block {};
+        return block;
+    }
+
+    void RangeAllocator::insertFreeBlock(uint32_t block) {
+        uint32_t firstLevel, secondLevel;
+        getLevels(m_blocks[block].size, firstLevel, secondLevel);
+
+        uint32_t& head = m_freeHeads[firstLevel][secondLevel];
+        m_blocks[block].isFree = true;
+        m_blocks[block].prevFree = NO_BLOCK;
+        m_blocks[block].nextFree = head;
+        if (head != NO_BLOCK)
+            m_blocks[head].prevFree = block;
+        head = block;
+
+        m_secondLevelMasks[firstLevel] |= 1u << secondLevel;
+        m_firstLevelMask |= 1u << firstLevel;
+    }
+
+    void RangeAllocator::removeFreeBlock(uint32_t block) {
+        uint32_t firstLevel, secondLevel;
+        getLevels(m_blocks[block].size, firstLevel, secondLevel);
+
+        Block& removed = m_blocks[block];
+        if (removed.prevFree != NO_BLOCK)
+            m_blocks[removed.prevFree].nextFree = removed.nextFree;
+        else
+            m_freeHeads[firstLevel][secondLevel] = removed.nextFree;
+        if (removed.nextFree != NO_BLOCK)
+            m_blocks[removed.nextFree].prevFree = removed.prevFree;
+
+        removed.isFree = false;
+        removed.prevFree = NO_BLOCK;
+        removed.nextFree = NO_BLOCK;
+
+        if (m_freeHeads[firstLevel][secondLevel] == NO_BLOCK) {
+            m_secondLevelMasks[firstLevel] &= ~(1u << secondLevel);
+            if (m_secondLevelMasks[firstLevel] == 0)
+                m_firstLevelMask &= ~(1u << firstLevel);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+namespace cabin::core {
+
+    /** Range Allocator
+     *
+     * --------------------------
+     * `RangeAllocator` sub-allocates ranges of `[0, capacity)`, e.g.
+     *  units inside a GPU buffer, without touching any memory itself.
+     *
+     *  Free ranges are kept in two-level segregated lists (TLSF): the
+     *  first level splits sizes by powers of two, the second level
+     *  splits each of them linearly. Bitmaps of non-empty lists make
+     *  `allocate` and `free` constant time, and freed ranges are merged
+     *  with their free neighbours at once.
+     */
+    class RangeAllocator {
+    public:
+        struct Allocation {
+            uint32_t offset;    //!< First unit of the range.
+            uint32_t block;     //!< Internal block, used by `free`.
+        };
+
+    public:
+        RangeAllocator() = default;
+
+        //! @param capacity Number of units managed by the allocator.
+        explicit RangeAllocator(uint32_t capacity);
+
+        /** Allocate a range of `size` units.
+         *
+         * @return Nothing if there is no free range that large.
+         */
+        std::optional<Allocation> allocate(uint32_t size);
+
+        //! Free a range returned by `allocate`.
+        void free(const Allocation& allocation);
+
+        uint32_t getCapacity() const;
+        uint32_t getUsedSize() const;
+
+    private:
+        static constexpr uint32_t SECOND_LEVEL_LOG2 = 4;
+        static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_LOG2;
+        static constexpr uint32_t FIRST_LEVEL_COUNT = 32 - SECOND_LEVEL_LOG2 + 1;
+        static constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+        struct Block {
+            uint32_t offset { 0 };
+            uint32_t size { 0 };
+            uint32_t prevPhysical { NO_BLOCK };
+            uint32_t nextPhysical { NO_BLOCK };
+            uint32_t prevFree { NO_BLOCK };
+            uint32_t nextFree { NO_BLOCK };
+            bool isFree { false };
+        };
+
+        //! Get the first and second level of the list holding blocks of `size`.
+        static void getLevels(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+        uint32_t createBlock();
+        void insertFreeBlock(uint32_t block);
+        void removeFreeBlock(uint32_t block);
+
+    private:
+        uint32_t m_capacity { 0 };
+        uint32_t m_usedSize { 0 };
+        uint32_t m_firstLevelMask { 0 };
+        uint32_t m_secondLevelMasks[FIRST_LEVEL_COUNT] {};
+        uint32_t m_freeHeads[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT] {};
+        std::vector<Block> m_blocks {};
+        std::vector<uint32_t> m_unusedBlocks {};
+    };
+}
@@ -1,4 +1,5 @@
 #include "renderbuffer.h"
+#include "memorybudget.h"
 
 namespace cabin::core {
 
@@ -18,6 +19,9 @@ namespace cabin::core {
         glGenRenderbuffers(1, &id);
         glBindRenderbuffer(GL_RENDERBUFFER, id);
         glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+        MemoryBudget::getShared().track(MemoryBudget::Category::RenderBuffer, id,
+                                        MemoryBudget::getImageSize(internalFormat, width, height),
+                                        internalFormat, width, height);
         
         return RenderBuffer { id, internalFormat, width, height };
     }
@@ -35,6 +39,7 @@ namespace cabin::core {
 
     RenderBuffer::~RenderBuffer() {
         if (id.has_value()) {
+            MemoryBudget::getShared().untrack(MemoryBudget::Category::RenderBuffer, id.value());
             glDeleteRenderbuffers(1, &id.value());
             id.reset();
         }
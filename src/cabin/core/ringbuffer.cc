@@ -0,0 +1,121 @@
+#include "ringbuffer.h"
+
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+namespace {
+    GLsizeiptr alignUp(GLsizeiptr value, GLsizeiptr alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+namespace cabin::core {
+
+    RingBuffer::RingBuffer(GLsizeiptr frameSize, GLuint frameCount)
+    : m_frameCount(frameCount), m_fences(frameCount, nullptr) {
+        if (frameSize <= 0 || frameCount == 0)
+            throw std::runtime_error("failed to create RingBuffer with empty capacity!");
+
+        // Start every frame region at an offset usable by any buffer binding.
+        GLint uniformAlignment = 0, storageAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+        GLsizeiptr regionAlignment = std::max<GLsizeiptr>({ 16, uniformAlignment, storageAlignment });
+        frameSize = alignUp(frameSize, regionAlignment);
+        m_frameSize = frameSize;
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        GLuint buffer;
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, frameSize * frameCount, nullptr, flags);
+        id = buffer;
+
+        m_mappedData = static_cast<std::byte*>(glMapNamedBufferRange(buffer, 0, frameSize * frameCount, flags));
+        if (!m_mappedData) {
+            release();
+            throw std::runtime_error("failed to map RingBuffer persistently!");
+        }
+    }
+
+    RingBuffer::RingBuffer(RingBuffer&& right) noexcept {
+        *this = std::move(right);
+    }
+
+    RingBuffer& RingBuffer::operator=(RingBuffer&& right) noexcept {
+        release();
+
+        id = right.id;
+        m_mappedData = right.m_mappedData;
+        m_frameSize = right.m_frameSize;
+        m_frameOffset = right.m_frameOffset;
+        m_frameCount = right.m_frameCount;
+        m_frameIndex = right.m_frameIndex;
+        m_fences.swap(right.m_fences);
+
+        right.id.reset();
+        right.m_mappedData = nullptr;
+        right.m_fences.clear();
+
+        return *this;
+    }
+
+    RingBuffer::~RingBuffer() {
+        release();
+    }
+
+    void RingBuffer::release() {
+        for (GLsync& fence : m_fences) {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        if (id.has_value()) {
+            if (m_mappedData)
+                glUnmapNamedBuffer(id.value());
+            glDeleteBuffers(1, &id.value());
+            id.reset();
+        }
+        m_mappedData = nullptr;
+    }
+
+    void RingBuffer::beginFrame() {
+        m_frameIndex = (m_frameIndex + 1) % m_frameCount;
+        m_frameOffset = 0;
+
+        GLsync& fence = m_fences[m_frameIndex];
+        if (!fence)
+            return;
+
+        GLenum waitResult = glClientWaitSync(fence, 0, 0);
+        while (waitResult == GL_TIMEOUT_EXPIRED) {
+            waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    void RingBuffer::endFrame() {
+        GLsync& fence = m_fences[m_frameIndex];
+        if (fence)
+            glDeleteSync(fence);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    RingBuffer::Range RingBuffer::push(const void* data, GLsizeiptr size, GLsizeiptr alignment) {
+        // Align the offset in the whole buffer, which is what binding points check.
+        GLintptr frameBegin = m_frameIndex * m_frameSize;
+        GLintptr bufferOffset = alignUp(frameBegin + m_frameOffset, alignment);
+        if (bufferOffset + size > frameBegin + m_frameSize)
+            throw std::runtime_error("RingBuffer frame region is out of space!");
+
+        std::memcpy(m_mappedData + bufferOffset, data, size);
+        m_frameOffset = bufferOffset + size - frameBegin;
+
+        return Range { id.value(), bufferOffset, size };
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <optional>
+
+#include <glad/glad.h>
+
+namespace cabin::core {
+
+    /** Persistently Mapped Ring Buffer
+     *
+     * --------------------------
+     * `RingBuffer` owns one buffer object which is mapped once
+     *  with `GL_MAP_PERSISTENT_BIT`, and split into several frame
+     *  regions. Data of a frame is streamed into its own region,
+     *  while the GPU still reads the regions of previous frames.
+     *
+     *  Every region is guarded by a fence, so `beginFrame` only
+     *  blocks when the CPU runs `frameCount` frames ahead.
+     *
+     * @see Usage example:
+     *       sandbox/hello_pbr/main.cc
+     */
+    class RingBuffer {
+    public:
+        //! A written range of the ring buffer, ready to be bound.
+        struct Range {
+            GLuint buffer;
+            GLintptr offset;
+            GLsizeiptr size;
+        };
+
+    public:
+        RingBuffer() = default;
+
+        /** Create and map the ring buffer.
+         *
+         * @param frameSize  Capacity of each frame region (in byte), rounded up to
+         *                   the uniform and storage buffer offset alignments.
+         * @param frameCount Number of frame regions, i.e. frames in flight.
+         */
+        explicit RingBuffer(GLsizeiptr frameSize, GLuint frameCount = 3);
+
+        RingBuffer(RingBuffer&& right) noexcept;
+        RingBuffer& operator=(RingBuffer&& right) noexcept;
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        ~RingBuffer();
+
+        //! Switch to the next frame region, waiting until the GPU has finished reading it.
+        void beginFrame();
+
+        //! Fence the current frame region, so that it won't be overwritten while in use.
+        void endFrame();
+
+        /** Copy data into the current frame region.
+         *
+         * @param data      Pointer to the source data.
+         * @param size      Size of the source data (in byte).
+         * @param alignment Required alignment of the range offset.
+         *
+         * @note Throws if the frame region runs out of space.
+         */
+        Range push(const void* data, GLsizeiptr size, GLsizeiptr alignment);
+
+    private:
+        void release();
+
+    public:
+        std::optional<GLuint> id;
+
+    private:
+        std::byte* m_mappedData { nullptr };
+        GLsizeiptr m_frameSize { 0 };
+        GLsizeiptr m_frameOffset { 0 };
+        GLuint m_frameCount { 0 };
+        GLuint m_frameIndex { 0 };
+        std::vector<GLsync> m_fences {};
+    };
+}
@@ -1,12 +1,27 @@
 #include "shader.h"
 
-#include <regex>
+#include <cctype>
+#include <vector>
+#include <algorithm>
 #include <format>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
 #include <filesystem>
+#include "cabin/core/shaderprocesser.h"
 #include "cabin/utils/console.h"
 
+// Shared by `GL_KHR_parallel_shader_compile` and `GL_ARB_parallel_shader_compile`.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Shared by OpenGL 4.6 and `GL_ARB_gl_spirv`.
+#ifndef GL_SHADER_BINARY_FORMAT_SPIR_V
+#define GL_SHADER_BINARY_FORMAT_SPIR_V 0x9551
+#endif
+
 namespace {
     std::string getSourceView(const std::string& src) {
         std::string result {};
@@ -36,250 +51,190 @@ namespace {
         return result;
     }
 
-    class ShaderProcesser {
-    public:
-        struct Result {
-            std::string version {};
-            std::string vertex {};
-            std::string geometory {};
-            std::string fragment {};
-        };
+    //! FNV-1a hash, used to key and validate cached program binaries.
+    uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
 
-    public:
-        ShaderProcesser(const std::string& path) {
-            std::ifstream sourceFile(path);
-            if (!sourceFile.is_open())
-                throw std::runtime_error("failed to open shader file.");
-
-            m_sourceContent << sourceFile.rdbuf();
-            m_baseDirectory = std::filesystem::path(path).parent_path().string();
-            m_entryFileName = std::filesystem::path(path).filename().string();
-            m_blockFileStack = { std::format("{}/{}", m_baseDirectory, m_entryFileName) };
-        }
-
-        Result process() {
-            std::string versionStr = "#version ";
-            std::optional<size_t> versionMarker {};
-
-            std::string vertexBlock {}, geometoryBlock {}, fragmentBlock {};
-            std::optional<size_t> vertexMarker {}, geometoryMarker {}, fragmentMarker {};  
-
-
-            std::string line {};
-            size_t lineNumber = 0;
-            std::string* targetBlock = nullptr;
-
-            try {
-                while (std::getline(m_sourceContent, line)) {
-                    lineNumber += 1;
-
-                    if (isMacro(line)) {
-                        auto [name, param] = idMacro(line);
-                        
-                        if (name.empty()) {
-                            throw std::runtime_error("macro syntax error");
-                        }
-                        else if (name == "version") {
-                            if (versionMarker.has_value())
-                                throw std::runtime_error(std::format(
-                                "version re-decleration (v.s. line {})", versionMarker.value()
-                            ));
-                            
-                            if (param.empty())
-                                throw std::runtime_error("macro \"version\" requires a version string as parameter. (helps: \"#![version(\"...\")]\")");
-
-                            versionStr.append(param);
-                            versionMarker = lineNumber;
-                        }
-                        else if (name == "vertex") {
-                            if (vertexMarker.has_value())
-                                throw std::runtime_error(std::format(
-                                "vertex block re-decleration (v.s. line {})", vertexMarker.value()
-                            ));
-
-                            if (!param.empty())
-                                throw std::runtime_error("extra \"vertex\" macro parameter. (helps: \"#![vertex]\")");
-                            
-                            targetBlock = &vertexBlock;
-                            vertexMarker = lineNumber;
-                        }
-                        else if (name == "geometory") {
-                            if (geometoryMarker.has_value())
-                                throw std::runtime_error(std::format(
-                                "geometory block re-decleration (v.s. line {})", geometoryMarker.value()
-                            ));
-
-                            if (!param.empty())
-                                throw std::runtime_error("extra \"geometory\" macro parameter. (helps: \"#![geometory]\")");
-                            
-                            targetBlock = &geometoryBlock;
-                            geometoryMarker = lineNumber;
-                        }
-                        else if (name == "fragment") {
-                            if (fragmentMarker.has_value())
-                                throw std::runtime_error(std::format(
-                                "fragment block re-decleration (v.s. line {})", fragmentMarker.value()
-                            ));
-
-                            if (!param.empty())
-                                throw std::runtime_error("extra \"fragment\" macro parameter. (helps: \"#![fragment]\")");
-                            
-                            targetBlock = &fragmentBlock;
-                            fragmentMarker = lineNumber;
-                        }
-                        else {
-                            if (!targetBlock)
-                                throw std::runtime_error("out-block macro detected");
-
-                            targetBlock->append(line);
-                            targetBlock->append("\n");
-                        }
-                    }
-                    else if (targetBlock) {
-                        targetBlock->append(line);
-                        targetBlock->append("\n");
-                    }
-                }
-            } catch (const std::exception& e) {
-                throw std::runtime_error(std::format(
-                    "failed to parse shader \"{}\", at line {}: \n    \"{}\"\n  error: {}.",
-                    m_entryFileName, lineNumber, line, e.what()
-                ));
-            }
-            
-            Result processResult {};
-
-            if (versionMarker.has_value())
-                processResult.version = versionStr;
-            else
-                throw std::runtime_error("necessary \"version\" decleration is missing.");
-
-            m_blockFileStack.erase(m_blockFileStack.begin() + 1, m_blockFileStack.end());
-            if (vertexMarker.has_value())
-                processResult.vertex = processBlock(vertexBlock, m_entryFileName, vertexMarker.value());
-            else
-                throw std::runtime_error("necessary \"vertex\" block is missing.");
-
-            m_blockFileStack.erase(m_blockFileStack.begin() + 1, m_blockFileStack.end());
-            if (geometoryMarker.has_value())
-                processResult.geometory = processBlock(geometoryBlock, m_entryFileName, geometoryMarker.value());
-
-            m_blockFileStack.erase(m_blockFileStack.begin() + 1, m_blockFileStack.end());
-            if (fragmentMarker.has_value())
-                processResult.fragment = processBlock(fragmentBlock, m_entryFileName, fragmentMarker.value());
-            else
-                throw std::runtime_error("necessary \"fragment\" block is missing.");
-
-            return processResult;
-        }
-
-    private:
-        std::string processBlock(const std::string& raw, const std::string& fileName, size_t lineOffset) {
-            std::string result {};
-
-            std::stringstream rawStream {};
-            rawStream << raw;
-
-            std::string line {};
-            size_t lineNumber = lineOffset;
-
-            try {
-                while (std::getline(rawStream, line)) {
-                    lineNumber += 1;
-
-                    if (isMacro(line)) {
-                        auto [name, param] = idMacro(line);
-                        
-                        if (name.empty()) {
-                            throw std::runtime_error("macro syntax error");
-                        }
-                        else if (name == "use") {
-                            if (param.empty())
-                                throw std::runtime_error("macro \"use\" requires a path as parameter. (helps: \"#![use(\"...\")]\")");
-
-                            std::string absolutePath = std::format("{}/{}", m_baseDirectory, param);
-                            absolutePath = std::filesystem::absolute(absolutePath).string();
-
-                            // Prevent self-use
-                            if (absolutePath == std::filesystem::absolute(std::format("{}/{}", m_baseDirectory, fileName))) {
-                                throw std::runtime_error("self-use detected");
-                            }
-
-                            // Prevent multi-use
-                            if (std::find(m_blockFileStack.begin(), m_blockFileStack.end(), absolutePath) != m_blockFileStack.end()) {
-                                cabin::utils::Console::info(std::format("muti-use file detected in \"{}\", line {}; ignored.", fileName, lineNumber));\
-                                continue;
-                            }
-
-                            std::ifstream usedFile(absolutePath);
-                            if (!usedFile.is_open())
-                                throw std::runtime_error(std::format("failed to open used file: \"{}\"", param));
-
-                            std::stringstream usedStream {};
-                            usedStream << usedFile.rdbuf();
-
-                            m_blockFileStack.push_back(absolutePath);
-                            result.append(std::format("// ------------- BEGIN QUOTE, FROM {} -------------\n", param));
-                            result.append(processBlock(usedStream.str(), param, 0));
-                            result.append(std::format("// -------------  END QUOTE, FROM {} -------------\n", param));
-                        }
-                        else {
-                            for (auto& macro : std::vector<std::string> { "version", "vertex", "geometory", "fragment" }) {
-                                if (name == macro)
-                                    throw std::runtime_error(std::format("macro \"{}\" only allowed in entry shader", macro));
-                            }
-
-                            throw std::runtime_error(std::format("unrecognized macro \"{}\"", name));
-                        }
-                    }
-                    else {
-                        result.append(line);
-                        result.append("\n");
-                    }
-                }
-            } catch (const std::exception& e) {
-                throw std::runtime_error(std::format(
-                    "failed to parse shader block, in \"{}\", at line {}: \n    \"{}\"\n  error: {}",
-                    fileName, lineNumber, line, e.what()
-                ));
-            }
+    uint64_t hashString(const std::string& str, uint64_t hash = 0xcbf29ce484222325ull) {
+        // Hash the length as well, so that ("ab", "c") differs from ("a", "bc").
+        uint64_t size = str.size();
+        hash = hashBytes(&size, sizeof(size), hash);
+        return hashBytes(str.data(), str.size(), hash);
+    }
+
+    struct ProgramBinaryHeader {
+        char magic[4];
+        uint32_t headerVersion;
+        uint64_t sourceHash;
+        uint64_t binaryChecksum;
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+    };
+
+    const char PROGRAM_BINARY_MAGIC[4] = { 'C', 'B', 'P', 'B' };
+    const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+    std::optional<GLuint> loadProgramBinary(const std::string& path, uint64_t sourceHash) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return std::nullopt;
 
-            return result;
+        ProgramBinaryHeader header {};
+        std::vector<char> binary {};
+
+        std::error_code error;
+        uintmax_t fileSize = std::filesystem::file_size(path, error);
+
+        bool isValid = !error && file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                       std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) == 0 &&
+                       header.headerVersion == PROGRAM_BINARY_VERSION &&
+                       header.binarySize == fileSize - sizeof(header);
+        if (isValid && header.sourceHash != sourceHash) {
+            // Left by an older source of the same shader, which is expected after editing it.
+            cabin::utils::Console::info(std::format("ignored stale program binary \"{}\"", path));
+            return std::nullopt;
+        }
+        if (isValid) {
+            binary.resize(header.binarySize);
+            isValid = file.read(binary.data(), binary.size()) &&
+                      hashBytes(binary.data(), binary.size()) == header.binaryChecksum;
         }
 
-        bool isMacro(const std::string& line) {
-            return std::regex_match(line, m_macroRe);
+        if (!isValid) {
+            cabin::utils::Console::info(std::format("ignored corrupted program binary \"{}\"", path));
+            return std::nullopt;
         }
 
-        std::pair<std::string, std::string> idMacro(const std::string& line) {
-            std::smatch matchRes {};
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
 
-            if (std::regex_match(line, matchRes, m_hintMacroRe)) {
-                return std::make_pair(matchRes[1], "");
-            }
-            else if (std::regex_match(line, matchRes, m_declMacroRe)) {
-                return std::make_pair(matchRes[1], matchRes[2]);
-            }
-            else {
-                return std::make_pair("", "");
-            }
+        // Driver rejects binaries of other formats, or from an updated driver.
+        int isSuccess;
+        glGetProgramiv(program, GL_LINK_STATUS, &isSuccess);
+        if (!isSuccess) {
+            cabin::utils::Console::info(std::format("ignored corrupted program binary \"{}\", rejected by the driver", path));
+            glDeleteProgram(program);
+            return std::nullopt;
         }
 
-    private:
-        std::stringstream m_sourceContent {};
-        std::string m_baseDirectory {};
-        std::string m_entryFileName {};
+        return program;
+    }
 
-        std::vector<std::string> m_blockFileStack {};
+    bool hasExtension(const char* name) {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
 
-        std::regex m_macroRe { R"(^\s*#![\S\s]*$)" }; 
-        std::regex m_hintMacroRe { R"(^\s*#!\[\s*(\w+)\s*\]$)" };
-        std::regex m_declMacroRe { R"(^\s*#!\[\s*(\w+)\s*\(\s*\"([\w\s\.\\//]*)\"\s*\)\s*\]$)"};
-    };
+        for (GLint i = 0; i < extensionCount; i++) {
+            auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    //! Whether the driver compiles and links in background, and reports `GL_COMPLETION_STATUS_KHR`.
+    bool hasParallelShaderCompile() {
+        static const bool isSupported = hasExtension("GL_KHR_parallel_shader_compile") ||
+                                        hasExtension("GL_ARB_parallel_shader_compile");
+        return isSupported;
+    }
+
+    //! Whether the driver accepts SPIR-V modules, core since OpenGL 4.6.
+    bool hasGlSpirv() {
+        static const bool isSupported = [] {
+            GLint major = 0, minor = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major);
+            glGetIntegerv(GL_MINOR_VERSION, &minor);
+            return major > 4 || (major == 4 && minor >= 6) || hasExtension("GL_ARB_gl_spirv");
+        }();
+
+        return isSupported;
+    }
+
+    const uint32_t SPIRV_MAGIC = 0x07230203;
+
+    /** Load and specialize a SPIR-V module into the shader object.
+     *
+     * @return Whether the shader object is compiled from the module.
+     */
+    bool loadSpirvModule(GLuint stage, const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+
+        std::vector<uint32_t> module (static_cast<size_t>(file.tellg()) / sizeof(uint32_t));
+        file.seekg(0);
+
+        bool isValid = !module.empty() &&
+                       file.read(reinterpret_cast<char*>(module.data()), module.size() * sizeof(uint32_t)) &&
+                       module[0] == SPIRV_MAGIC;
+        if (!isValid) {
+            cabin::utils::Console::info(std::format("ignored corrupted SPIR-V module \"{}\"", path));
+            return false;
+        }
+
+        glShaderBinary(1, &stage, GL_SHADER_BINARY_FORMAT_SPIR_V, module.data(), static_cast<GLsizei>(module.size() * sizeof(uint32_t)));
+        glSpecializeShader(stage, "main", 0, nullptr, nullptr);
+
+        int isSuccess;
+        glGetShaderiv(stage, GL_COMPILE_STATUS, &isSuccess);
+        if (!isSuccess) {
+            char statusLog[2048];
+            glGetShaderInfoLog(stage, 2048, nullptr, statusLog);
+            cabin::utils::Console::info(std::format("ignored mismatched SPIR-V module \"{}\"\n{}", path, statusLog));
+            return false;
+        }
+
+        return true;
+    }
+
+    void saveProgramBinary(const std::string& path, GLuint program, uint64_t sourceHash) {
+        GLint binarySize = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+        if (binarySize <= 0)
+            return;
+
+        ProgramBinaryHeader header {};
+        std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+        header.headerVersion = PROGRAM_BINARY_VERSION;
+        header.sourceHash = sourceHash;
+
+        std::vector<char> binary (binarySize);
+        GLenum binaryFormat;
+        glGetProgramBinary(program, binarySize, nullptr, &binaryFormat, binary.data());
+        header.binaryFormat = binaryFormat;
+        header.binarySize = static_cast<uint32_t>(binary.size());
+        header.binaryChecksum = hashBytes(binary.data(), binary.size());
+
+        // Write into a temporary file first, so that a broken write never leaves a truncated binary.
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), binary.size());
+            if (!file.good()) {
+                cabin::utils::Console::info(std::format("failed to write program binary \"{}\"", path));
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, path, error);
+    }
 }
 
 namespace cabin::core {
 
+    //! Uniform uploads of all shaders, since last reset.
+    static Shader::UniformStatistics uniformStatistics {};
+
     Shader::Builder& Shader::Builder::fromFile(const std::string& path) {
         utils::Console::info(std::format("loading shader \"{}\"", path));
 
@@ -291,9 +246,33 @@ namespace cabin::core {
         return *this;
     }
 
+    Shader::Builder& Shader::Builder::setBinaryCache(const std::string& directory) {
+        m_binaryCacheDirectory = directory;
+        return *this;
+    }
+
+    Shader::Builder& Shader::Builder::setSpirvDirectory(const std::string& directory) {
+        m_spirvDirectory = directory;
+        return *this;
+    }
+
+    Shader::Builder& Shader::Builder::setFeatures(uint32_t featureMask) {
+        m_featureMask = featureMask;
+        return *this;
+    }
+
     Shader Shader::Builder::build() {
+        return buildAsync().get();
+    }
+
+    PendingShader Shader::Builder::buildAsync() {
+        PendingShader pending {};
+        pending.m_filePath = m_filePath;
+        pending.m_binaryCacheDirectory = m_binaryCacheDirectory;
+        pending.m_spirvDirectory = m_spirvDirectory;
+
         // 1. Parse source into different stages
-        std::string version, vertex, geometory, fragment;
+        std::string version, vertex, geometory, fragment, compute;
 
         ShaderProcesser::Result processResult {};
         processResult = ShaderProcesser(m_filePath).process();
@@ -302,90 +281,230 @@ namespace cabin::core {
         vertex.swap(processResult.vertex);
         geometory.swap(processResult.geometory);
         fragment.swap(processResult.fragment);
+        compute.swap(processResult.compute);
         version.append("\n");
+        pending.m_isCompute = !compute.empty();
+        pending.m_dependencies.swap(processResult.dependencies);
+
+        // Define enabled features right after the version, so that all stages see them.
+        const auto& features = processResult.features;
+        if (features.size() < ShaderProcesser::MAX_FEATURE_COUNT && (m_featureMask >> features.size()) != 0) {
+            throw std::runtime_error(std::format("shader \"{}\" has no feature of mask {:#x}", m_filePath, m_featureMask));
+        }
+        for (size_t i = 0; i < features.size(); i++) {
+            if (m_featureMask & (1u << i))
+                version.append(std::format("#define {}\n", features[i]));
+        }
+        pending.m_features.swap(processResult.features);
+        pending.m_featureMask = m_featureMask;
+
+        // 2. Load program from binary cache
+        if (!m_binaryCacheDirectory.empty()) {
+            uint64_t sourceHash = hashString(version);
+            sourceHash = hashString(vertex, sourceHash);
+            sourceHash = hashString(geometory, sourceHash);
+            sourceHash = hashString(fragment, sourceHash);
+            sourceHash = hashString(compute, sourceHash);
+            sourceHash = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), sourceHash);
+            sourceHash = hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), sourceHash);
+
+            // One binary per shader file and variant, so that an edited shader replaces its stale binary.
+            uint64_t variantHash = hashString(m_filePath);
+            variantHash = hashBytes(&m_featureMask, sizeof(m_featureMask), variantHash);
+
+            pending.m_sourceHash = sourceHash;
+            pending.m_binaryCachePath = std::format("{}/{:016x}.bin", m_binaryCacheDirectory, variantHash);
+
+            pending.m_program = loadProgramBinary(pending.m_binaryCachePath, sourceHash);
+            if (pending.m_program.has_value()) {
+                pending.m_binaryCachePath.clear();
+                return pending;
+            }
+        }
         
-        // 2. Create shader program object
-        auto checkCompileStatus = [&](GLuint id, const char* stage, const std::string& source) {
+        // 3. Submit stages and program, statuses are queried by `PendingShader::get`
+        struct StageSource {
+            GLenum type;
+            const char* name;
+            std::string source;
+        };
+
+        std::vector<StageSource> stageSources {};
+        if (pending.m_isCompute) {
+            stageSources.push_back({ GL_COMPUTE_SHADER, "compute", version + compute });
+        }
+        else {
+            stageSources.push_back({ GL_VERTEX_SHADER, "vertex", version + vertex });
+            if (geometory.size())
+                stageSources.push_back({ GL_GEOMETRY_SHADER, "geometory", version + geometory });
+            stageSources.push_back({ GL_FRAGMENT_SHADER, "fragment", version + fragment });
+        }
+
+        // Prefer the pre-compiled modules, skipping the GLSL front-end of the driver.
+        // SPIR-V and GLSL stages can't be linked together, so one unusable module falls back all stages.
+        bool isSpirvLoaded = false;
+        if (!m_spirvDirectory.empty() && hasGlSpirv()) {
+            isSpirvLoaded = true;
+            for (const auto& stageSource : stageSources) {
+                std::string modulePath = std::format("{}/{}.spv", m_spirvDirectory, getSpirvModuleName(stageSource.source));
+
+                GLuint stage = glCreateShader(stageSource.type);
+                pending.m_stages.push_back({ stage, stageSource.name, stageSource.source });
+                if (!loadSpirvModule(stage, modulePath)) {
+                    utils::Console::info(std::format("compiling shader \"{}\" from GLSL, SPIR-V module \"{}\" isn't usable",
+                                                     m_filePath, modulePath));
+                    isSpirvLoaded = false;
+                    break;
+                }
+            }
+
+            if (!isSpirvLoaded) {
+                for (const auto& stage : pending.m_stages)
+                    glDeleteShader(stage.id);
+                pending.m_stages.clear();
+            }
+        }
+
+        if (!isSpirvLoaded) {
+            for (auto& stageSource : stageSources) {
+                const char* stageSrcPtr = stageSource.source.c_str();
+
+                GLuint stage = glCreateShader(stageSource.type);
+                glShaderSource(stage, 1, &stageSrcPtr, nullptr);
+                glCompileShader(stage);
+
+                pending.m_stages.push_back({ stage, stageSource.name, std::move(stageSource.source) });
+            }
+        }
+
+        GLuint program = glCreateProgram();
+        for (const auto& stage : pending.m_stages)
+            glAttachShader(program, stage.id);
+        if (!pending.m_binaryCachePath.empty())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+
+        pending.m_program = program;
+        return pending;
+    }
+
+    PendingShader::PendingShader(PendingShader&& right) noexcept {
+        *this = std::move(right);
+    }
+
+    PendingShader& PendingShader::operator=(PendingShader&& right) noexcept {
+        m_program.swap(right.m_program);
+        m_stages.swap(right.m_stages);
+        m_binaryCachePath.swap(right.m_binaryCachePath);
+        std::swap(m_sourceHash, right.m_sourceHash);
+        m_filePath.swap(right.m_filePath);
+        m_binaryCacheDirectory.swap(right.m_binaryCacheDirectory);
+        m_spirvDirectory.swap(right.m_spirvDirectory);
+        m_dependencies.swap(right.m_dependencies);
+        m_features.swap(right.m_features);
+        std::swap(m_featureMask, right.m_featureMask);
+        std::swap(m_isCompute, right.m_isCompute);
+
+        return *this;
+    }
+
+    PendingShader::~PendingShader() {
+        for (const auto& stage : m_stages)
+            glDeleteShader(stage.id);
+        m_stages.clear();
+
+        if (m_program.has_value()) {
+            glDeleteProgram(m_program.value());
+            m_program.reset();
+        }
+    }
+
+    bool PendingShader::isReady() const {
+        if (!m_program.has_value() || m_stages.empty() || !hasParallelShaderCompile())
+            return true;
+
+        int isCompleted;
+        glGetProgramiv(m_program.value(), GL_COMPLETION_STATUS_KHR, &isCompleted);
+        return isCompleted;
+    }
+
+    Shader PendingShader::get() {
+        if (!m_program.has_value()) {
+            throw std::runtime_error("shader is not pending");
+        }
+
+        // Loaded from binary cache
+        if (m_stages.empty()) {
+            GLuint program = m_program.value();
+            m_program.reset();
+            return makeShader(program);
+        }
+
+        // A failed stage also fails linking, report the stage itself first.
+        for (const auto& stage : m_stages) {
             int isSuccess;
             char statusLog[2048];
             
-            glGetShaderiv(id, GL_COMPILE_STATUS, &isSuccess);
+            glGetShaderiv(stage.id, GL_COMPILE_STATUS, &isSuccess);
             if (!isSuccess) {
-                glGetShaderInfoLog(id, 2048, nullptr, statusLog);
+                glGetShaderInfoLog(stage.id, 2048, nullptr, statusLog);
                 throw std::runtime_error(
                     std::format(
                         "failed to compile shader's {} block!\n{}\n{}",
-                        stage, getSourceView(source), statusLog
+                        stage.name, getSourceView(stage.source), statusLog
                     )
                 );
             }
-        };
-
-        std::string vertexSrc = version + vertex;
-        std::string fragmentSrc = version + fragment;
-
-        const char* vertexSrcPtr = vertexSrc.c_str();
-        const char* fragmentSrcPtr = fragmentSrc.c_str();
-
-        GLuint vertexShader, fragmentShader, geometoryShader;
-
-        vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &vertexSrcPtr, nullptr);
-        glCompileShader(vertexShader);
-        checkCompileStatus(vertexShader, "vertex", vertexSrc);
-
-        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &fragmentSrcPtr, nullptr);
-        glCompileShader(fragmentShader);
-        checkCompileStatus(fragmentShader, "fragment", fragmentSrc);
-
-        if (geometory.size()) {
-            std::string geometorySrc = version + geometory;
-            const char* geometorySrcPtr = geometorySrc.c_str();
-            
-            geometoryShader = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometoryShader, 1, &geometorySrcPtr, nullptr);
-            glCompileShader(geometoryShader);
-            checkCompileStatus(geometoryShader, "geometory", geometorySrc);
         }
 
-        id = glCreateProgram();
-        glAttachShader(id, vertexShader);
-        glAttachShader(id, fragmentShader);
-        if (geometory.size())
-            glAttachShader(id, geometoryShader);
-        glLinkProgram(id);
-
         int isSuccess;
         char statusLog[2048];
-        glGetProgramiv(id, GL_LINK_STATUS, &isSuccess);
+        glGetProgramiv(m_program.value(), GL_LINK_STATUS, &isSuccess);
         if (!isSuccess) {
-            glGetProgramInfoLog(id, 2048, nullptr, statusLog);
+            glGetProgramInfoLog(m_program.value(), 2048, nullptr, statusLog);
             
-            std::string vertexSrcView = "\n>>> Vertex Shader Source <<<\n" + getSourceView(vertexSrc);
-            std::string fragSrcView = "\n>>> Fragment Shader Source <<<\n" + getSourceView(fragmentSrc);
-            std::string geometorySrcView {};
-            if (!geometory.empty())
-                geometorySrcView = "\n>>> Geometory Shader Source <<<\n" + getSourceView(version + geometory);
+            std::string sourceViews {};
+            for (const auto& stage : m_stages) {
+                std::string title = stage.name;
+                title[0] = static_cast<char>(std::toupper(title[0]));
+                sourceViews.append(std::format("\n>>> {} Shader Source <<<\n{}", title, getSourceView(stage.source)));
+            }
 
             throw std::runtime_error(
-                std::format(
-                    "failed to link shader!\n{}{}{}\n{}", 
-                    vertexSrcView, geometorySrcView, fragSrcView, statusLog
-                )
+                std::format("failed to link shader!\n{}\n{}", sourceViews, statusLog)
             );
         }
 
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-        if (geometory.size())
-            glDeleteShader(geometoryShader);
+        for (const auto& stage : m_stages)
+            glDeleteShader(stage.id);
+        m_stages.clear();
+
+        GLuint program = m_program.value();
+        m_program.reset();
+
+        // 4. Store program into binary cache
+        if (!m_binaryCachePath.empty())
+            saveProgramBinary(m_binaryCachePath, program, m_sourceHash);
+
+        return makeShader(program);
+    }
 
-        return Shader { id };
+    Shader PendingShader::makeShader(GLuint program) {
+        Shader shader { program };
+        shader.m_filePath.swap(m_filePath);
+        shader.m_binaryCacheDirectory.swap(m_binaryCacheDirectory);
+        shader.m_spirvDirectory.swap(m_spirvDirectory);
+        shader.m_dependencies.swap(m_dependencies);
+        shader.m_features.swap(m_features);
+        shader.m_featureMask = m_featureMask;
+        shader.m_isCompute = m_isCompute;
+        return shader;
     }
 
     Shader::Shader(GLuint id)
-    : id(id) {}
+    : id(id) {
+        loadUniformLocations();
+    }
 
     Shader::~Shader() {
         if (id.has_value()) {
@@ -400,6 +519,16 @@ namespace cabin::core {
         }
         id = right.id;
         right.id.reset();
+        m_uniformLocations.swap(right.m_uniformLocations);
+        m_uniformShadows.swap(right.m_uniformShadows);
+        m_filePath.swap(right.m_filePath);
+        m_binaryCacheDirectory.swap(right.m_binaryCacheDirectory);
+        m_spirvDirectory.swap(right.m_spirvDirectory);
+        m_dependencies.swap(right.m_dependencies);
+        m_features.swap(right.m_features);
+        std::swap(m_featureMask, right.m_featureMask);
+        std::swap(m_isCompute, right.m_isCompute);
+        m_variants.swap(right.m_variants);
     }
     
     Shader& Shader::operator=(Shader&& right) noexcept {
@@ -408,43 +537,272 @@ namespace cabin::core {
         }
         id = right.id;
         right.id.reset();
+        m_uniformLocations.swap(right.m_uniformLocations);
+        right.m_uniformLocations.clear();
+        m_uniformShadows.swap(right.m_uniformShadows);
+        m_filePath.swap(right.m_filePath);
+        m_binaryCacheDirectory.swap(right.m_binaryCacheDirectory);
+        m_spirvDirectory.swap(right.m_spirvDirectory);
+        m_dependencies.swap(right.m_dependencies);
+        m_features.swap(right.m_features);
+        std::swap(m_featureMask, right.m_featureMask);
+        std::swap(m_isCompute, right.m_isCompute);
+        m_variants.swap(right.m_variants);
 
         return *this;
     }
 
+    void Shader::loadUniformLocations() {
+        GLint uniformCount = 0;
+        glGetProgramInterfaceiv(id.value(), GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+
+        // Values of a fresh program are unknown to the shadow, so that the first set always uploads.
+        GLint maxLocation = -1;
+
+        static const GLenum properties[] = { GL_NAME_LENGTH, GL_ARRAY_SIZE, GL_BLOCK_INDEX, GL_LOCATION };
+        for (GLint i = 0; i < uniformCount; i++) {
+            GLint values[4] {};
+            glGetProgramResourceiv(id.value(), GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+
+            // Members of uniform blocks have no location.
+            if (values[2] != -1 || values[3] < 0)
+                continue;
+            maxLocation = std::max(maxLocation, values[3] + values[1] - 1);
+
+            // Programs from SPIR-V modules may have no uniform names.
+            if (values[0] <= 1)
+                continue;
+
+            std::string name (values[0], '\0');
+            glGetProgramResourceName(id.value(), GL_UNIFORM, i, values[0], nullptr, name.data());
+            name.resize(values[0] - 1);
+
+            GLint location = glGetUniformLocation(id.value(), name.c_str());
+            if (location < 0)
+                continue;
+
+            // Array uniforms are reported as `name[0]`, record the bare name and every element.
+            if (name.ends_with("[0]")) {
+                std::string baseName = name.substr(0, name.size() - 3);
+                m_uniformLocations[baseName] = location;
+
+                for (GLint j = 0; j < values[1]; j++) {
+                    std::string elementName = std::format("{}[{}]", baseName, j);
+                    m_uniformLocations[elementName] = glGetUniformLocation(id.value(), elementName.c_str());
+                }
+            }
+            else {
+                m_uniformLocations[name] = location;
+            }
+        }
+
+        m_uniformShadows.assign(static_cast<size_t>(maxLocation + 1), UniformShadow {});
+    }
+
     void Shader::bind() const {
         glUseProgram(id.value());
     }
 
-    void Shader::setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(id.value(), name.c_str()), value);
+    bool Shader::reload() {
+        if (m_filePath.empty())
+            return false;
+
+        try {
+            Shader reloaded = Builder()
+                                .fromFile(m_filePath)
+                                .setBinaryCache(m_binaryCacheDirectory)
+                                .setSpirvDirectory(m_spirvDirectory)
+                                .setFeatures(m_featureMask)
+                                .build();
+
+            // A `ComputeShader` may be reloaded through `Shader`, keep its program compute.
+            if (reloaded.isCompute() != m_isCompute)
+                throw std::runtime_error("reloaded shader changed between compute and render stages");
+            *this = std::move(reloaded);
+            return true;
+        } catch (const std::exception& e) {
+            utils::Console::error(std::format("failed to reload shader \"{}\", keeping the old program.\n{}", m_filePath, e.what()));
+            return false;
+        }
+    }
+
+    const std::vector<std::string>& Shader::getDependencies() const {
+        return m_dependencies;
+    }
+
+    bool Shader::isCompute() const {
+        return m_isCompute;
+    }
+
+    Shader::Feature Shader::getFeature(std::string_view name) const {
+        auto iter = std::find(m_features.begin(), m_features.end(), name);
+        if (iter == m_features.end())
+            return Feature {};
+
+        return Feature { 1u << (iter - m_features.begin()) };
+    }
+
+    const Shader& Shader::getVariant(uint32_t featureMask) const {
+        if (featureMask == m_featureMask)
+            return *this;
+
+        auto iter = m_variants.find(featureMask);
+        if (iter != m_variants.end())
+            return *iter->second;
+
+        if (m_filePath.empty()) {
+            throw std::runtime_error("shader variant requires a shader built from file");
+        }
+
+        auto variant = std::make_unique<Shader>(
+            Builder()
+                .fromFile(m_filePath)
+                .setBinaryCache(m_binaryCacheDirectory)
+                .setSpirvDirectory(m_spirvDirectory)
+                .setFeatures(featureMask)
+                .build()
+        );
+        return *m_variants.emplace(featureMask, std::move(variant)).first->second;
+    }
+
+    Shader::Uniform Shader::getUniform(std::string_view name) const {
+        auto iter = m_uniformLocations.find(name);
+        if (iter == m_uniformLocations.end())
+            return Uniform {};
+        
+        return Uniform { iter->second };
+    }
+
+    void Shader::setInt(std::string_view name, int value) const {
+        setInt(getUniform(name), value);
+    }
+
+    void Shader::setFloat(std::string_view name, float value) const {
+        setFloat(getUniform(name), value);
+    }
+
+    void Shader::setVec2(std::string_view name, glm::vec2 value) const {
+        setVec2(getUniform(name), value);
+    }
+
+    void Shader::setVec3(std::string_view name, glm::vec3 value) const {
+        setVec3(getUniform(name), value);
+    }
+
+    void Shader::setVec4(std::string_view name, glm::vec4 value) const {
+        setVec4(getUniform(name), value);
+    }
+
+    void Shader::setMat2(std::string_view name, glm::mat2 value) const {
+        setMat2(getUniform(name), value);
+    }
+
+    void Shader::setMat3(std::string_view name, glm::mat3 value) const {
+        setMat3(getUniform(name), value);
+    }
+
+    void Shader::setMat4(std::string_view name, glm::mat4 value) const {
+        setMat4(getUniform(name), value);
+    }
+
+    void Shader::setInt(Uniform uniform, int value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniform1i(id.value(), uniform.location, value);
+    }
+
+    void Shader::setFloat(Uniform uniform, float value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniform1f(id.value(), uniform.location, value);
+    }
+
+    void Shader::setVec2(Uniform uniform, glm::vec2 value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniform2fv(id.value(), uniform.location, 1, &value[0]);
+    }
+
+    void Shader::setVec3(Uniform uniform, glm::vec3 value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniform3fv(id.value(), uniform.location, 1, &value[0]);
+    }
+
+    void Shader::setVec4(Uniform uniform, glm::vec4 value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniform4fv(id.value(), uniform.location, 1, &value[0]);
+    }
+
+    void Shader::setMat2(Uniform uniform, glm::mat2 value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniformMatrix2fv(id.value(), uniform.location, 1, GL_FALSE, &value[0][0]);
+    }
+
+    void Shader::setMat3(Uniform uniform, glm::mat3 value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniformMatrix3fv(id.value(), uniform.location, 1, GL_FALSE, &value[0][0]);
+    }
+
+    void Shader::setMat4(Uniform uniform, glm::mat4 value) const {
+        if (updateShadow(uniform.location, &value, sizeof(value)))
+            glProgramUniformMatrix4fv(id.value(), uniform.location, 1, GL_FALSE, &value[0][0]);
+    }
+
+    bool Shader::updateShadow(GLint location, const void* value, size_t size) const {
+        if (location < 0)
+            return false;
+
+        // Locations unknown to the shadow are always uploaded.
+        if (static_cast<size_t>(location) >= m_uniformShadows.size()) {
+            uniformStatistics.uploads++;
+            return true;
+        }
+
+        UniformShadow& shadow = m_uniformShadows[location];
+        if (shadow.size == size && std::memcmp(shadow.value, value, size) == 0) {
+            uniformStatistics.skips++;
+            return false;
+        }
+
+        shadow.size = static_cast<uint32_t>(size);
+        std::memcpy(shadow.value, value, size);
+        uniformStatistics.uploads++;
+        return true;
+    }
+
+    Shader::UniformStatistics Shader::getUniformStatistics() {
+        return uniformStatistics;
     }
 
-    void Shader::setFloat(const std::string& name, float value) const {
-        glUniform1f(glGetUniformLocation(id.value(), name.c_str()), value);
+    void Shader::resetUniformStatistics() {
+        uniformStatistics = {};
     }
 
-    void Shader::setVec2(const std::string& name, glm::vec2 value) const {
-        glUniform2fv(glGetUniformLocation(id.value(), name.c_str()), 1, &value[0]);
+    std::string Shader::getSpirvModuleName(const std::string& stageSource) {
+        return std::format("{:016x}", hashString(stageSource));
     }
 
-    void Shader::setVec3(const std::string& name, glm::vec3 value) const {
-        glUniform3fv(glGetUniformLocation(id.value(), name.c_str()), 1, &value[0]);
+    ComputeShader::ComputeShader(Shader&& shader)
+    : Shader(std::move(shader)) {
+        if (id.has_value() && !isCompute()) {
+            throw std::runtime_error("shader has no compute block");
+        }
     }
 
-    void Shader::setVec4(const std::string& name, glm::vec4 value) const {
-        glUniform4fv(glGetUniformLocation(id.value(), name.c_str()), 1, &value[0]);
+    glm::uvec3 ComputeShader::getWorkGroupSize() const {
+        GLint size[3] {};
+        glGetProgramiv(id.value(), GL_COMPUTE_WORK_GROUP_SIZE, size);
+        return glm::uvec3(glm::ivec3(size[0], size[1], size[2]));
     }
 
-    void Shader::setMat2(const std::string& name, glm::mat2 value) const {
-        glUniformMatrix2fv(glGetUniformLocation(id.value(), name.c_str()), 1, GL_FALSE, &value[0][0]);
+    void ComputeShader::dispatch(GLuint x, GLuint y, GLuint z) const {
+        bind();
+        glDispatchCompute(x, y, z);
     }
 
-    void Shader::setMat3(const std::string& name, glm::mat3 value) const {
-        glUniformMatrix3fv(glGetUniformLocation(id.value(), name.c_str()), 1, GL_FALSE, &value[0][0]);
+    void ComputeShader::dispatchThreads(GLuint x, GLuint y, GLuint z) const {
+        glm::uvec3 size = getWorkGroupSize();
+        dispatch((x + size.x - 1) / size.x, (y + size.y - 1) / size.y, (z + size.z - 1) / size.z);
     }
 
-    void Shader::setMat4(const std::string& name, glm::mat4 value) const {
-        glUniformMatrix4fv(glGetUniformLocation(id.value(), name.c_str()), 1, GL_FALSE, &value[0][0]);
+    void ComputeShader::barrier(GLbitfield barriers) {
+        glMemoryBarrier(barriers);
     }
-}
\ No newline at end of file
+}
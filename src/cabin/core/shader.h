@@ -7,13 +7,20 @@
 
 #pragma once
 #include <string>
+#include <cstdint>
 #include <sstream>
+#include <vector>
+#include <memory>
 #include <optional>
+#include <string_view>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
 namespace cabin::core {
 
+    class PendingShader;
+
     class Shader {
     public:
         class Builder {
@@ -24,15 +31,87 @@ namespace cabin::core {
 
             /** Create the shader from source file.
              * 
-             * @param path Path of shader source file.
+             * @param path Path of shader source file, or of a bundle written by `cabin-shaderc`.
              */
             Builder& fromFile(const std::string& path);
 
+            /** Enable the on-disk program binary cache.
+             *
+             * @param directory Directory storing cached program binaries.
+             *
+             * @note Binaries are stored per shader file and feature mask, and
+             *       checked against the preprocessed sources, `GL_RENDERER` and
+             *       `GL_VERSION`. Stale or corrupted binaries fall back to a
+             *       normal compilation, and are replaced afterwards.
+             */
+            Builder& setBinaryCache(const std::string& directory);
+
+            /** Load stages from pre-compiled SPIR-V modules if `GL_ARB_gl_spirv` is supported.
+             *
+             * @param directory Directory storing SPIR-V modules.
+             *
+             * @note Modules are keyed by the preprocessed stage sources, as
+             *       `{directory}/{hash}.spv`, and compiled at build time from
+             *       the sources exported by `cabin-shaderc -m`, e.g. with
+             *       `glslangValidator -G {hash}.frag -o {hash}.spv`, which needs
+             *       GLSL 450 or later. If a stage has no valid module, all stages
+             *       of the program fall back to GLSL, as SPIR-V and GLSL stages
+             *       can't be linked together.
+             *
+             * @note SPIR-V drops uniform names, so uniforms outside blocks need
+             *       explicit `layout(location = ...)`, and are set by handles
+             *       built from their locations.
+             */
+            Builder& setSpirvDirectory(const std::string& directory);
+
+            /** Select the variant of the shader.
+             *
+             * @param featureMask Bit `i` enables the `i`-th declared `#![feature]`.
+             */
+            Builder& setFeatures(uint32_t featureMask);
+
             Shader build();
 
+            /** Submit all stages of the shader without waiting for the driver.
+             *
+             * @note Compile and link errors are reported by `PendingShader::get`.
+             *       Submitting several programs before polling any of them lets
+             *       drivers supporting `GL_KHR_parallel_shader_compile` compile
+             *       them concurrently.
+             */
+            PendingShader buildAsync();
+
         private:
             GLuint id;
             std::string m_filePath {};
+            std::string m_binaryCacheDirectory {};
+            std::string m_spirvDirectory {};
+            uint32_t m_featureMask { 0 };
+        };
+
+    public:
+        /** Handle of an active uniform.
+         *
+         * @note Resolved once by `getUniform`, so that setters taking
+         *       a handle skip the name lookup entirely.
+         */
+        struct Uniform {
+            GLint location { -1 };
+        };
+
+        /** Handle of a declared `#![feature]`.
+         *
+         * @note Features not declared by the shader have an empty mask,
+         *       so that enabling them selects the same variant.
+         */
+        struct Feature {
+            uint32_t mask { 0 };
+        };
+
+        //! Uniform uploads issued and skipped by all shaders.
+        struct UniformStatistics {
+            size_t uploads { 0 };
+            size_t skips { 0 };
         };
 
     public:
@@ -48,16 +127,206 @@ namespace cabin::core {
         //! Bind to this shader program. (wrapper of `glBindShaderProgram`)
         void bind() const;
 
-        void setInt(const std::string& name, int value) const;
-        void setFloat(const std::string& name, float value) const;
-        void setVec2(const std::string& name, glm::vec2 value) const;
-        void setVec3(const std::string& name, glm::vec3 value) const;
-        void setVec4(const std::string& name, glm::vec4 value) const;
-        void setMat2(const std::string& name, glm::mat2 value) const;
-        void setMat3(const std::string& name, glm::mat3 value) const;
-        void setMat4(const std::string& name, glm::mat4 value) const;
-    
+        /** Rebuild the program from its source file.
+         *
+         * @note The old program is kept if the new one fails to build,
+         *       and the error is logged instead of thrown.
+         *
+         * @return Whether the program is replaced.
+         */
+        bool reload();
+
+        //! Get the entry file and used files of the shader, as normalized absolute paths.
+        const std::vector<std::string>& getDependencies() const;
+
+        //! Whether the shader is built from a `#![compute]` block.
+        bool isCompute() const;
+
+        //! Get the handle of a declared feature.
+        Feature getFeature(std::string_view name) const;
+
+        /** Get the variant of the shader enabling the features in the mask.
+         *
+         * @note Variants are built on first use, and cached by their mask.
+         *       The shader itself is the variant of its own mask.
+         *
+         * @throw `std::runtime_error` if the variant fails to build.
+         */
+        const Shader& getVariant(uint32_t featureMask) const;
+
+        /** Get the handle of an active uniform.
+         *
+         * @param name Uniform name, array elements can be named as `name[i]`.
+         *
+         * @note Returns a handle with location `-1` if the uniform is not
+         *       active, which makes the setters silently ignore it.
+         */
+        Uniform getUniform(std::string_view name) const;
+
+        // Setters target this program whether it is bound or not, and skip
+        // uploading values equal to the CPU-side shadow of the uniform.
+
+        void setInt(std::string_view name, int value) const;
+        void setFloat(std::string_view name, float value) const;
+        void setVec2(std::string_view name, glm::vec2 value) const;
+        void setVec3(std::string_view name, glm::vec3 value) const;
+        void setVec4(std::string_view name, glm::vec4 value) const;
+        void setMat2(std::string_view name, glm::mat2 value) const;
+        void setMat3(std::string_view name, glm::mat3 value) const;
+        void setMat4(std::string_view name, glm::mat4 value) const;
+
+        void setInt(Uniform uniform, int value) const;
+        void setFloat(Uniform uniform, float value) const;
+        void setVec2(Uniform uniform, glm::vec2 value) const;
+        void setVec3(Uniform uniform, glm::vec3 value) const;
+        void setVec4(Uniform uniform, glm::vec4 value) const;
+        void setMat2(Uniform uniform, glm::mat2 value) const;
+        void setMat3(Uniform uniform, glm::mat3 value) const;
+        void setMat4(Uniform uniform, glm::mat4 value) const;
+
+        //! Get uniform uploads issued and skipped since last reset, e.g. in last frame.
+        static UniformStatistics getUniformStatistics();
+
+        //! Reset the uniform statistics, e.g. at the beginning of a frame.
+        static void resetUniformStatistics();
+
+        /** Get the file name of the SPIR-V module of a stage, without extension.
+         *
+         * @param stageSource Stage source as compiled, i.e. the `#version` line,
+         *                    defines of enabled features, then the stage.
+         *
+         * @note `cabin-shaderc -m` names exported stage sources the same way.
+         */
+        static std::string getSpirvModuleName(const std::string& stageSource);
+
+    private:
+        friend class PendingShader;
+
+        //! Enumerate active uniforms of the linked program, and record their locations.
+        void loadUniformLocations();
+
+        /** Record the value in the uniform's shadow.
+         *
+         * @return Whether the value differs from the shadow, and should be uploaded.
+         */
+        bool updateShadow(GLint location, const void* value, size_t size) const;
+
+        //! Last uploaded value of a uniform location, large enough for a `mat4`.
+        struct UniformShadow {
+            uint32_t size { 0 };
+            unsigned char value[sizeof(glm::mat4)];
+        };
+
+        //! Hash allowing `std::string_view` lookups without building a `std::string`.
+        struct UniformNameHash {
+            using is_transparent = void;
+            size_t operator()(std::string_view name) const noexcept {
+                return std::hash<std::string_view> {}(name);
+            }
+        };
+
     public:
         std::optional<GLuint> id;
+
+    private:
+        std::unordered_map<std::string, GLint, UniformNameHash, std::equal_to<>> m_uniformLocations {};
+        mutable std::vector<UniformShadow> m_uniformShadows {};
+        std::string m_filePath {};
+        std::string m_binaryCacheDirectory {};
+        std::string m_spirvDirectory {};
+        std::vector<std::string> m_dependencies {};
+
+        std::vector<std::string> m_features {};
+        uint32_t m_featureMask { 0 };
+        bool m_isCompute { false };
+        mutable std::unordered_map<uint32_t, std::unique_ptr<Shader>> m_variants {};
+    };
+
+    /** Shader program being compiled and linked by the driver.
+     *
+     * @note Created by `Shader::Builder::buildAsync`.
+     */
+    class PendingShader {
+    public:
+        PendingShader() = default;
+        PendingShader(PendingShader&& right) noexcept;
+        PendingShader& operator=(PendingShader&& right) noexcept;
+        PendingShader(const PendingShader&) = delete;
+        PendingShader& operator=(const PendingShader&) = delete;
+
+        ~PendingShader();
+
+        /** Check whether the program is built, without blocking.
+         *
+         * @note Queries `GL_COMPLETION_STATUS_KHR` if `GL_KHR_parallel_shader_compile`
+         *       is supported, otherwise always returns `true` and `get` blocks.
+         */
+        bool isReady() const;
+
+        /** Take the built shader, blocks until the driver finishes.
+         *
+         * @throw `std::runtime_error` if any stage fails to compile or link.
+         */
+        Shader get();
+
+    private:
+        friend class Shader::Builder;
+
+        //! Create the shader of the built program, remembering where it comes from.
+        Shader makeShader(GLuint program);
+
+        struct Stage {
+            GLuint id;
+            const char* name;
+            std::string source;
+        };
+
+        std::optional<GLuint> m_program {};
+        std::vector<Stage> m_stages {};
+        std::string m_binaryCachePath {};
+        uint64_t m_sourceHash { 0 };
+
+        std::string m_filePath {};
+        std::string m_binaryCacheDirectory {};
+        std::string m_spirvDirectory {};
+        std::vector<std::string> m_dependencies {};
+        std::vector<std::string> m_features {};
+        uint32_t m_featureMask { 0 };
+        bool m_isCompute { false };
+    };
+
+    /** Compute Shader Program
+     *
+     * --------------------------
+     * Shader built from a `#![compute]` block, with helpers to
+     *  dispatch work groups and synchronize their memory writes.
+     *
+     * @see Usage example:
+     *       sandbox/hello_pbr/main.cc (BRDF LUT)
+     */
+    class ComputeShader: public Shader {
+    public:
+        ComputeShader() = default;
+
+        /** Take a built compute shader.
+         *
+         * @throw `std::runtime_error` if the shader has no compute block.
+         */
+        explicit ComputeShader(Shader&& shader);
+
+        //! Get the `local_size_*` declared by the shader.
+        glm::uvec3 getWorkGroupSize() const;
+
+        //! Bind and dispatch work groups. (wrapper of `glDispatchCompute`)
+        void dispatch(GLuint x, GLuint y = 1, GLuint z = 1) const;
+
+        //! Dispatch enough work groups to cover the given number of invocations.
+        void dispatchThreads(GLuint x, GLuint y = 1, GLuint z = 1) const;
+
+        /** Make shader writes visible to later commands. (wrapper of `glMemoryBarrier`)
+         *
+         * @param barriers How the written data is read later, e.g. `GL_TEXTURE_FETCH_BARRIER_BIT`.
+         */
+        static void barrier(GLbitfield barriers = GL_ALL_BARRIER_BITS);
     };
-}
\ No newline at end of file
+}
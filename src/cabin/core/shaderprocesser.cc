@@ -0,0 +1,603 @@
+#include "shaderprocesser.h"
+
+#include <mutex>
+#include <memory>
+#include <format>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+#include "cabin/utils/console.h"
+
+namespace {
+    //! Error raised inside a stage block, already carrying its location.
+    class BlockError: public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    struct Macro {
+        std::string_view name {};
+        std::string_view param {};
+    };
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+
+    bool isWord(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    bool isParam(char c) {
+        return isWord(c) || isSpace(c) || c == '.' || c == '\\' || c == '/';
+    }
+
+    /** Identify a macro line.
+     *
+     * @note Accepts `#![name]` and `#![name("param")]`.
+     *
+     * @return `std::nullopt` if the line is not a macro,
+     *          and a macro with empty name on syntax error.
+     */
+    std::optional<Macro> parseMacro(std::string_view line) {
+        size_t i = 0;
+        auto skipSpace = [&] { while (i < line.size() && isSpace(line[i])) i++; };
+        auto expect = [&](char c) { return i < line.size() && line[i++] == c; };
+
+        skipSpace();
+        if (line.substr(i, 2) != "#!")
+            return std::nullopt;
+        i += 2;
+
+        if (!expect('['))
+            return Macro {};
+        skipSpace();
+
+        size_t nameBegin = i;
+        while (i < line.size() && isWord(line[i])) i++;
+        std::string_view name = line.substr(nameBegin, i - nameBegin);
+        if (name.empty())
+            return Macro {};
+        skipSpace();
+
+        std::string_view param {};
+        if (i < line.size() && line[i] == '(') {
+            i++;
+            skipSpace();
+            if (!expect('"'))
+                return Macro {};
+
+            size_t paramBegin = i;
+            while (i < line.size() && isParam(line[i])) i++;
+            param = line.substr(paramBegin, i - paramBegin);
+
+            if (!expect('"'))
+                return Macro {};
+            skipSpace();
+            if (!expect(')'))
+                return Macro {};
+            skipSpace();
+        }
+
+        if (!expect(']') || i != line.size())
+            return Macro {};
+
+        return Macro { name, param };
+    }
+
+    /** Call `func(line, lineNumber)` for every line of the source.
+     *
+     * @note Line breaks are stripped, including the `\r` of CRLF.
+     */
+    template <typename Func>
+    void forEachLine(std::string_view source, Func&& func) {
+        size_t lineNumber = 0;
+        size_t position = 0;
+        while (position < source.size()) {
+            size_t end = source.find('\n', position);
+            if (end == std::string_view::npos)
+                end = source.size();
+
+            std::string_view line = source.substr(position, end - position);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+
+            position = end + 1;
+            func(line, ++lineNumber);
+        }
+    }
+
+    std::optional<std::string> readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return std::nullopt;
+
+        std::string content (static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(content.data(), content.size());
+        return content;
+    }
+
+    BlockError makeBlockError(const std::string& fileName, size_t lineNumber, std::string_view line, const char* error) {
+        return BlockError(std::format(
+            "failed to parse shader block, in \"{}\", at line {}: \n    \"{}\"\n  error: {}",
+            fileName, lineNumber, line, error
+        ));
+    }
+
+    /** Identify a line inside a block.
+     *
+     * @return `std::nullopt` for a plain GLSL line, and the
+     *          parameter for a `#![use("...")]` line.
+     */
+    std::optional<std::string_view> parseBlockLine(std::string_view line) {
+        std::optional<Macro> macro = parseMacro(line);
+        if (!macro.has_value())
+            return std::nullopt;
+
+        auto [name, param] = macro.value();
+
+        if (name.empty()) {
+            throw std::runtime_error("macro syntax error");
+        }
+        else if (name == "use") {
+            if (param.empty())
+                throw std::runtime_error("macro \"use\" requires a path as parameter. (helps: \"#![use(\"...\")]\")");
+
+            return param;
+        }
+        
+        for (std::string_view entryMacro : { "version", "feature", "vertex", "geometory", "fragment", "compute" }) {
+            if (name == entryMacro)
+                throw std::runtime_error(std::format("macro \"{}\" only allowed in entry shader", entryMacro));
+        }
+
+        throw std::runtime_error(std::format("unrecognized macro \"{}\"", name));
+    }
+
+    //! Used file split into plain text chunks by its `#![use]` lines.
+    struct ScannedFile {
+        struct Use {
+            std::string param {};
+            std::string line {};
+            size_t lineNumber {};
+        };
+
+        std::filesystem::file_time_type writeTime {};
+        uintmax_t size {};
+
+        //! `chunks[i]` precedes `uses[i]`, so there is always one more chunk than uses.
+        std::vector<std::string> chunks {};
+        std::vector<Use> uses {};
+    };
+
+    ScannedFile scanFile(std::string_view source, const std::string& fileName) {
+        ScannedFile scanned {};
+        scanned.chunks.emplace_back();
+
+        forEachLine(source, [&](std::string_view line, size_t lineNumber) {
+            try {
+                std::optional<std::string_view> param = parseBlockLine(line);
+                if (!param.has_value()) {
+                    scanned.chunks.back().append(line);
+                    scanned.chunks.back().append("\n");
+                    return;
+                }
+
+                scanned.uses.push_back({ std::string { param.value() }, std::string { line }, lineNumber });
+                scanned.chunks.emplace_back();
+            } catch (const std::exception& e) {
+                throw makeBlockError(fileName, lineNumber, line, e.what());
+            }
+        });
+
+        return scanned;
+    }
+
+    //! Process-wide cache of scanned used files.
+    class IncludeCache {
+    public:
+        /** Get the scanned used file, scan it on first use or after modification.
+         *
+         * @return `nullptr` if the file can't be opened.
+         */
+        std::shared_ptr<const ScannedFile> load(const std::string& path, const std::string& fileName) {
+            std::error_code error;
+            std::string canonicalPath = std::filesystem::canonical(path, error).string();
+            if (error)
+                return nullptr;
+
+            auto writeTime = std::filesystem::last_write_time(canonicalPath, error);
+            if (error)
+                return nullptr;
+
+            uintmax_t size = std::filesystem::file_size(canonicalPath, error);
+            if (error)
+                return nullptr;
+
+            {
+                std::scoped_lock lock(m_mutex);
+                auto iter = m_files.find(canonicalPath);
+                if (iter != m_files.end() && iter->second->writeTime == writeTime && iter->second->size == size) {
+                    m_hits++;
+                    return iter->second;
+                }
+            }
+
+            // Scan outside of the lock, files failing to scan are not cached.
+            std::optional<std::string> content = readFile(canonicalPath);
+            if (!content.has_value())
+                return nullptr;
+
+            auto scanned = std::make_shared<ScannedFile>(scanFile(content.value(), fileName));
+            scanned->writeTime = writeTime;
+            scanned->size = size;
+
+            std::scoped_lock lock(m_mutex);
+            m_misses++;
+            m_files[canonicalPath] = scanned;
+            return scanned;
+        }
+
+        cabin::core::ShaderProcesser::CacheStatistics getStatistics() {
+            std::scoped_lock lock(m_mutex);
+            return { m_hits, m_misses, m_files.size() };
+        }
+
+        void clear() {
+            std::scoped_lock lock(m_mutex);
+            m_files.clear();
+            m_hits = 0;
+            m_misses = 0;
+        }
+
+    private:
+        std::mutex m_mutex {};
+        std::unordered_map<std::string, std::shared_ptr<const ScannedFile>> m_files {};
+        size_t m_hits { 0 };
+        size_t m_misses { 0 };
+    };
+
+    IncludeCache& getIncludeCache() {
+        static IncludeCache cache {};
+        return cache;
+    }
+
+    const char SHADER_BUNDLE_MAGIC[4] = { 'C', 'B', 'S', 'B' };
+    const uint32_t SHADER_BUNDLE_VERSION = 1;
+}
+
+namespace cabin::core {
+
+    ShaderProcesser::ShaderProcesser(const std::string& path) {
+        std::optional<std::string> content = readFile(path);
+        if (!content.has_value())
+            throw std::runtime_error("failed to open shader file.");
+
+        m_sourceContent.swap(content.value());
+        m_baseDirectory = std::filesystem::path(path).parent_path().string();
+        if (m_baseDirectory.empty())
+            m_baseDirectory = ".";
+        m_entryFileName = std::filesystem::path(path).filename().string();
+        m_isBundle = m_sourceContent.size() >= sizeof(SHADER_BUNDLE_MAGIC) &&
+                     std::memcmp(m_sourceContent.data(), SHADER_BUNDLE_MAGIC, sizeof(SHADER_BUNDLE_MAGIC)) == 0;
+    }
+
+    void ShaderProcesser::setLineDirectives(bool isEnabled) {
+        m_hasLineDirectives = isEnabled;
+    }
+
+    ShaderProcesser::Result ShaderProcesser::process() {
+        m_sourceFiles.clear();
+        if (m_isBundle)
+            return loadBundle();
+
+        // Entry file comes first, so that it is numbered `0` by `#line` directives.
+        getSourceIndex(m_entryFileName);
+
+        std::string versionStr = "#version ";
+        std::optional<size_t> versionMarker {};
+
+        std::vector<std::string> features {};
+        std::vector<size_t> featureMarkers {};
+
+        Block vertexBlock {}, geometoryBlock {}, fragmentBlock {}, computeBlock {};
+        Block* targetBlock = nullptr;
+
+        std::string entryPath = std::format("{}/{}", m_baseDirectory, m_entryFileName);
+        for (Block* block : { &vertexBlock, &geometoryBlock, &fragmentBlock, &computeBlock })
+            block->usedFiles.push_back(entryPath);
+
+        auto beginBlock = [&](Block& block, std::string_view name, std::string_view param, size_t lineNumber) {
+            if (block.marker.has_value())
+                throw std::runtime_error(std::format(
+                    "{} block re-decleration (v.s. line {})", name, block.marker.value()
+                ));
+
+            if (!param.empty())
+                throw std::runtime_error(std::format(
+                    "extra \"{}\" macro parameter. (helps: \"#![{}]\")", name, name
+                ));
+
+            targetBlock = &block;
+            block.marker = lineNumber;
+            appendLineDirective(block, m_entryFileName, lineNumber);
+        };
+
+        forEachLine(m_sourceContent, [&](std::string_view line, size_t lineNumber) {
+            try {
+                std::optional<Macro> macro = parseMacro(line);
+
+                if (!macro.has_value()) {
+                    if (targetBlock) {
+                        targetBlock->source.append(line);
+                        targetBlock->source.append("\n");
+                    }
+                    return;
+                }
+
+                auto [name, param] = macro.value();
+
+                if (name.empty()) {
+                    throw std::runtime_error("macro syntax error");
+                }
+                else if (name == "version") {
+                    if (versionMarker.has_value())
+                        throw std::runtime_error(std::format(
+                        "version re-decleration (v.s. line {})", versionMarker.value()
+                    ));
+
+                    if (param.empty())
+                        throw std::runtime_error("macro \"version\" requires a version string as parameter. (helps: \"#![version(\"...\")]\")");
+
+                    versionStr.append(param);
+                    versionMarker = lineNumber;
+                    if (targetBlock)
+                        appendLineDirective(*targetBlock, m_entryFileName, lineNumber);
+                }
+                else if (name == "feature") {
+                    bool isIdentifier = !param.empty() && !(param[0] >= '0' && param[0] <= '9') &&
+                                        std::all_of(param.begin(), param.end(), isWord);
+                    if (!isIdentifier)
+                        throw std::runtime_error("macro \"feature\" requires an identifier as parameter. (helps: \"#![feature(\"...\")]\")");
+
+                    auto iter = std::find(features.begin(), features.end(), param);
+                    if (iter != features.end())
+                        throw std::runtime_error(std::format(
+                            "feature \"{}\" re-decleration (v.s. line {})", param, featureMarkers[iter - features.begin()]
+                        ));
+
+                    if (features.size() == MAX_FEATURE_COUNT)
+                        throw std::runtime_error(std::format("too many features, at most {} are allowed", MAX_FEATURE_COUNT));
+
+                    features.emplace_back(param);
+                    featureMarkers.push_back(lineNumber);
+                    if (targetBlock)
+                        appendLineDirective(*targetBlock, m_entryFileName, lineNumber);
+                }
+                else if (name == "vertex") {
+                    beginBlock(vertexBlock, name, param, lineNumber);
+                }
+                else if (name == "geometory") {
+                    beginBlock(geometoryBlock, name, param, lineNumber);
+                }
+                else if (name == "fragment") {
+                    beginBlock(fragmentBlock, name, param, lineNumber);
+                }
+                else if (name == "compute") {
+                    beginBlock(computeBlock, name, param, lineNumber);
+                }
+                else {
+                    if (!targetBlock)
+                        throw std::runtime_error("out-block macro detected");
+
+                    processLine(*targetBlock, line, m_entryFileName, lineNumber);
+                }
+            } catch (const BlockError&) {
+                throw;
+            } catch (const std::exception& e) {
+                throw std::runtime_error(std::format(
+                    "failed to parse shader \"{}\", at line {}: \n    \"{}\"\n  error: {}.",
+                    m_entryFileName, lineNumber, line, e.what()
+                ));
+            }
+        });
+
+        Result processResult {};
+
+        processResult.features.swap(features);
+        processResult.dependencies = m_sourceFiles;
+
+        if (versionMarker.has_value())
+            processResult.version = versionStr;
+        else
+            throw std::runtime_error("necessary \"version\" decleration is missing.");
+
+        // Compute shader stands alone, without any graphics stage.
+        if (computeBlock.marker.has_value()) {
+            for (Block* block : { &vertexBlock, &geometoryBlock, &fragmentBlock }) {
+                if (block->marker.has_value())
+                    throw std::runtime_error(std::format(
+                        "\"compute\" block can't be mixed with graphics blocks (v.s. line {}).", block->marker.value()
+                    ));
+            }
+
+            processResult.compute.swap(computeBlock.source);
+            return processResult;
+        }
+
+        if (vertexBlock.marker.has_value())
+            processResult.vertex.swap(vertexBlock.source);
+        else
+            throw std::runtime_error("necessary \"vertex\" block is missing.");
+
+        if (geometoryBlock.marker.has_value())
+            processResult.geometory.swap(geometoryBlock.source);
+
+        if (fragmentBlock.marker.has_value())
+            processResult.fragment.swap(fragmentBlock.source);
+        else
+            throw std::runtime_error("necessary \"fragment\" block is missing.");
+
+        return processResult;
+    }
+
+    void ShaderProcesser::saveBundle(const Result& result, const std::string& path) {
+        std::string content (SHADER_BUNDLE_MAGIC, sizeof(SHADER_BUNDLE_MAGIC));
+        auto appendInteger = [&](uint32_t value) {
+            content.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+        auto appendString = [&](const std::string& str) {
+            appendInteger(static_cast<uint32_t>(str.size()));
+            content.append(str);
+        };
+
+        appendInteger(SHADER_BUNDLE_VERSION);
+        for (const std::string* stage : { &result.version, &result.vertex, &result.geometory, &result.fragment, &result.compute })
+            appendString(*stage);
+
+        appendInteger(static_cast<uint32_t>(result.features.size()));
+        for (const auto& feature : result.features)
+            appendString(feature);
+
+        // Write into a temporary file first, so that a watching process never reads a truncated bundle.
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(content.data(), content.size());
+            if (!file.good())
+                throw std::runtime_error(std::format("failed to write shader bundle \"{}\"", path));
+        }
+
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+            throw std::runtime_error(std::format("failed to write shader bundle \"{}\"", path));
+    }
+
+    ShaderProcesser::Result ShaderProcesser::loadBundle() const {
+        size_t position = sizeof(SHADER_BUNDLE_MAGIC);
+        auto readInteger = [&] {
+            uint32_t value;
+            if (m_sourceContent.size() - position < sizeof(value))
+                throw std::runtime_error(std::format("corrupted shader bundle \"{}\"", m_entryFileName));
+
+            std::memcpy(&value, m_sourceContent.data() + position, sizeof(value));
+            position += sizeof(value);
+            return value;
+        };
+        auto readString = [&] {
+            uint32_t size = readInteger();
+            if (m_sourceContent.size() - position < size)
+                throw std::runtime_error(std::format("corrupted shader bundle \"{}\"", m_entryFileName));
+
+            std::string str = m_sourceContent.substr(position, size);
+            position += size;
+            return str;
+        };
+
+        if (readInteger() != SHADER_BUNDLE_VERSION)
+            throw std::runtime_error(std::format("unsupported version of shader bundle \"{}\"", m_entryFileName));
+
+        Result result {};
+        for (std::string* stage : { &result.version, &result.vertex, &result.geometory, &result.fragment, &result.compute })
+            *stage = readString();
+
+        uint32_t featureCount = readInteger();
+        if (featureCount > MAX_FEATURE_COUNT)
+            throw std::runtime_error(std::format("corrupted shader bundle \"{}\"", m_entryFileName));
+        for (uint32_t i = 0; i < featureCount; i++)
+            result.features.push_back(readString());
+
+        std::string bundlePath = std::format("{}/{}", m_baseDirectory, m_entryFileName);
+        result.dependencies.push_back(std::filesystem::absolute(bundlePath).lexically_normal().string());
+        return result;
+    }
+
+    ShaderProcesser::CacheStatistics ShaderProcesser::getCacheStatistics() {
+        return getIncludeCache().getStatistics();
+    }
+
+    void ShaderProcesser::clearCache() {
+        getIncludeCache().clear();
+    }
+
+    void ShaderProcesser::processLine(Block& block, std::string_view line, const std::string& fileName, size_t lineNumber) {
+        try {
+            std::optional<std::string_view> param = parseBlockLine(line);
+            if (!param.has_value()) {
+                block.source.append(line);
+                block.source.append("\n");
+                return;
+            }
+
+            useFile(block, param.value(), fileName, lineNumber);
+        } catch (const std::exception& e) {
+            throw makeBlockError(fileName, lineNumber, line, e.what());
+        }
+    }
+
+    void ShaderProcesser::useFile(Block& block, std::string_view param, const std::string& fileName, size_t lineNumber) {
+        std::string absolutePath = std::format("{}/{}", m_baseDirectory, param);
+        absolutePath = std::filesystem::absolute(absolutePath).string();
+
+        // Prevent self-use
+        if (absolutePath == std::filesystem::absolute(std::format("{}/{}", m_baseDirectory, fileName))) {
+            throw std::runtime_error("self-use detected");
+        }
+
+        // Prevent multi-use
+        if (std::find(block.usedFiles.begin(), block.usedFiles.end(), absolutePath) != block.usedFiles.end()) {
+            cabin::utils::Console::info(std::format("muti-use file detected in \"{}\", line {}; ignored.", fileName, lineNumber));
+            appendLineDirective(block, fileName, lineNumber);
+            return;
+        }
+
+        std::string usedFileName { param };
+        std::shared_ptr<const ScannedFile> usedFile = getIncludeCache().load(absolutePath, usedFileName);
+        if (!usedFile)
+            throw std::runtime_error(std::format("failed to open used file: \"{}\"", param));
+
+        block.usedFiles.push_back(absolutePath);
+        size_t sourceIndex = getSourceIndex(usedFileName);
+
+        block.source.append(std::format("// ------------- BEGIN QUOTE, FROM {} -------------\n", usedFileName));
+        if (m_hasLineDirectives)
+            block.source.append(std::format("#line 1 {}\n", sourceIndex));
+        for (size_t i = 0; i < usedFile->uses.size(); i++) {
+            const auto& use = usedFile->uses[i];
+            block.source.append(usedFile->chunks[i]);
+
+            try {
+                useFile(block, use.param, usedFileName, use.lineNumber);
+            } catch (const std::exception& e) {
+                throw makeBlockError(usedFileName, use.lineNumber, use.line, e.what());
+            }
+        }
+        block.source.append(usedFile->chunks.back());
+        block.source.append(std::format("// -------------  END QUOTE, FROM {} -------------\n", usedFileName));
+        appendLineDirective(block, fileName, lineNumber);
+    }
+
+    size_t ShaderProcesser::getSourceIndex(const std::string& fileName) {
+        std::string path = std::filesystem::absolute(std::format("{}/{}", m_baseDirectory, fileName)).lexically_normal().string();
+
+        auto iter = std::find(m_sourceFiles.begin(), m_sourceFiles.end(), path);
+        if (iter != m_sourceFiles.end())
+            return iter - m_sourceFiles.begin();
+
+        m_sourceFiles.push_back(path);
+        return m_sourceFiles.size() - 1;
+    }
+
+    void ShaderProcesser::appendLineDirective(Block& block, const std::string& fileName, size_t lineNumber) {
+        if (m_hasLineDirectives)
+            block.source.append(std::format("#line {} {}\n", lineNumber + 1, getSourceIndex(fileName)));
+    }
+}
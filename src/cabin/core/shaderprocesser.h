@@ -0,0 +1,125 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace cabin::core {
+
+    /** Shader Source Preprocessor
+     *
+     * --------------------------
+     * Splits a cabin shader file into GLSL stages, following
+     *  the macros below:
+     *
+     *      - `#![version("...")]`: GLSL version of all stages.
+     *      - `#![feature("...")]`: feature key, defined as a macro in
+     *                                the shader variants enabling it.
+     *      - `#![vertex]`, `#![geometory]`, `#![fragment]`: stage blocks.
+     *      - `#![compute]`: compute stage block, used alone.
+     *      - `#![use("...")]`: quote another file into current block.
+     *
+     *  The file is scanned once, line by line, and used files
+     *  are expanded in place as soon as they are met.
+     *
+     *  Used files are scanned once per process, and kept in a shared
+     *  include cache keyed by canonical path and modification time.
+     *  The cache is safe to use from multiple threads.
+     *
+     *  A processed shader can be saved as a bundle (e.g. by the
+     *  `cabin-shaderc` tool), which is loaded back in place of the
+     *  shader file without parsing or opening any used file.
+     *
+     * @see Shader syntax example:
+     *       sandbox/hello_pbr/modelPBR.shader
+     */
+    class ShaderProcesser {
+    public:
+        struct Result {
+            std::string version {};
+            std::string vertex {};
+            std::string geometory {};
+            std::string fragment {};
+            std::string compute {};
+
+            //! Declared feature keys, in declaration order.
+            std::vector<std::string> features {};
+
+            //! Entry file and all used files in order of first use, as normalized absolute paths.
+            std::vector<std::string> dependencies {};
+        };
+
+    public:
+        //! Maximum number of features of a shader, so that a variant fits in a 32-bit mask.
+        static constexpr size_t MAX_FEATURE_COUNT = 32;
+
+    public:
+        //! Load the entry shader file, or a shader bundle.
+        ShaderProcesser(const std::string& path);
+
+        /** Emit `#line` directives mapping stage lines back to their files.
+         *
+         * @note Files are numbered by their index in `Result::dependencies`,
+         *       so that `0` is always the entry file.
+         */
+        void setLineDirectives(bool isEnabled);
+
+        //! Process the entry shader file, throws on syntax errors.
+        Result process();
+
+        /** Save the processed shader as a bundle.
+         *
+         * @note Dependencies are not saved, a loaded bundle only depends on itself.
+         *
+         * @throw `std::runtime_error` if the bundle can't be written.
+         */
+        static void saveBundle(const Result& result, const std::string& path);
+
+    public:
+        struct CacheStatistics {
+            size_t hits { 0 };
+            size_t misses { 0 };
+            size_t files { 0 };
+        };
+
+        //! Get hit and miss counts of the shared include cache.
+        static CacheStatistics getCacheStatistics();
+
+        //! Drop all cached used files, and reset the statistics.
+        static void clearCache();
+
+    private:
+        struct Block {
+            std::string source {};
+            std::optional<size_t> marker {};
+            std::vector<std::string> usedFiles {};
+        };
+
+        void processLine(Block& block, std::string_view line, const std::string& fileName, size_t lineNumber);
+        void useFile(Block& block, std::string_view param, const std::string& fileName, size_t lineNumber);
+
+        //! Get the index of the file in dependencies, add it on first use.
+        size_t getSourceIndex(const std::string& fileName);
+
+        //! Resume numbering lines of the file after the line, if `#line` directives are enabled.
+        void appendLineDirective(Block& block, const std::string& fileName, size_t lineNumber);
+
+        Result loadBundle() const;
+
+    private:
+        std::string m_sourceContent {};
+        std::string m_baseDirectory {};
+        std::string m_entryFileName {};
+        bool m_isBundle { false };
+        bool m_hasLineDirectives { false };
+        std::vector<std::string> m_sourceFiles {};
+    };
+}
@@ -0,0 +1,172 @@
+#include "shaderwatcher.h"
+
+#include <format>
+#include <algorithm>
+#include <stdexcept>
+#include "cabin/utils/console.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace cabin::core {
+
+    ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+        if (m_inotify >= 0) {
+            close(m_inotify);
+            m_inotify = -1;
+        }
+#endif
+    }
+
+    void ShaderWatcher::watch(Shader& shader) {
+        for (const auto& dependency : shader.getDependencies()) {
+            auto [iter, isNewFile] = m_dependents.try_emplace(dependency);
+            auto& dependents = iter->second;
+            if (std::find(dependents.begin(), dependents.end(), &shader) == dependents.end())
+                dependents.push_back(&shader);
+
+            if (isNewFile)
+                watchFile(dependency);
+        }
+    }
+
+    void ShaderWatcher::unwatch(Shader& shader) {
+        dropDependent(shader, {});
+    }
+
+    void ShaderWatcher::dropDependent(Shader& shader, const std::vector<std::string>& keptFiles) {
+        for (auto iter = m_dependents.begin(); iter != m_dependents.end();) {
+            if (std::find(keptFiles.begin(), keptFiles.end(), iter->first) == keptFiles.end())
+                std::erase(iter->second, &shader);
+
+            if (iter->second.empty()) {
+                unwatchFile(iter->first);
+                iter = m_dependents.erase(iter);
+            }
+            else
+                iter++;
+        }
+    }
+
+    size_t ShaderWatcher::poll() {
+        std::vector<Shader*> changedShaders {};
+        for (const auto& file : collectChangedFiles()) {
+            auto iter = m_dependents.find(file);
+            if (iter == m_dependents.end())
+                continue;
+
+            for (Shader* shader : iter->second) {
+                if (std::find(changedShaders.begin(), changedShaders.end(), shader) == changedShaders.end())
+                    changedShaders.push_back(shader);
+            }
+        }
+
+        size_t reloadCount = 0;
+        for (Shader* shader : changedShaders) {
+            if (!shader->reload())
+                continue;
+
+            // Used files may differ in the new source, keep watching the ones still used.
+            watch(*shader);
+            dropDependent(*shader, shader->getDependencies());
+            reloadCount++;
+        }
+
+        return reloadCount;
+    }
+
+#ifdef __linux__
+    void ShaderWatcher::watchFile(const std::string& path) {
+        if (m_inotify < 0) {
+            m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_inotify < 0)
+                throw std::runtime_error("failed to initialize inotify");
+        }
+
+        // Watch the directory rather than the file, since editors often save by replacing the file.
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        auto [iter, isNewDirectory] = m_directories.try_emplace(directory);
+        iter->second.fileCount++;
+        if (!isNewDirectory)
+            return;
+
+        int watchDescriptor = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watchDescriptor < 0) {
+            utils::Console::error(std::format("failed to watch directory \"{}\"", directory));
+            return;
+        }
+
+        iter->second.descriptor = watchDescriptor;
+        m_watchDirectories[watchDescriptor] = directory;
+    }
+
+    void ShaderWatcher::unwatchFile(const std::string& path) {
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        auto iter = m_directories.find(directory);
+        if (iter == m_directories.end() || --iter->second.fileCount > 0)
+            return;
+
+        // Remove the watch once no file of the directory is watched, instead of piling up descriptors.
+        if (iter->second.descriptor >= 0) {
+            inotify_rm_watch(m_inotify, iter->second.descriptor);
+            m_watchDirectories.erase(iter->second.descriptor);
+        }
+        m_directories.erase(iter);
+    }
+
+    std::vector<std::string> ShaderWatcher::collectChangedFiles() {
+        std::vector<std::string> changedFiles {};
+        if (m_inotify < 0)
+            return changedFiles;
+
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+
+            for (char* position = buffer; position < buffer + length;) {
+                auto event = reinterpret_cast<const inotify_event*>(position);
+                position += sizeof(inotify_event) + event->len;
+
+                auto iter = m_watchDirectories.find(event->wd);
+                if (iter == m_watchDirectories.end() || event->len == 0)
+                    continue;
+
+                std::string file = (std::filesystem::path(iter->second) / event->name).string();
+                if (std::find(changedFiles.begin(), changedFiles.end(), file) == changedFiles.end())
+                    changedFiles.push_back(file);
+            }
+        }
+
+        return changedFiles;
+    }
+#else
+    void ShaderWatcher::watchFile(const std::string& path) {
+        std::error_code error;
+        m_writeTimes.try_emplace(path, std::filesystem::last_write_time(path, error));
+    }
+
+    void ShaderWatcher::unwatchFile(const std::string& path) {
+        m_writeTimes.erase(path);
+    }
+
+    std::vector<std::string> ShaderWatcher::collectChangedFiles() {
+        std::vector<std::string> changedFiles {};
+        for (auto& [file, writeTime] : m_writeTimes) {
+            std::error_code error;
+            auto currentWriteTime = std::filesystem::last_write_time(file, error);
+            if (error || currentWriteTime == writeTime)
+                continue;
+
+            writeTime = currentWriteTime;
+            changedFiles.push_back(file);
+        }
+
+        return changedFiles;
+    }
+#endif
+}
@@ -0,0 +1,88 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <filesystem>
+#include <unordered_map>
+
+#include "cabin/core/shader.h"
+
+namespace cabin::core {
+
+    /** Shader Hot-Reload Watcher
+     *
+     * --------------------------
+     * `ShaderWatcher` keeps a dependency graph from source files
+     *  (entry shader files and `#![use]` files) to the watched
+     *  shaders. When files change, only the shaders depending on
+     *  them are rebuilt, and a shader failing to build keeps its
+     *  old program.
+     *
+     *  Changes are detected with inotify on Linux, and by polling
+     *  modification times on other platforms.
+     *
+     * @note Watched shaders are referenced by address, keep them
+     *       in place (or `unwatch` them) while being watched.
+     *
+     * @see Usage example:
+     *       sandbox/hello_pbr/main.cc
+     */
+    class ShaderWatcher {
+    public:
+        ShaderWatcher() = default;
+        ShaderWatcher(ShaderWatcher&&) = delete;
+        ShaderWatcher(const ShaderWatcher&) = delete;
+
+        ~ShaderWatcher();
+
+        //! Start watching all dependencies of the shader.
+        void watch(Shader& shader);
+
+        //! Stop watching the shader.
+        void unwatch(Shader& shader);
+
+        /** Rebuild shaders whose dependencies changed since last poll, without blocking.
+         *
+         * @return Number of shaders reloaded successfully.
+         */
+        size_t poll();
+
+    private:
+        //! Start watching a file when its first dependent is added.
+        void watchFile(const std::string& path);
+
+        //! Stop watching a file after its last dependent is removed.
+        void unwatchFile(const std::string& path);
+
+        //! Remove the shader from files other than `keptFiles`, and stop watching files left without dependents.
+        void dropDependent(Shader& shader, const std::vector<std::string>& keptFiles);
+
+        //! Collect changed files since last poll.
+        std::vector<std::string> collectChangedFiles();
+
+    private:
+        //! Dependency graph, from source file to the shaders using it.
+        std::unordered_map<std::string, std::vector<Shader*>> m_dependents {};
+
+#ifdef __linux__
+        //! Watch of a directory, shared by the watched files inside it.
+        struct DirectoryWatch {
+            int descriptor { -1 };
+            size_t fileCount { 0 };
+        };
+
+        int m_inotify { -1 };
+        std::unordered_map<std::string, DirectoryWatch> m_directories {};
+        std::unordered_map<int, std::string> m_watchDirectories {};
+#else
+        std::unordered_map<std::string, std::filesystem::file_time_type> m_writeTimes {};
+#endif
+    };
+}
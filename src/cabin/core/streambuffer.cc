@@ -0,0 +1,79 @@
+#include "streambuffer.h"
+
+#include <utility>
+#include <stdexcept>
+
+namespace cabin::core {
+    StreamBuffer::Builder& StreamBuffer::Builder::setRingBuffer(RingBuffer& ring) {
+        this->ring = &ring;
+        return *this;
+    }
+
+    StreamBuffer StreamBuffer::Builder::build() {
+        if (ring == nullptr || !ring->id.has_value())
+            throw std::runtime_error("failed to build StreamBuffer without a ring buffer!");
+        if (format.attributes.empty())
+            throw std::runtime_error("failed to build StreamBuffer without any attribute!");
+
+        // Ranges of the ring are attached to binding point `0` per draw.
+        GLuint vertexArrayID;
+        glCreateVertexArrays(1, &vertexArrayID);
+        format.apply(vertexArrayID);
+
+        StreamBuffer result {};
+        result.VAO = vertexArrayID;
+        result.stride = format.stride;
+        result.m_ring = ring;
+        return result;
+    }
+
+    StreamBuffer::StreamBuffer(StreamBuffer&& right) noexcept {
+        *this = std::move(right);
+    }
+
+    StreamBuffer& StreamBuffer::operator=(StreamBuffer&& right) noexcept {
+        release();
+
+        VAO = right.VAO;
+        stride = right.stride;
+        m_ring = right.m_ring;
+
+        right.VAO.reset();
+        right.m_ring = nullptr;
+
+        return *this;
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        release();
+    }
+
+    void StreamBuffer::release() {
+        if (VAO.has_value()) {
+            glDeleteVertexArrays(1, &VAO.value());
+            VAO.reset();
+        }
+    }
+
+    StreamBuffer::Batch StreamBuffer::push(const void* vertices, size_t vertexCount) const {
+        RingBuffer::Range range = m_ring->push(vertices, static_cast<GLsizeiptr>(vertexCount) * stride, VERTEX_ALIGNMENT);
+
+        Batch batch {};
+        batch.vertexOffset = range.offset;
+        batch.vertexCount = static_cast<GLsizei>(vertexCount);
+        return batch;
+    }
+
+    void StreamBuffer::draw(const Batch& batch, GLenum mode) const {
+        glBindVertexArray(VAO.value());
+        glVertexArrayVertexBuffer(VAO.value(), 0, m_ring->id.value(), batch.vertexOffset, stride);
+
+        if (batch.indexCount == 0) {
+            glDrawArrays(mode, 0, batch.vertexCount);
+            return;
+        }
+
+        glVertexArrayElementBuffer(VAO.value(), m_ring->id.value());
+        glDrawElements(mode, batch.indexCount, batch.indexType, reinterpret_cast<const void*>(batch.indexOffset));
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+#include <glad/glad.h>
+#include "ringbuffer.h"
+#include "vertexlayout.h"
+
+namespace cabin::core {
+
+    /** Streaming Vertex Buffer
+     *
+     * --------------------------
+     * `StreamBuffer` draws geometry rewritten every frame (e.g. debug
+     *  lines, particles or overlays) from a persistently mapped
+     *  `RingBuffer`, instead of reallocating or orphaning buffers.
+     *
+     *  Vertices and indices are copied into the current frame region
+     *  of the ring, which the GPU reads while the CPU already writes
+     *  the next frames. Indices are read from the ring as well, so
+     *  a draw only attaches the ring to the vertex array.
+     *
+     * @note The ring's `beginFrame` and `endFrame` must surround the
+     *       frames using the stream buffer, and it may be shared with
+     *       parameter blocks. Ranges are aligned by `RingBuffer::push`.
+     *
+     * @see Usage example:
+     *       sandbox/hello_pbr/main.cc
+     */
+    class StreamBuffer {
+    public:
+        //! Vertices and indices written into the current frame region.
+        struct Batch {
+            GLintptr vertexOffset { 0 };
+            GLsizei vertexCount { 0 };
+            GLintptr indexOffset { 0 };
+            GLsizei indexCount { 0 };   //!< `0` if the batch draws arrays.
+            GLenum indexType { 0 };
+        };
+
+        class Builder {
+        public:
+            Builder() = default;
+            Builder(Builder&&) = delete;
+            Builder(const Builder&) = delete;
+
+            //! Set the ring buffer to stream into, which must outlive the stream buffer.
+            Builder& setRingBuffer(RingBuffer& ring);
+
+            /** Add a vertex attribute, same as `VertexBuffer::Builder::addAttribute`.
+             *
+             * @tparam T         Attribute component type.
+             * @param index      Attribute location index.
+             * @param count      Attribute component count.
+             * @param normalized Whether normalize attribute components.
+             */
+            template <vertex::Component T>
+            Builder& addAttribute(GLuint index, GLuint count, bool normalized = false) {
+                format.add<T>(index, count, normalized);
+                return *this;
+            }
+
+            //! Set all attributes from the layout of a vertex struct, same as `VertexBuffer::Builder::setLayout`.
+            template <auto... Members>
+            Builder& setLayout(vertex::Layout<Members...> layout) {
+                format = vertex::Format::from(layout);
+                return *this;
+            }
+
+            StreamBuffer build();
+
+        private:
+            RingBuffer* ring { nullptr };
+            vertex::Format format {};
+        };
+
+    public:
+        StreamBuffer() = default;
+
+        StreamBuffer(StreamBuffer&& right) noexcept;
+        StreamBuffer& operator=(StreamBuffer&& right) noexcept;
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        ~StreamBuffer();
+
+        /** Copy vertices into the current frame region.
+         *
+         * @param vertices    Pointer to vertices, in the layout of the stream buffer.
+         * @param vertexCount Number of vertices.
+         *
+         * @note Throws if the frame region runs out of space.
+         */
+        Batch push(const void* vertices, size_t vertexCount) const;
+
+        //! Copy vertices and indices into the current frame region.
+        template <typename T>
+            requires std::is_same_v<T, unsigned char> || std::is_same_v<T, unsigned short> ||
+                     std::is_same_v<T, unsigned int>
+        Batch push(const void* vertices, size_t vertexCount, const T* indices, size_t indexCount) const {
+            GLenum type;
+            if constexpr (std::is_same_v<T, unsigned char>)
+                type = GL_UNSIGNED_BYTE;
+            else if constexpr (std::is_same_v<T, unsigned short>)
+                type = GL_UNSIGNED_SHORT;
+            else
+                type = GL_UNSIGNED_INT;
+
+            Batch batch = push(vertices, vertexCount);
+            RingBuffer::Range range = m_ring->push(indices, static_cast<GLsizeiptr>(indexCount * sizeof(T)), sizeof(T));
+            batch.indexOffset = range.offset;
+            batch.indexCount = static_cast<GLsizei>(indexCount);
+            batch.indexType = type;
+            return batch;
+        }
+
+        /** Attach the vertex range of a batch and draw it.
+         *
+         * @param mode Primitive type, e.g. `GL_LINES`.
+         *
+         * @note Batches must be drawn in the frame they were pushed.
+         */
+        void draw(const Batch& batch, GLenum mode = GL_TRIANGLES) const;
+
+    private:
+        void release();
+
+    public:
+        std::optional<GLuint> VAO;
+        GLsizei stride { 0 };           //!< Size of a vertex (in byte).
+
+    private:
+        //! Alignment of vertex ranges, enough for every attribute component type.
+        static constexpr GLsizeiptr VERTEX_ALIGNMENT = 16;
+
+        RingBuffer* m_ring { nullptr };
+    };
+}
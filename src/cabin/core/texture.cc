@@ -1,128 +1,372 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "texture.h"
+#include <bit>
+#include <chrono>
 #include <format>
+#include <algorithm>
 #include <stdexcept>
+#include "mipmapchain.h"
+#include "memorybudget.h"
+#include "radianceimage.h"
+#include "compressedimage.h"
+#include "textureuploader.h"
+#include "cabin/utils/threadpool.h"
 
 namespace cabin::core {
-    Texture::Builder::Builder() {
-        glGenTextures(1, &id);
+    Texture::Builder& Texture::Builder::asEmpty2D(GLsizei width, GLsizei height, GLenum internalFormat, GLsizei levels) {
+        allocate(GL_TEXTURE_2D, getSizedFormat(internalFormat), width, height, 0, levels);
+        return *this;
     }
 
-    Texture::Builder& Texture::Builder::asEmpty2D(GLsizei width, GLsizei height, GLenum internalFormat) {
-        target = GL_TEXTURE_2D;
-        format = internalFormat;
-        this->width = width;
-        this->height = height;
-        
-        glBindTexture(GL_TEXTURE_2D, id);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
+    Texture::Builder& Texture::Builder::asEmpty3D(GLsizei width, GLsizei height, GLsizei depth, GLenum internalFormat, GLsizei levels) {
+        allocate(GL_TEXTURE_3D, getSizedFormat(internalFormat), width, height, depth, levels);
+        return *this;
+    }
 
+    Texture::Builder& Texture::Builder::asEmptyCubeMap(GLsizei length, GLenum internalFormat, GLsizei levels) {
+        allocate(GL_TEXTURE_CUBE_MAP, getSizedFormat(internalFormat), length, length, 0, levels);
         return *this;
     }
 
-    Texture::Builder& Texture::Builder::asEmpty3D(GLsizei width, GLsizei height, GLsizei depth, GLenum internalFormat) {
-        target = GL_TEXTURE_3D;
-        format = internalFormat;
-        this->width = width;
-        this->height = height;
-        this->depth = depth;
+    Texture::Builder& Texture::Builder::asEmpty2DArray(GLsizei width, GLsizei height, GLsizei layers,
+                                                       GLenum internalFormat, GLsizei levels) {
+        allocate(GL_TEXTURE_2D_ARRAY, getSizedFormat(internalFormat), width, height, layers, levels);
+        return *this;
+    }
+
+    Texture::Builder& Texture::Builder::fromFile2D(const std::string& path, GLenum internalFormat, bool flip, GLsizei levels) {
+        std::vector<Image> images = decodeLevels(path, flip, internalFormat, levels);
 
-        glBindTexture(GL_TEXTURE_3D, id);
-        glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0, GL_RGB, GL_FLOAT, nullptr);
+        if (id)
+            throw std::runtime_error("texture storage is already specified");
+        glCreateTextures(GL_TEXTURE_2D, 1, &id);
+        format = uploadLevels(id, internalFormat, images);
+
+        target = GL_TEXTURE_2D;
+        this->width = images.front().width;
+        this->height = images.front().height;
+        this->levels = static_cast<GLsizei>(images.size());
+        m_hasMipmapLevels = true;
 
+        m_reloader = [path, internalFormat, flip, levels](GLuint id) {
+            uploadImages(id, decodeLevels(path, flip, internalFormat, levels));
+        };
         return *this;
     }
 
-    Texture::Builder& Texture::Builder::asEmptyCubeMap(GLsizei length, GLenum internalFormat) {
-        target = GL_TEXTURE_CUBE_MAP;
+    Texture::Builder& Texture::Builder::fromFile2DAsync(const std::string& path, GLenum internalFormat, bool flip, GLsizei levels) {
+        if (id)
+            throw std::runtime_error("texture storage is already specified");
+
+        // The object is created right away for the settings, the storage waits for the image size.
+        glCreateTextures(GL_TEXTURE_2D, 1, &id);
+        target = GL_TEXTURE_2D;
         format = internalFormat;
-        this->width = length;
-        this->height = length;
+        this->levels = levels;
+        m_hasMipmapLevels = true;
 
-        glBindTexture(GL_TEXTURE_CUBE_MAP, id);
-        for (int i = 0; i < 6; i++) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat,
-                         length, length, 0, GL_RGB, GL_FLOAT, nullptr);
-        }
+        m_pendingLevels = utils::ThreadPool::getShared().submit([path, flip, internalFormat, levels] {
+            return decodeLevels(path, flip, internalFormat, levels);
+        });
+        m_reloader = [path, internalFormat, flip, levels](GLuint id) {
+            uploadImages(id, decodeLevels(path, flip, internalFormat, levels));
+        };
+        return *this;
+    }
+
+    Texture::Builder& Texture::Builder::fromCompressed2D(const CompressedImage& image) {
+        if (image.levels.empty())
+            throw std::runtime_error("compressed image has no level");
+
+        // S3TC formats are an extension, drivers without it get the decoded levels.
+        if (!CompressedImage::isSupported(image.format))
+            return fromMipmapChain2D(image.decode(), image.getDecodedFormat());
+
+        allocate(GL_TEXTURE_2D, image.format, image.width, image.height, 0, static_cast<GLsizei>(image.levels.size()));
+        uploadCompressed(id, image);
 
         return *this;
     }
 
-    Texture::Builder& Texture::Builder::fromFile2D(const std::string& path, GLenum internalFormat, bool flip) {
-        void* data;
-        GLenum compType;
-        int width, height, nrChannals;
+    Texture::Builder& Texture::Builder::fromFileKTX2(const std::string& path) {
+        fromCompressed2D(CompressedImage::loadKTX2(path));
+        m_reloader = [path](GLuint id) {
+            CompressedImage image = CompressedImage::loadKTX2(path);
+            if (CompressedImage::isSupported(image.format))
+                uploadCompressed(id, image);
+            else
+                uploadImages(id, image.decode().levels);
+        };
+        return *this;
+    }
 
-        stbi_set_flip_vertically_on_load(flip);
+    Texture::Builder& Texture::Builder::fromMipmapChain2D(const MipmapChain& chain, GLenum internalFormat) {
+        if (chain.levels.empty())
+            throw std::runtime_error("mipmap chain has no level");
 
-        if (path.ends_with(".hdr")) {
-            compType = GL_FLOAT;
-            data = stbi_loadf(path.c_str(), &width, &height, &nrChannals, 0);
-        } else {
-            compType = GL_UNSIGNED_BYTE;
-            data = stbi_load(path.c_str(), &width, &height, &nrChannals, 0);
-        }
+        if (id)
+            throw std::runtime_error("texture storage is already specified");
+        glCreateTextures(GL_TEXTURE_2D, 1, &id);
+        format = uploadLevels(id, internalFormat, chain.levels);
 
-        if (!data)
-            throw std::runtime_error(std::format("failed to open image: {}", path));
+        target = GL_TEXTURE_2D;
+        width = chain.levels.front().width;
+        height = chain.levels.front().height;
+        levels = static_cast<GLsizei>(chain.levels.size());
+        m_hasMipmapLevels = true;
 
-        GLenum srcFormat;
-        if (nrChannals == 3)
-            srcFormat = GL_RGB;
-        else if (nrChannals == 4)
-            srcFormat = GL_RGBA;
+        return *this;
+    }
+
+    Texture::Builder& Texture::Builder::fromBuffer(GLenum target, const void* data, GLsizei width, GLsizei height, GLsizei depth,
+                                                   GLenum srcFormat, GLenum compType, GLenum internalFormat, GLsizei levels) {
+        allocate(target, getSizedFormat(internalFormat, compType), width, height, depth, levels);
+
+        if (target == GL_TEXTURE_3D)
+            glTextureSubImage3D(id, 0, 0, 0, 0, width, height, depth, srcFormat, compType, data);
         else
-            throw std::runtime_error(std::format("image owns an unsupported format: \"{}\"", path));
-        
-        glBindTexture(GL_TEXTURE_2D, id);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, srcFormat, compType, data);
+            glTextureSubImage2D(id, 0, 0, 0, width, height, srcFormat, compType, data);
 
-        stbi_image_free(data);
+        return *this;
+    }
 
-        target = GL_TEXTURE_2D;
-        format = internalFormat;
+    void Texture::Builder::allocate(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height,
+                                    GLsizei depth, GLsizei levels) {
+        if (id)
+            throw std::runtime_error("texture storage is already specified");
+
+        if (levels == ALL_MIPMAP_LEVELS)
+            levels = getMipmapLevels(width, height, target == GL_TEXTURE_3D ? depth : 1);
+
+        glCreateTextures(target, 1, &id);
+        allocateStorage(id, target, internalFormat, width, height, depth, levels);
+
+        this->target = target;
+        this->format = internalFormat;
         this->width = width;
         this->height = height;
+        this->depth = depth;
+        this->levels = levels;
+    }
 
-        return *this;
+    GLuint Texture::Builder::getId() const {
+        if (!id)
+            throw std::runtime_error("texture storage isn't specified yet");
+        return id;
     }
 
     Texture::Builder& Texture::Builder::setFilter(GLenum minify, GLenum magnify) {
-        glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, minify);
-        glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, magnify);
+        glTextureParameteri(getId(), GL_TEXTURE_MIN_FILTER, minify);
+        glTextureParameteri(getId(), GL_TEXTURE_MAG_FILTER, magnify);
         return *this;
     }
 
     Texture::Builder& Texture::Builder::genMipmap() {
-        glBindTexture(target, id);
-        glGenerateMipmap(target);
+        if (levels == 1)
+            throw std::runtime_error("texture storage has a single level, allocate more levels for mipmap");
+
+        if (!m_hasMipmapLevels)
+            glGenerateTextureMipmap(getId());
         return *this;
     }
 
     Texture::Builder& Texture::Builder::setWrap(GLenum s, GLenum t) {
-        glTextureParameteri(id, GL_TEXTURE_WRAP_S, s);
-        glTextureParameteri(id, GL_TEXTURE_WRAP_T, t);
+        glTextureParameteri(getId(), GL_TEXTURE_WRAP_S, s);
+        glTextureParameteri(getId(), GL_TEXTURE_WRAP_T, t);
         return *this;
     }
 
     Texture::Builder& Texture::Builder::setWrap(GLenum s, GLenum t, GLenum r) {
-        glTextureParameteri(id, GL_TEXTURE_WRAP_S, s);
-        glTextureParameteri(id, GL_TEXTURE_WRAP_T, t);
-        glTextureParameteri(id, GL_TEXTURE_WRAP_R, r);
+        glTextureParameteri(getId(), GL_TEXTURE_WRAP_S, s);
+        glTextureParameteri(getId(), GL_TEXTURE_WRAP_T, t);
+        glTextureParameteri(getId(), GL_TEXTURE_WRAP_R, r);
         return *this;
     }
 
     Texture::Builder& Texture::Builder::setBorderColor(const glm::vec4& color) {
-        glTextureParameterfv(id, GL_TEXTURE_BORDER_COLOR, &color[0]);
+        glTextureParameterfv(getId(), GL_TEXTURE_BORDER_COLOR, &color[0]);
+        return *this;
+    }
+
+    Texture::Builder& Texture::Builder::setReloader(Reloader reloader) {
+        m_reloader = std::move(reloader);
         return *this;
     }
 
     Texture Texture::Builder::build() {
-        return Texture { id, target, format, width, height, depth };
+        if (m_pendingLevels.valid()) {
+            std::vector<Image> images = m_pendingLevels.get();
+            format = uploadLevels(getId(), format, images);
+            width = images.front().width;
+            height = images.front().height;
+            levels = static_cast<GLsizei>(images.size());
+        }
+
+        Texture texture { getId(), target, format, width, height, depth, levels };
+        texture.m_reloader = std::move(m_reloader);
+        return texture;
+    }
+
+    PendingTexture Texture::Builder::buildAsync() {
+        if (!m_pendingLevels.valid()) {
+            throw std::runtime_error("texture has no image being decoded");
+        }
+
+        PendingTexture pending {};
+        pending.m_id = id;
+        pending.m_format = format;
+        pending.m_levels = std::move(m_pendingLevels);
+        pending.m_reloader = std::move(m_reloader);
+        return pending;
+    }
+
+    Texture::Image Texture::decodeFile(const std::string& path, bool flip) {
+        // Flipping is a per-thread setting, so that concurrent decodings don't interfere.
+        stbi_set_flip_vertically_on_load_thread(flip);
+
+        if (path.ends_with(".hdr"))
+            return RadianceImage::load(path, GL_FLOAT, flip);
+
+        Image image {};
+        int width, height, nrChannals;
+
+        image.compType = GL_UNSIGNED_BYTE;
+        void* data = stbi_load(path.c_str(), &width, &height, &nrChannals, 0);
+
+        if (!data)
+            throw std::runtime_error(std::format("failed to open image: {}", path));
+
+        image.pixels = std::shared_ptr<void>(data, stbi_image_free);
+        image.width = width;
+        image.height = height;
+
+        if (nrChannals == 3)
+            image.srcFormat = GL_RGB;
+        else if (nrChannals == 4)
+            image.srcFormat = GL_RGBA;
+        else
+            throw std::runtime_error(std::format("image owns an unsupported format: \"{}\"", path));
+
+        return image;
+    }
+
+    std::vector<Texture::Image> Texture::decodeLevels(const std::string& path, bool flip,
+                                                      GLenum internalFormat, GLsizei levels) {
+        // Radiance images are decoded straight into the component type of half-float formats.
+        bool isRadiance = path.ends_with(".hdr");
+        GLenum radianceType = RadianceImage::getCompType(internalFormat);
+        if (isRadiance && levels == 1)
+            return { RadianceImage::load(path, radianceType, flip) };
+
+        Image image = decodeFile(path, flip);
+        if (levels == 1)
+            return { image };
+
+        bool isSrgb = internalFormat == GL_SRGB8 || internalFormat == GL_SRGB8_ALPHA8;
+        std::vector<Image> chain = MipmapChain::generate(image, levels, isSrgb).levels;
+        if (isRadiance) {
+            for (auto& level : chain)
+                level = RadianceImage::convert(level, radianceType);
+        }
+        return chain;
+    }
+
+    GLenum Texture::uploadLevels(GLuint id, GLenum internalFormat, const std::vector<Image>& levels,
+                                 TextureUploader* uploader) {
+        const Image& base = levels.front();
+        GLenum sizedFormat = getSizedFormat(internalFormat, base.compType);
+        glTextureStorage2D(id, static_cast<GLsizei>(levels.size()), sizedFormat, base.width, base.height);
+        uploadImages(id, levels, uploader);
+
+        return sizedFormat;
     }
 
-    Texture::Texture(GLuint id, GLenum target, GLenum format, GLsizei width, GLsizei height, GLsizei depth)
-    : id(id), target(target), format(format), width(width), height(height), depth(depth) {}
+    void Texture::uploadImages(GLuint id, const std::vector<Image>& levels, TextureUploader* uploader) {
+        // Rows of decoded images are tightly packed.
+        if (!uploader)
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (GLint level = 0; level < static_cast<GLint>(levels.size()); level++) {
+            const Image& image = levels[level];
+            if (uploader) {
+                uploader->upload(id, level, 0, 0, image.width, image.height,
+                                 image.srcFormat, image.compType, image.pixels.get());
+            } else {
+                glTextureSubImage2D(id, level, 0, 0, image.width, image.height,
+                                    image.srcFormat, image.compType, image.pixels.get());
+            }
+        }
+    }
+
+    void Texture::uploadCompressed(GLuint id, const CompressedImage& image) {
+        for (GLint level = 0; level < static_cast<GLint>(image.levels.size()); level++) {
+            const auto& data = image.levels[level];
+            glCompressedTextureSubImage2D(id, level, 0, 0,
+                                          std::max(image.width >> level, 1), std::max(image.height >> level, 1),
+                                          image.format, static_cast<GLsizei>(data.size()), data.data());
+        }
+    }
+
+    void Texture::allocateStorage(GLuint id, GLenum target, GLenum internalFormat, GLsizei width,
+                                  GLsizei height, GLsizei depth, GLsizei levels) {
+        if (target == GL_TEXTURE_3D || target == GL_TEXTURE_2D_ARRAY)
+            glTextureStorage3D(id, levels, internalFormat, width, height, depth);
+        else
+            glTextureStorage2D(id, levels, internalFormat, width, height);
+    }
+
+    PendingTexture::PendingTexture(PendingTexture&& right) noexcept {
+        *this = std::move(right);
+    }
+
+    PendingTexture& PendingTexture::operator=(PendingTexture&& right) noexcept {
+        m_id.swap(right.m_id);
+        std::swap(m_format, right.m_format);
+        std::swap(m_levels, right.m_levels);
+        std::swap(m_reloader, right.m_reloader);
+        return *this;
+    }
+
+    PendingTexture::~PendingTexture() {
+        if (m_id.has_value()) {
+            glDeleteTextures(1, &m_id.value());
+            m_id.reset();
+        }
+    }
+
+    bool PendingTexture::isReady() const {
+        return !m_levels.valid() || m_levels.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    Texture PendingTexture::get() {
+        return take(nullptr);
+    }
+
+    Texture PendingTexture::get(TextureUploader& uploader) {
+        return take(&uploader);
+    }
+
+    Texture PendingTexture::take(TextureUploader* uploader) {
+        if (!m_id.has_value() || !m_levels.valid()) {
+            throw std::runtime_error("texture is not pending");
+        }
+
+        // A failed decoding or upload rethrows here, and the texture object is released with the pending one.
+        std::vector<Texture::Image> images = m_levels.get();
+        GLuint id = m_id.value();
+        GLenum format = Texture::uploadLevels(id, m_format, images, uploader);
+        m_id.reset();
+
+        const Texture::Image& base = images.front();
+        Texture texture { id, GL_TEXTURE_2D, format, base.width, base.height, 0, static_cast<GLsizei>(images.size()) };
+        texture.m_reloader = std::move(m_reloader);
+        return texture;
+    }
+
+    Texture::Texture(GLuint id, GLenum target, GLenum format, GLsizei width, GLsizei height, GLsizei depth, GLsizei levels)
+    : id(id), target(target), format(format), width(width), height(height), depth(depth), levels(levels) {
+        MemoryBudget::getShared().track(*this);
+    }
 
     Texture::Texture(Texture&& right) noexcept {
         if (id.has_value()) {
@@ -135,14 +379,19 @@ namespace cabin::core {
         width = right.width;
         height = right.height;
         depth = right.depth;
+        levels = right.levels;
+        m_reloader = std::move(right.m_reloader);
+        m_evictedSampler = right.m_evictedSampler;
 
         right.id.reset();
+        MemoryBudget::getShared().relocate(right, *this);
     }
 
     Texture& Texture::operator=(Texture&& right) noexcept {
         if (id.has_value()) {
             glDeleteTextures(1, &id.value());
         }
+        MemoryBudget::getShared().untrack(*this);
 
         id = right.id;
         target = right.target;
@@ -150,12 +399,19 @@ namespace cabin::core {
         width = right.width;
         height = right.height;
         depth = right.depth;
+        levels = right.levels;
+        m_reloader = std::move(right.m_reloader);
+        m_evictedSampler = right.m_evictedSampler;
         right.id.reset();
+        MemoryBudget::getShared().relocate(right, *this);
         
         return *this;
     }
 
     Texture::~Texture() {
+        // Evicted textures have no object, but are still tracked.
+        MemoryBudget::getShared().untrack(*this);
+
         if (id.has_value()) {
             glDeleteTextures(1, &id.value());
             id.reset();
@@ -163,7 +419,83 @@ namespace cabin::core {
     }
 
     void Texture::active(GLuint index) const {
+        MemoryBudget::getShared().use(*this);
         glActiveTexture(GL_TEXTURE0 + index);
         glBindTexture(target, id.value());
     }
-}
\ No newline at end of file
+
+    void Texture::bindImage(GLuint unit, GLenum access, GLint level) const {
+        MemoryBudget::getShared().use(*this);
+        GLboolean isLayered = target == GL_TEXTURE_2D ? GL_FALSE : GL_TRUE;
+        glBindImageTexture(unit, id.value(), level, isLayered, 0, access, format);
+    }
+
+    GLsizei Texture::getMipmapLevels(GLsizei width, GLsizei height, GLsizei depth) {
+        GLsizei length = std::max({ width, height, depth, 1 });
+        return static_cast<GLsizei>(std::bit_width(static_cast<unsigned int>(length)));
+    }
+
+    GLenum Texture::getSizedFormat(GLenum internalFormat, GLenum compType) {
+        static constexpr GLenum BYTE_FORMATS[]  = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+        static constexpr GLenum SHORT_FORMATS[] = { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 };
+        static constexpr GLenum HALF_FORMATS[]  = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+        static constexpr GLenum FLOAT_FORMATS[] = { GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F };
+
+        size_t compCount;
+        switch (internalFormat) {
+            case GL_RED:  compCount = 1; break;
+            case GL_RG:   compCount = 2; break;
+            case GL_RGB:  compCount = 3; break;
+            case GL_RGBA: compCount = 4; break;
+            default:      return internalFormat;
+        }
+
+        // Packed floats only come with three components.
+        if (compType == GL_UNSIGNED_INT_10F_11F_11F_REV && compCount == 3)
+            return GL_R11F_G11F_B10F;
+
+        switch (compType) {
+            case GL_UNSIGNED_SHORT: return SHORT_FORMATS[compCount - 1];
+            case GL_HALF_FLOAT:     return HALF_FORMATS[compCount - 1];
+            case GL_FLOAT:          return FLOAT_FORMATS[compCount - 1];
+            default:                return BYTE_FORMATS[compCount - 1];
+        }
+    }
+
+    void Texture::evict() {
+        GLuint name = id.value();
+        SamplerState& sampler = m_evictedSampler;
+        glGetTextureParameteriv(name, GL_TEXTURE_MIN_FILTER, &sampler.minFilter);
+        glGetTextureParameteriv(name, GL_TEXTURE_MAG_FILTER, &sampler.magFilter);
+        glGetTextureParameteriv(name, GL_TEXTURE_WRAP_S, &sampler.wrapS);
+        glGetTextureParameteriv(name, GL_TEXTURE_WRAP_T, &sampler.wrapT);
+        glGetTextureParameteriv(name, GL_TEXTURE_WRAP_R, &sampler.wrapR);
+        glGetTextureParameterfv(name, GL_TEXTURE_BORDER_COLOR, &sampler.borderColor[0]);
+
+        glDeleteTextures(1, &name);
+        id.reset();
+    }
+
+    void Texture::reload() {
+        GLuint name;
+        glCreateTextures(target, 1, &name);
+        allocateStorage(name, target, format, width, height, depth, levels);
+
+        const SamplerState& sampler = m_evictedSampler;
+        glTextureParameteri(name, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+        glTextureParameteri(name, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+        glTextureParameteri(name, GL_TEXTURE_WRAP_S, sampler.wrapS);
+        glTextureParameteri(name, GL_TEXTURE_WRAP_T, sampler.wrapT);
+        glTextureParameteri(name, GL_TEXTURE_WRAP_R, sampler.wrapR);
+        glTextureParameterfv(name, GL_TEXTURE_BORDER_COLOR, &sampler.borderColor[0]);
+
+        // The texture stays evicted if the contents fail to reload.
+        try {
+            m_reloader(name);
+        } catch (...) {
+            glDeleteTextures(1, &name);
+            throw;
+        }
+        id = name;
+    }
+}
@@ -8,7 +8,10 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <future>
+#include <memory>
 #include <optional>
+#include <functional>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -16,60 +19,108 @@
 
 namespace cabin::core {
 
+    class MipmapChain;
+    class PendingTexture;
+    class CompressedImage;
+    class TextureUploader;
+
     class Texture {
     public:
+        //! Pixels decoded from an image file, waiting to be uploaded.
+        struct Image {
+            std::shared_ptr<void> pixels {};
+            GLsizei width { 0 }, height { 0 };
+            GLenum srcFormat {}, compType {};
+        };
+
+        /** Decode an image file, without touching the OpenGL context.
+         *
+         * @note Safe to call from any thread, `.hdr` files are decoded as floats by `RadianceImage`.
+         *
+         * @throw `std::runtime_error` if the image can't be decoded, or has
+         *        neither 3 nor 4 channels.
+         */
+        static Image decodeFile(const std::string& path, bool flip = true);
+
+        //! Pass as the level count to allocate the complete mipmap chain.
+        static constexpr GLsizei ALL_MIPMAP_LEVELS = 0;
+
+        /** Upload the contents of an evicted texture again, into the new storage of `id`.
+         *
+         * @note The storage is allocated with the same format, size and levels,
+         *       and the sampler settings are restored, see `MemoryBudget`.
+         */
+        using Reloader = std::function<void(GLuint id)>;
+
         class Builder {
         public:
-            Builder();
+            Builder() = default;
 
             Builder(Builder&&) = delete;
             Builder(const Builder&) = delete;
 
-            Builder& asEmpty2D(GLsizei width, GLsizei height, GLenum internalFormat);
-            Builder& asEmpty3D(GLsizei width, GLsizei height, GLsizei depth, GLenum internalFormat);
-            Builder& asEmptyCubeMap(GLsizei length, GLenum internalFormat);
+            /** Allocate immutable storage, with `levels` mipmap levels.
+             *
+             * @note The storage can't be resized or reformatted afterwards, and
+             *       unsized formats (e.g. `GL_RGB`) are promoted to 8-bit sized ones.
+             */
+            Builder& asEmpty2D(GLsizei width, GLsizei height, GLenum internalFormat, GLsizei levels = 1);
+            Builder& asEmpty3D(GLsizei width, GLsizei height, GLsizei depth, GLenum internalFormat, GLsizei levels = 1);
+            Builder& asEmptyCubeMap(GLsizei length, GLenum internalFormat, GLsizei levels = 1);
+
+            //! Allocate a `GL_TEXTURE_2D_ARRAY` of `layers` images of the same size and format.
+            Builder& asEmpty2DArray(GLsizei width, GLsizei height, GLsizei layers, GLenum internalFormat, GLsizei levels = 1);
+
+            /** Decode an image file, and upload it with its mipmap levels.
+             *
+             * @note Levels beyond the first are generated by `MipmapChain` on the CPU,
+             *       filtered in linear space for `GL_SRGB8` and `GL_SRGB8_ALPHA8`.
+             *       `.hdr` files are decoded into half floats for `GL_RGB16F`, and
+             *       packed floats for `GL_R11F_G11F_B10F`, see `RadianceImage`.
+             */
+            Builder& fromFile2D(const std::string& path, GLenum internalFormat = GL_RGBA8,
+                                bool flip = true, GLsizei levels = 1);
 
-            Builder& fromFile2D(const std::string& path, GLenum internalFormat = GL_RGBA, bool flip = true);
+            /** Decode the image file on the shared thread pool, instead of blocking.
+             *
+             * @note Other settings apply to the texture right away, while the mipmap
+             *       levels are generated by the worker as well, and the storage is
+             *       deferred until the levels are uploaded by `PendingTexture::get`
+             *       (or by `build`, which waits for the decoding).
+             */
+            Builder& fromFile2DAsync(const std::string& path, GLenum internalFormat = GL_RGBA8,
+                                     bool flip = true, GLsizei levels = 1);
             
+            /** Allocate immutable storage with the levels of a BCn image, and upload them.
+             *
+             * @note Compressed textures can't generate mipmaps, so levels should be
+             *       encoded into the image.
+             *
+             * @note S3TC images are decoded into `GL_RGBA8` (or `GL_SRGB8_ALPHA8`)
+             *       levels if the driver lacks `GL_EXT_texture_compression_s3tc`.
+             */
+            Builder& fromCompressed2D(const CompressedImage& image);
+
+            //! Load a KTX2 file holding a BCn image, see `CompressedImage::loadKTX2`.
+            Builder& fromFileKTX2(const std::string& path);
+
+            //! Allocate immutable storage with the levels of a mipmap chain, and upload them.
+            Builder& fromMipmapChain2D(const MipmapChain& chain, GLenum internalFormat = GL_RGBA8);
+
             template <typename T>
                 requires (std::is_same_v<T, unsigned char> || std::is_same_v<T, float>)
-            Builder& fromBuffer2D(const T* data, GLsizei width, GLsizei height, GLenum srcFormat, GLenum internalFormat) {
-                target = GL_TEXTURE_2D;
-                format = internalFormat;
-                this->width = width;
-                this->height = height;
-
-                GLenum compType;
-                if constexpr (std::is_same_v<T, unsigned char>)
-                    compType = GL_UNSIGNED_BYTE;
-                else
-                    compType = GL_FLOAT;
-
-                glBindTexture(GL_TEXTURE_2D, id);
-                glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, srcFormat, compType, data);
-
-                return *this;
+            Builder& fromBuffer2D(const T* data, GLsizei width, GLsizei height, GLenum srcFormat,
+                                  GLenum internalFormat, GLsizei levels = 1) {
+                return fromBuffer(GL_TEXTURE_2D, data, width, height, 0, srcFormat,
+                                  std::is_same_v<T, float> ? GL_FLOAT : GL_UNSIGNED_BYTE, internalFormat, levels);
             }
 
             template <typename T>
                 requires (std::is_same_v<T, unsigned char> || std::is_same_v<T, float>)
-            Builder& fromBuffer3D(const T* data, GLsizei width, GLsizei height, GLsizei depth, GLenum srcFormat, GLenum internalFormat) {
-                target = GL_TEXTURE_3D;
-                format = internalFormat;
-                this->width = width;
-                this->height = height;
-                this->depth = depth;
-
-                GLenum compType;
-                if constexpr (std::is_same_v<T, unsigned char>)
-                    compType = GL_UNSIGNED_BYTE;
-                else
-                    compType = GL_FLOAT;
-
-                glBindTexture(GL_TEXTURE_3D, id);
-                glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0, srcFormat, compType, data);
-
-                return *this;
+            Builder& fromBuffer3D(const T* data, GLsizei width, GLsizei height, GLsizei depth, GLenum srcFormat,
+                                  GLenum internalFormat, GLsizei levels = 1) {
+                return fromBuffer(GL_TEXTURE_3D, data, width, height, depth, srcFormat,
+                                  std::is_same_v<T, float> ? GL_FLOAT : GL_UNSIGNED_BYTE, internalFormat, levels);
             }
 
             /** Set the texture filtering way when minify and magify.
@@ -81,7 +132,12 @@ namespace cabin::core {
              */
             Builder& setFilter(GLenum minify, GLenum magnify);
 
-            //! Generate mipmap for texture.
+            /** Generate mipmap for texture.
+             *
+             * @note Fills the levels allocated with the storage on the GPU, so throws
+             *       if the texture has a single level. Levels of images and chains,
+             *       already generated on the CPU, are kept.
+             */
             Builder& genMipmap();
             
             //! Set the wrapping way for Texture2D.
@@ -96,18 +152,46 @@ namespace cabin::core {
              */
             Builder& setBorderColor(const glm::vec4& color);
 
+            /** Make the texture evictable by `MemoryBudget`, reloaded by the reloader.
+             *
+             * @note Textures from files (and KTX2 files) are reloaded from the files already.
+             */
+            Builder& setReloader(Reloader reloader);
+
             Texture build();
 
+            /** Take the texture whose image is still being decoded.
+             *
+             * @note Decoding errors are reported by `PendingTexture::get`.
+             */
+            PendingTexture buildAsync();
+
+        private:
+            //! Create the texture object and allocate its immutable storage.
+            void allocate(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height,
+                          GLsizei depth, GLsizei levels);
+
+            Builder& fromBuffer(GLenum target, const void* data, GLsizei width, GLsizei height, GLsizei depth,
+                                GLenum srcFormat, GLenum compType, GLenum internalFormat, GLsizei levels);
+
+            //! Get the texture object, throws if no storage was specified yet.
+            GLuint getId() const;
+
         private:
             GLuint id {};
             GLenum target {};
             GLenum format {};
             GLsizei width {0}, height {0}, depth {0};
+            GLsizei levels {1};
+
+            std::future<std::vector<Image>> m_pendingLevels {};
+            bool m_hasMipmapLevels { false };
+            Reloader m_reloader {};
         };
 
     public:
         Texture() = default;
-        Texture(GLuint id, GLenum target, GLenum format, GLsizei width, GLsizei height, GLsizei depth);
+        Texture(GLuint id, GLenum target, GLenum format, GLsizei width, GLsizei height, GLsizei depth, GLsizei levels = 1);
 
         Texture(Texture&& right) noexcept;
         Texture& operator=(Texture&&) noexcept;
@@ -122,12 +206,119 @@ namespace cabin::core {
         /** Activate a texture unit, and assign current texture to it.
          * 
          * @param index The index of the texture unit to be activated.
+         *
+         * @note Marks the texture as used in this frame, reloading it if evicted.
          */
         void active(GLuint index) const;
 
+        /** Bind a mipmap level of the texture to an image unit. (wrapper of `glBindImageTexture`)
+         *
+         * @param unit   The index of the image unit.
+         * @param access `GL_READ_ONLY`, `GL_WRITE_ONLY` or `GL_READ_WRITE`.
+         * @param level  The mipmap level to be bound.
+         *
+         * @note All layers of 3D textures and cube maps are bound, and the
+         *       texture's format should be image-compatible (e.g. not `GL_RGB32F`).
+         */
+        void bindImage(GLuint unit, GLenum access, GLint level = 0) const;
+
+        //! Get the level count of a complete mipmap chain.
+        static GLsizei getMipmapLevels(GLsizei width, GLsizei height, GLsizei depth = 1);
+
+        /** Get the sized internal format for an unsized one, e.g. `GL_RGBA8` for `GL_RGBA`.
+         *
+         * @param compType Component type of the source pixels, selecting the component size.
+         *
+         * @note Sized formats are returned unchanged.
+         */
+        static GLenum getSizedFormat(GLenum internalFormat, GLenum compType = GL_UNSIGNED_BYTE);
+
+    private:
+        friend class MemoryBudget;
+        friend class PendingTexture;
+
+        //! Sampler settings kept while the storage is evicted.
+        struct SamplerState {
+            GLint minFilter, magFilter;
+            GLint wrapS, wrapT, wrapR;
+            glm::vec4 borderColor;
+        };
+
+        //! Release the storage, keeping the sampler settings for `reload`.
+        void evict();
+
+        //! Allocate the storage again, and upload its contents with the reloader.
+        void reload();
+
+        //! Allocate immutable storage for a texture object.
+        static void allocateStorage(GLuint id, GLenum target, GLenum internalFormat, GLsizei width,
+                                    GLsizei height, GLsizei depth, GLsizei levels);
+
+        //! Decode an image file, and generate its mipmap levels for the internal format.
+        static std::vector<Image> decodeLevels(const std::string& path, bool flip, GLenum internalFormat, GLsizei levels);
+
+        /** Allocate the storage of a 2D texture, and upload the images as its levels.
+         *
+         * @return The sized internal format of the storage.
+         */
+        static GLenum uploadLevels(GLuint id, GLenum internalFormat, const std::vector<Image>& levels,
+                                   TextureUploader* uploader = nullptr);
+
+        //! Upload the images as the levels of a 2D texture, into its storage.
+        static void uploadImages(GLuint id, const std::vector<Image>& levels, TextureUploader* uploader = nullptr);
+
+        //! Upload the levels of a BCn image, into the storage of a 2D texture.
+        static void uploadCompressed(GLuint id, const CompressedImage& image);
+
     public:
         std::optional<GLuint> id;
         GLenum target, format;
         GLsizei width, height, depth;
+        GLsizei levels;
+
+    private:
+        Reloader m_reloader {};
+        SamplerState m_evictedSampler {};
+    };
+
+    /** 2D texture whose image is being decoded in background.
+     *
+     * @note Created by `Texture::Builder::buildAsync`.
+     */
+    class PendingTexture {
+    public:
+        PendingTexture() = default;
+        PendingTexture(PendingTexture&& right) noexcept;
+        PendingTexture& operator=(PendingTexture&& right) noexcept;
+        PendingTexture(const PendingTexture&) = delete;
+        PendingTexture& operator=(const PendingTexture&) = delete;
+
+        ~PendingTexture();
+
+        //! Check whether the image is decoded, without blocking.
+        bool isReady() const;
+
+        /** Upload the decoded image and take the texture, blocks until decoding finishes.
+         *
+         * @throw `std::runtime_error` if the image fails to decode.
+         */
+        Texture get();
+
+        /** Same as `get`, but stream the image through the uploader's staging buffers.
+         *
+         * @note The copy overlaps rendering, until the uploader is flushed.
+         */
+        Texture get(TextureUploader& uploader);
+
+    private:
+        Texture take(TextureUploader* uploader);
+
+    private:
+        friend class Texture::Builder;
+
+        std::optional<GLuint> m_id {};
+        GLenum m_format {};
+        std::future<std::vector<Texture::Image>> m_levels {};
+        Texture::Reloader m_reloader {};
     };
 }
\ No newline at end of file
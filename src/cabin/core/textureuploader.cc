@@ -0,0 +1,198 @@
+#include "textureuploader.h"
+
+#include <format>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace cabin::core {
+
+    namespace {
+        //! Offsets into unpack buffers must be aligned to the component type.
+        constexpr GLsizeiptr STAGING_ALIGNMENT = 16;
+    }
+
+    TextureUploader::TextureUploader(GLsizeiptr bufferSize, GLuint bufferCount)
+    : m_bufferSize(bufferSize) {
+        if (bufferSize <= 0 || bufferCount == 0)
+            throw std::runtime_error("failed to create TextureUploader with empty capacity!");
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        for (GLuint i = 0; i < bufferCount; i++) {
+            GLuint buffer;
+            glCreateBuffers(1, &buffer);
+            glNamedBufferStorage(buffer, bufferSize, nullptr, flags);
+
+            auto mappedData = static_cast<std::byte*>(glMapNamedBufferRange(buffer, 0, bufferSize, flags));
+            m_buffers.push_back(StagingBuffer { buffer, mappedData, nullptr });
+
+            if (!mappedData) {
+                release();
+                throw std::runtime_error("failed to map TextureUploader staging buffer persistently!");
+            }
+        }
+    }
+
+    TextureUploader::TextureUploader(TextureUploader&& right) noexcept {
+        *this = std::move(right);
+    }
+
+    TextureUploader& TextureUploader::operator=(TextureUploader&& right) noexcept {
+        release();
+
+        m_buffers.swap(right.m_buffers);
+        m_bufferSize = right.m_bufferSize;
+        m_bufferOffset = right.m_bufferOffset;
+        m_bufferIndex = right.m_bufferIndex;
+        m_stallCount = right.m_stallCount;
+
+        return *this;
+    }
+
+    TextureUploader::~TextureUploader() {
+        release();
+    }
+
+    void TextureUploader::release() {
+        for (StagingBuffer& buffer : m_buffers) {
+            if (buffer.fence)
+                glDeleteSync(buffer.fence);
+            if (buffer.mappedData)
+                glUnmapNamedBuffer(buffer.id);
+            glDeleteBuffers(1, &buffer.id);
+        }
+        m_buffers.clear();
+        m_bufferOffset = 0;
+        m_bufferIndex = 0;
+    }
+
+    void TextureUploader::upload(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                                 GLenum srcFormat, GLenum compType, const void* pixels) {
+        uploadRows(texture, level, x, y, -1, width, height, srcFormat, compType, pixels);
+    }
+
+    void TextureUploader::upload(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height,
+                                 GLenum srcFormat, GLenum compType, const void* pixels) {
+        if (layer < 0)
+            throw std::runtime_error(std::format("invalid texture layer {} for upload!", layer));
+        uploadRows(texture, level, x, y, layer, width, height, srcFormat, compType, pixels);
+    }
+
+    void TextureUploader::uploadRows(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height,
+                                     GLenum srcFormat, GLenum compType, const void* pixels) {
+        if (m_buffers.empty())
+            throw std::runtime_error("TextureUploader has no staging buffer!");
+
+        // Empty rectangles upload nothing, and would have no row size to count rows with.
+        if (width <= 0 || height <= 0)
+            return;
+
+        GLsizeiptr rowSize = width * getPixelSize(srcFormat, compType);
+        if (rowSize > m_bufferSize - STAGING_ALIGNMENT)
+            throw std::runtime_error(std::format("texture row of {} bytes exceeds the staging buffer!", rowSize));
+
+        // Rows are staged tightly packed, whatever the unpack state was.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+
+        auto source = static_cast<const std::byte*>(pixels);
+        GLsizei row = 0;
+        while (row < height) {
+            GLsizeiptr offset = (m_bufferOffset + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+            GLsizei rowCount = static_cast<GLsizei>(std::min<GLsizeiptr>(height - row, (m_bufferSize - offset) / rowSize));
+            if (offset >= m_bufferSize || rowCount <= 0) {
+                nextBuffer();
+                continue;
+            }
+
+            StagingBuffer& buffer = m_buffers[m_bufferIndex];
+            std::memcpy(buffer.mappedData + offset, source + row * rowSize, rowCount * rowSize);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+            if (layer < 0)
+                glTextureSubImage2D(texture, level, x, y + row, width, rowCount, srcFormat, compType,
+                                    reinterpret_cast<const void*>(offset));
+            else
+                glTextureSubImage3D(texture, level, x, y + row, layer, width, rowCount, 1, srcFormat, compType,
+                                    reinterpret_cast<const void*>(offset));
+
+            m_bufferOffset = offset + rowCount * rowSize;
+            row += rowCount;
+        }
+
+        // Leave no unpack buffer bound, or later client-memory uploads would read from it.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void TextureUploader::flush() {
+        if (m_bufferOffset > 0)
+            nextBuffer();
+    }
+
+    size_t TextureUploader::getStallCount() const {
+        return m_stallCount;
+    }
+
+    void TextureUploader::nextBuffer() {
+        GLsync& currentFence = m_buffers[m_bufferIndex].fence;
+        if (currentFence)
+            glDeleteSync(currentFence);
+        currentFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        m_bufferIndex = (m_bufferIndex + 1) % m_buffers.size();
+        m_bufferOffset = 0;
+
+        GLsync& fence = m_buffers[m_bufferIndex].fence;
+        if (!fence)
+            return;
+
+        GLenum waitResult = glClientWaitSync(fence, 0, 0);
+        if (waitResult == GL_TIMEOUT_EXPIRED)
+            m_stallCount++;
+        while (waitResult == GL_TIMEOUT_EXPIRED) {
+            waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLsizeiptr TextureUploader::getPixelSize(GLenum srcFormat, GLenum compType) {
+        // Packed types hold all components of a pixel.
+        if (compType == GL_UNSIGNED_INT_10F_11F_11F_REV || compType == GL_UNSIGNED_INT_5_9_9_9_REV ||
+            compType == GL_UNSIGNED_INT_2_10_10_10_REV)
+            return 4;
+
+        GLsizeiptr compCount;
+        switch (srcFormat) {
+            case GL_RED: case GL_RED_INTEGER:
+                compCount = 1; break;
+            case GL_RG: case GL_RG_INTEGER:
+                compCount = 2; break;
+            case GL_RGB: case GL_BGR: case GL_RGB_INTEGER:
+                compCount = 3; break;
+            case GL_RGBA: case GL_BGRA: case GL_RGBA_INTEGER:
+                compCount = 4; break;
+            default:
+                throw std::runtime_error(std::format("unsupported pixel format for upload: 0x{:x}", srcFormat));
+        }
+
+        GLsizeiptr compSize;
+        switch (compType) {
+            case GL_BYTE: case GL_UNSIGNED_BYTE:
+                compSize = 1; break;
+            case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT:
+                compSize = 2; break;
+            case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT:
+                compSize = 4; break;
+            default:
+                throw std::runtime_error(std::format("unsupported pixel type for upload: 0x{:x}", compType));
+        }
+
+        return compCount * compSize;
+    }
+}
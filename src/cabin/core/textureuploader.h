@@ -0,0 +1,105 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace cabin::core {
+
+    /** Streaming Texture Uploader
+     *
+     * --------------------------
+     * `TextureUploader` stages pixel data through a pool of
+     *  `GL_PIXEL_UNPACK_BUFFER`s, each mapped once with
+     *  `GL_MAP_PERSISTENT_BIT`. Uploads are copied into the staging
+     *  buffer in use, and the texture update is sourced from it, so
+     *  the driver copies asynchronously instead of stalling on
+     *  client memory.
+     *
+     *  A staging buffer is fenced when it's full or flushed, and
+     *  only reused once the GPU has finished reading it. Images
+     *  larger than a staging buffer are split into row bands.
+     *
+     * @see Usage example:
+     *       sandbox/image_viewer/main.cc
+     */
+    class TextureUploader {
+    public:
+        TextureUploader() = default;
+
+        /** Create and map the staging buffers.
+         *
+         * @param bufferSize  Capacity of each staging buffer (in byte).
+         * @param bufferCount Number of staging buffers, i.e. flushes in flight.
+         */
+        TextureUploader(GLsizeiptr bufferSize, GLuint bufferCount = 3);
+
+        TextureUploader(TextureUploader&& right) noexcept;
+        TextureUploader& operator=(TextureUploader&& right) noexcept;
+
+        TextureUploader(const TextureUploader&) = delete;
+        TextureUploader& operator=(const TextureUploader&) = delete;
+
+        ~TextureUploader();
+
+        /** Upload pixels into a sub-rectangle of a mipmap level of a 2D texture.
+         *
+         * @param texture   The texture object, whose level storage is already allocated.
+         * @param level     The mipmap level to be updated.
+         * @param x, y      Offset of the sub-rectangle in texels.
+         * @param srcFormat Format of the source pixels, e.g. `GL_RGBA`.
+         * @param compType  Component type of the source pixels, e.g. `GL_UNSIGNED_BYTE`.
+         * @param pixels    Tightly packed rows of source pixels.
+         *
+         * @note Pixels are copied before returning, so they can be released right away.
+         *       Blocks only when all staging buffers are still read by the GPU.
+         *
+         * @throw `std::runtime_error` if a row of pixels doesn't fit into a staging buffer.
+         */
+        void upload(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                    GLenum srcFormat, GLenum compType, const void* pixels);
+
+        //! Same as the 2D one, but upload into a layer of a 2D array texture.
+        void upload(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height,
+                    GLenum srcFormat, GLenum compType, const void* pixels);
+
+        //! Fence the staging buffer in use, e.g. once per frame after the uploads of the frame.
+        void flush();
+
+        //! Get the number of times uploads had to wait for the GPU.
+        size_t getStallCount() const;
+
+        //! Get the size of a pixel (in byte), throws on unsupported formats or types.
+        static GLsizeiptr getPixelSize(GLenum srcFormat, GLenum compType);
+
+    private:
+        //! Stage the rows and update the texture, `layer` is negative for 2D textures.
+        void uploadRows(GLuint texture, GLint level, GLint x, GLint y, GLint layer, GLsizei width, GLsizei height,
+                        GLenum srcFormat, GLenum compType, const void* pixels);
+
+        //! Fence the staging buffer in use, and switch to the next one.
+        void nextBuffer();
+
+        void release();
+
+    private:
+        struct StagingBuffer {
+            GLuint id;
+            std::byte* mappedData;
+            GLsync fence;
+        };
+
+        std::vector<StagingBuffer> m_buffers {};
+        GLsizeiptr m_bufferSize { 0 };
+        GLsizeiptr m_bufferOffset { 0 };
+        GLuint m_bufferIndex { 0 };
+        size_t m_stallCount { 0 };
+    };
+}
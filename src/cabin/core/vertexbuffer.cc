@@ -1,84 +1,175 @@
 #include "vertexbuffer.h"
 
 #include <stdexcept>
+#include <algorithm>
+#include "memorybudget.h"
 
 namespace cabin::core {
     VertexBuffer::Builder::Builder() {
-        glGenBuffers(1, &vertexBufferID);
-        glGenVertexArrays(1, &vertexArrayID);
+        glCreateBuffers(1, &vertexBufferID);
     }
 
     VertexBuffer::Builder& VertexBuffer::Builder::setBuffer(const void* data, GLsizeiptr size, GLenum usage) {
-        glBindVertexArray(vertexArrayID);
-        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-        glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+        glNamedBufferData(vertexBufferID, size, data, usage);
+        MemoryBudget::getShared().track(MemoryBudget::Category::VertexBuffer, vertexBufferID, size);
+        bufferSize = size;
 
         return *this;
     }
 
+    VertexBuffer::Builder& VertexBuffer::Builder::setIndexBuffer(const void* data, size_t count, GLenum type, GLenum usage) {
+        if (elementBufferID == 0)
+            glCreateBuffers(1, &elementBufferID);
+
+        size_t indexSize = type == GL_UNSIGNED_BYTE ? 1 : (type == GL_UNSIGNED_SHORT ? 2 : 4);
+        auto size = static_cast<GLsizeiptr>(count * indexSize);
+
+        glNamedBufferData(elementBufferID, size, data, usage);
+        MemoryBudget::getShared().track(MemoryBudget::Category::VertexBuffer, elementBufferID, size);
+
+        indexType = type;
+        indexCount = static_cast<GLsizei>(count);
+        return *this;
+    }
+
+    VertexBuffer::Builder& VertexBuffer::Builder::enablePrimitiveRestart() {
+        hasPrimitiveRestart = true;
+        return *this;
+    }
+
     VertexBuffer VertexBuffer::Builder::build() {
-        if (attributes.empty())
+        if (format.attributes.empty())
             throw std::runtime_error("failed to build VertexBuffer without any attribute!");
 
-        GLuint strideSize = 0;
-        size_t offsetRecord = 0;
+        if (hasPrimitiveRestart && elementBufferID == 0)
+            throw std::runtime_error("failed to build VertexBuffer with primitive restart but no indices!");
 
-        for (auto& attr : attributes) {
-            strideSize += attr.storageSize;
+        // Formats are set once per layout, the buffers are attached to binding point `0` on bind.
+        auto [it, isInserted] = getSharedArrays().try_emplace(format);
+        SharedArray& sharedArray = it->second;
+        if (isInserted) {
+            glCreateVertexArrays(1, &sharedArray.id);
+            format.apply(sharedArray.id);
         }
-
-        glBindVertexArray(vertexArrayID);
-        for (auto& attr : attributes) {
-            glVertexAttribPointer(attr.index, attr.count, attr.storageType, attr.normalized, strideSize, reinterpret_cast<void*>(offsetRecord));
-            glEnableVertexAttribArray(attr.index);
-            offsetRecord += attr.storageSize;
+        sharedArray.refCount++;
+
+        VertexBuffer result { vertexBufferID, sharedArray.id };
+        result.m_sharedArray = &sharedArray;
+        result.stride = format.stride;
+        result.vertexCount = static_cast<GLsizei>(bufferSize / format.stride);
+        if (elementBufferID != 0) {
+            result.EBO = elementBufferID;
+            result.indexCount = indexCount;
+            result.indexType = indexType;
+            result.hasPrimitiveRestart = hasPrimitiveRestart;
         }
-
-        return VertexBuffer { vertexBufferID, vertexArrayID };
+        return result;
     }
 
     VertexBuffer::VertexBuffer(GLuint VBO, GLuint VAO)
     : VBO(VBO), VAO(VAO) {}
 
     VertexBuffer::VertexBuffer(VertexBuffer&& right) noexcept {
-        if (VAO.has_value() && VBO.has_value()) {
-            glDeleteVertexArrays(1, &VAO.value());
-            glDeleteBuffers(1, &VBO.value());
-        }
-        
-        VAO = right.VAO;
-        VBO = right.VBO;
-        right.VAO.reset();
-        right.VBO.reset();
+        *this = std::move(right);
     }
 
     VertexBuffer& VertexBuffer::operator=(VertexBuffer&& right) noexcept {
-        if (VAO.has_value() && VBO.has_value()) {
-            glDeleteVertexArrays(1, &VAO.value());
-            glDeleteBuffers(1, &VBO.value());
-        }
+        release();
 
         VAO = right.VAO;
         VBO = right.VBO;
+        EBO = right.EBO;
+        vertexCount = right.vertexCount;
+        indexCount = right.indexCount;
+        indexType = right.indexType;
+        hasPrimitiveRestart = right.hasPrimitiveRestart;
+        stride = right.stride;
+        m_sharedArray = right.m_sharedArray;
         right.VAO.reset();
         right.VBO.reset();
+        right.EBO.reset();
+        right.m_sharedArray = nullptr;
 
         return *this;
     }
 
     VertexBuffer::~VertexBuffer() {
-        if (VAO.has_value()) {
+        release();
+    }
+
+    void VertexBuffer::bind() const {
+        glBindVertexArray(VAO.value());
+        if (m_sharedArray == nullptr)
+            return;
+
+        if (m_sharedArray->vertexBuffer != VBO.value()) {
+            glVertexArrayVertexBuffer(VAO.value(), 0, VBO.value(), 0, stride);
+            m_sharedArray->vertexBuffer = VBO.value();
+        }
+
+        GLuint elementBuffer = EBO.value_or(0);
+        if (m_sharedArray->elementBuffer != elementBuffer) {
+            glVertexArrayElementBuffer(VAO.value(), elementBuffer);
+            m_sharedArray->elementBuffer = elementBuffer;
+        }
+    }
+
+    void VertexBuffer::draw(GLenum mode) const {
+        bind();
+        if (!EBO.has_value()) {
+            glDrawArrays(mode, 0, vertexCount);
+            return;
+        }
+
+        // Primitive restart is a global state, only enabled while drawing buffers using it,
+        // and left enabled if the caller had enabled it.
+        bool togglesRestart = hasPrimitiveRestart && !glIsEnabled(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        if (togglesRestart)
+            glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        glDrawElements(mode, indexCount, indexType, nullptr);
+        if (togglesRestart)
+            glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    }
+
+    std::map<vertex::Format, VertexBuffer::SharedArray>& VertexBuffer::getSharedArrays() {
+        static std::map<vertex::Format, SharedArray> sharedArrays {};
+        return sharedArrays;
+    }
+
+    void VertexBuffer::release() {
+        if (m_sharedArray != nullptr) {
+            if (--m_sharedArray->refCount == 0) {
+                glDeleteVertexArrays(1, &m_sharedArray->id);
+                std::erase_if(getSharedArrays(), [this](const auto& entry) {
+                    return &entry.second == m_sharedArray;
+                });
+            } else {
+                // Detach the buffers about to be deleted, a shared vertex array would keep them alive.
+                if (m_sharedArray->vertexBuffer == VBO.value_or(0)) {
+                    glVertexArrayVertexBuffer(m_sharedArray->id, 0, 0, 0, stride);
+                    m_sharedArray->vertexBuffer = 0;
+                }
+                if (EBO.has_value() && m_sharedArray->elementBuffer == EBO.value()) {
+                    glVertexArrayElementBuffer(m_sharedArray->id, 0);
+                    m_sharedArray->elementBuffer = 0;
+                }
+            }
+            m_sharedArray = nullptr;
+        } else if (VAO.has_value()) {
             glDeleteVertexArrays(1, &VAO.value());
-            VAO.reset();
         }
+        VAO.reset();
 
         if (VBO.has_value()) {
+            MemoryBudget::getShared().untrack(MemoryBudget::Category::VertexBuffer, VBO.value());
             glDeleteBuffers(1, &VBO.value());
             VBO.reset();
         }
-    }
 
-    void VertexBuffer::bind() const {
-        glBindVertexArray(VAO.value());
+        if (EBO.has_value()) {
+            MemoryBudget::getShared().untrack(MemoryBudget::Category::VertexBuffer, EBO.value());
+            glDeleteBuffers(1, &EBO.value());
+            EBO.reset();
+        }
     }
 }
\ No newline at end of file
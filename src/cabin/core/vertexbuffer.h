@@ -6,25 +6,19 @@
  */
 
 #pragma once
+#include <map>
 #include <vector>
+#include <cstddef>
 #include <optional>
 
 #include <glad/glad.h>
+#include "vertexlayout.h"
 
 namespace cabin::core {
     
     class VertexBuffer {
     public:
         class Builder {
-        private:
-            struct AttributeInfo {
-                GLuint index;
-                GLuint count;
-                GLuint storageSize;
-                GLenum storageType;
-                bool normalized;
-            };
-
         public:
             Builder();
             Builder(Builder&&) = delete;
@@ -38,39 +32,80 @@ namespace cabin::core {
              */
             Builder& setBuffer(const void* data, GLsizeiptr size, GLenum usage);
 
-            /** Add a vertex array attribute.
+            /** Allocate element buffer and set indices.
+             *
+             * @tparam T    Index type, whose width is kept on the GPU, e.g.
+             *              `unsigned short` indices take half of the memory of `unsigned int`.
+             * @param count Number of indices.
+             *
+             * @note Indices are copied into the element buffer, so the source can be dropped
+             *       right after, and `VertexBuffer::draw` draws them with `glDrawElements`.
+             */
+            template <typename T>
+                requires std::is_same_v<T, unsigned char> || std::is_same_v<T, unsigned short> ||
+                         std::is_same_v<T, unsigned int>
+            Builder& setIndices(const T* data, size_t count, GLenum usage = GL_STATIC_DRAW) {
+                GLenum type;
+                if constexpr (std::is_same_v<T, unsigned char>)
+                    type = GL_UNSIGNED_BYTE;
+                else if constexpr (std::is_same_v<T, unsigned short>)
+                    type = GL_UNSIGNED_SHORT;
+                else
+                    type = GL_UNSIGNED_INT;
+
+                return setIndexBuffer(data, count, type, usage);
+            }
+
+            /** Restart primitives (e.g. triangle strips) at the largest index of the index type.
+             *
+             * @note The restart index is `0xFF`, `0xFFFF` or `0xFFFFFFFF`
+             *       (`GL_PRIMITIVE_RESTART_FIXED_INDEX`), so it can't be a vertex index.
+             */
+            Builder& enablePrimitiveRestart();
+
+            /** Add a vertex array attribute, after the previous ones.
              * 
-             * @tparam T         Attribute component type.
+             * @tparam T         Attribute component type, e.g. `float`, `vertex::Half`,
+             *                   `vertex::Normalized<int8_t>` or `vertex::Snorm2101010`.
              * @param index      Attribute location index.
              * @param count      Attribute component count.
              * @param normalized Whether normalize attribute components.
              */
-            template <typename T>
-                requires std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, double>
+            template <vertex::Component T>
             Builder& addAttribute(GLuint index, GLuint count, bool normalized = false) {
-                AttributeInfo attrInfo {};
-                attrInfo.index = index;
-                attrInfo.count = count;
-                attrInfo.normalized = normalized;
-                attrInfo.storageSize = sizeof(T) * count;
-                
-                if constexpr (std::is_same_v<T, int>)
-                    attrInfo.storageType = GL_INT;
-                else if constexpr (std::is_same_v<T, float>)
-                    attrInfo.storageType = GL_FLOAT;
-                else if constexpr (std::is_same_v<T, double>)
-                    attrInfo.storageType = GL_DOUBLE;
-
-                attributes.push_back(attrInfo);
-                
+                format.add<T>(index, count, normalized);
                 return *this;
             }
 
+            /** Set all attributes from the layout of a vertex struct, replacing added ones.
+             *
+             * @note e.g. `setLayout(vertex::Layout<&Vertex::position, &Vertex::texCoord> {})`.
+             */
+            template <auto... Members>
+            Builder& setLayout(vertex::Layout<Members...> layout) {
+                format = vertex::Format::from(layout);
+                return *this;
+            }
+
+            /** Build the vertex buffer, with the vertex array shared by its attribute layout.
+             *
+             * @note Buffers with the same attributes (in the same order) use one vertex array,
+             *       whose formats are set once with `glVertexArrayAttribFormat`, so switching
+             *       between them only attaches another vertex and element buffer.
+             */
             VertexBuffer build();
 
         private:
-            GLuint vertexBufferID, vertexArrayID;
-            std::vector<AttributeInfo> attributes {};
+            Builder& setIndexBuffer(const void* data, size_t count, GLenum type, GLenum usage);
+
+        private:
+            GLuint vertexBufferID;
+            GLuint elementBufferID { 0 };
+            GLsizeiptr bufferSize { 0 };
+            GLenum indexType { 0 };
+            GLsizei indexCount { 0 };
+            bool hasPrimitiveRestart { false };
+            vertex::Format format {};
         };
 
     public:
@@ -85,10 +120,43 @@ namespace cabin::core {
 
         ~VertexBuffer();
 
-        //! Bind to this vertex buffer. (wrapper of `glBindVertexArray`)
+        /** Bind the vertex array, and attach this vertex buffer and element buffer to it.
+         *
+         * @note The attachments of a shared vertex array are cached, so binding the same
+         *       buffers again only costs a `glBindVertexArray`.
+         */
         void bind() const;
 
+        /** Bind and draw all vertices, through the element buffer if there is one.
+         *
+         * @param mode Primitive type, e.g. `GL_TRIANGLES`.
+         */
+        void draw(GLenum mode = GL_TRIANGLES) const;
+
     public:
         std::optional<GLuint> VBO, VAO;
+        std::optional<GLuint> EBO;          //!< Element buffer, if indices are set.
+        GLsizei vertexCount { 0 };
+        GLsizei indexCount { 0 };
+        GLenum indexType { 0 };             //!< `GL_UNSIGNED_BYTE`, `GL_UNSIGNED_SHORT` or `GL_UNSIGNED_INT`.
+        bool hasPrimitiveRestart { false };
+        GLsizei stride { 0 };               //!< Size of a vertex (in byte).
+
+    private:
+        //! Vertex array shared by the vertex buffers of the same layout.
+        struct SharedArray {
+            GLuint id { 0 };
+            size_t refCount { 0 };
+            GLuint vertexBuffer { 0 };      //!< Vertex buffer attached to the binding point `0`.
+            GLuint elementBuffer { 0 };
+        };
+
+        static std::map<vertex::Format, SharedArray>& getSharedArrays();
+
+        //! Delete the buffers, and the vertex array once no other buffer shares it.
+        void release();
+
+    private:
+        SharedArray* m_sharedArray { nullptr };
     };
 }
\ No newline at end of file
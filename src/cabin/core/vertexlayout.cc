@@ -0,0 +1,11 @@
+#include "vertexlayout.h"
+
+namespace cabin::core::vertex {
+    void Format::apply(GLuint vertexArray) const {
+        for (auto& attr : attributes) {
+            glVertexArrayAttribFormat(vertexArray, attr.index, attr.count, attr.type, attr.normalized, attr.offset);
+            glVertexArrayAttribBinding(vertexArray, attr.index, 0);
+            glEnableVertexArrayAttrib(vertexArray, attr.index);
+        }
+    }
+}
@@ -0,0 +1,285 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace cabin::core::vertex {
+
+    //! Half float component (`GL_HALF_FLOAT`), stored as its bits.
+    struct Half {
+        Half() = default;
+        Half(float value)
+        : bits(glm::packHalf1x16(value)) {}
+
+        uint16_t bits { 0 };
+    };
+
+    /** Integer component normalized by the vertex fetch.
+     *
+     * @note Unsigned components map to `[0, 1]`, signed ones to `[-1, 1]`.
+     */
+    template <typename T>
+        requires std::is_same_v<T, int8_t> || std::is_same_v<T, uint8_t> ||
+                 std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t>
+    struct Normalized {
+        using Component = T;
+
+        Normalized() = default;
+        Normalized(float value)
+        : value(static_cast<T>(std::round(std::clamp(value, std::is_signed_v<T> ? -1.0f : 0.0f, 1.0f) *
+                                          std::numeric_limits<T>::max()))) {}
+
+        T value { 0 };
+    };
+
+    /** Four signed normalized components packed in 32 bits (`GL_INT_2_10_10_10_REV`).
+     *
+     * @note `x`, `y` and `z` keep 10 bits, `w` keeps 2 bits, e.g. normals,
+     *       or tangents with their handedness.
+     */
+    struct Snorm2101010 {
+        Snorm2101010() = default;
+        Snorm2101010(const glm::vec4& value)
+        : bits(glm::packSnorm3x10_1x2(value)) {}
+
+        uint32_t bits { 0 };
+    };
+
+    template <typename T>
+    constexpr bool isNormalized = false;
+
+    template <typename T>
+    constexpr bool isNormalized<Normalized<T>> = true;
+
+    //! GL type of a vertex component, `0` if `T` can't be one.
+    template <typename T>
+    constexpr GLenum componentType() {
+        if constexpr (isNormalized<T>)
+            return componentType<typename T::Component>();
+        else if constexpr (std::is_same_v<T, float>)
+            return GL_FLOAT;
+        else if constexpr (std::is_same_v<T, double>)
+            return GL_DOUBLE;
+        else if constexpr (std::is_same_v<T, Half>)
+            return GL_HALF_FLOAT;
+        else if constexpr (std::is_same_v<T, int32_t>)
+            return GL_INT;
+        else if constexpr (std::is_same_v<T, uint32_t>)
+            return GL_UNSIGNED_INT;
+        else if constexpr (std::is_same_v<T, int16_t>)
+            return GL_SHORT;
+        else if constexpr (std::is_same_v<T, uint16_t>)
+            return GL_UNSIGNED_SHORT;
+        else if constexpr (std::is_same_v<T, int8_t>)
+            return GL_BYTE;
+        else if constexpr (std::is_same_v<T, uint8_t>)
+            return GL_UNSIGNED_BYTE;
+        else if constexpr (std::is_same_v<T, Snorm2101010>)
+            return GL_INT_2_10_10_10_REV;
+        else
+            return 0;
+    }
+
+    //! Types accepted by `addAttribute` of vertex builders, as components of an attribute.
+    template <typename T>
+    concept Component = componentType<T>() != 0;
+
+    //! Format of a vertex attribute, sourced from an offset of the vertex.
+    struct Attribute {
+        GLuint index { 0 };
+        GLint count { 0 };
+        GLenum type { 0 };
+        bool normalized { false };
+        GLuint offset { 0 };
+
+        auto operator<=>(const Attribute&) const = default;
+    };
+
+    //! Component type and count of a vertex member, e.g. `glm::vec3` or `Half[2]`.
+    template <typename M>
+    struct MemberFormat {
+        using Component = M;
+        static constexpr GLint count = std::is_same_v<M, Snorm2101010> ? 4 : 1;
+    };
+
+    template <glm::length_t L, typename T, glm::qualifier Q>
+    struct MemberFormat<glm::vec<L, T, Q>> {
+        using Component = T;
+        static constexpr GLint count = L;
+    };
+
+    template <typename T, size_t N>
+    struct MemberFormat<T[N]> {
+        using Component = T;
+        static constexpr GLint count = N;
+    };
+
+    //! Whether a vertex member can be read as one attribute.
+    template <typename M>
+    constexpr bool isAttribute() {
+        using Format = MemberFormat<M>;
+        if constexpr (!Component<typename Format::Component>)
+            return false;
+        else if constexpr (std::is_same_v<typename Format::Component, Snorm2101010>)
+            return Format::count == 4;
+        else
+            return Format::count >= 1 && Format::count <= 4;
+    }
+
+    template <auto Member>
+    struct MemberTraits {};
+
+    template <typename V, typename M, M V::*Member>
+    struct MemberTraits<Member> {
+        using Vertex = V;
+        using Type = M;
+    };
+
+    /** Vertex Layout
+     *
+     * --------------------------
+     * Derives the attributes of a vertex struct from pointers to its
+     *  members at compile time. Attribute locations follow the order
+     *  of the members, starting from `0`, e.g.
+     *  `vertex::Layout<&Vertex::position, &Vertex::normal, &Vertex::texCoord>`.
+     *
+     *  Members are `float`, `double`, `Half`, integers, `Normalized`
+     *  integers, or `glm::vec`s and arrays (up to 4) of them, and
+     *  `Snorm2101010`.
+     *
+     * @note Offsets are computed with the alignment of the members, so
+     *       they must be listed in their declaration order, and cover
+     *       all members of the vertex. `Format::from` checks the offsets
+     *       against the struct when the layout is used.
+     */
+    template <auto First, auto... Rest>
+    struct Layout {
+        using Vertex = typename MemberTraits<First>::Vertex;
+
+        static_assert((std::is_same_v<typename MemberTraits<Rest>::Vertex, Vertex> && ...),
+                      "vertex layout members must belong to the same vertex struct");
+        static_assert(isAttribute<typename MemberTraits<First>::Type>() &&
+                      (isAttribute<typename MemberTraits<Rest>::Type>() && ...),
+                      "unsupported vertex layout member type");
+        static_assert(std::is_standard_layout_v<Vertex> && std::is_trivially_copyable_v<Vertex>,
+                      "vertex struct must be standard layout and trivially copyable");
+
+    private:
+        template <typename M>
+        static constexpr Attribute makeAttribute(GLuint index, size_t& offset) {
+            using Format = MemberFormat<M>;
+            using Component = typename Format::Component;
+
+            offset = (offset + alignof(M) - 1) / alignof(M) * alignof(M);
+
+            Attribute attribute {};
+            attribute.index = index;
+            attribute.count = Format::count;
+            attribute.type = componentType<Component>();
+            attribute.normalized = isNormalized<Component> || std::is_same_v<Component, Snorm2101010>;
+            attribute.offset = static_cast<GLuint>(offset);
+
+            offset += sizeof(M);
+            return attribute;
+        }
+
+        struct Computed {
+            std::array<Attribute, 1 + sizeof...(Rest)> attributes;
+            size_t size;
+        };
+
+        static constexpr Computed compute() {
+            size_t offset = 0;
+            GLuint index = 0;
+            Computed result {
+                { makeAttribute<typename MemberTraits<First>::Type>(index++, offset),
+                  makeAttribute<typename MemberTraits<Rest>::Type>(index++, offset)... },
+                0
+            };
+            result.size = (offset + alignof(Vertex) - 1) / alignof(Vertex) * alignof(Vertex);
+            return result;
+        }
+
+    public:
+        static constexpr auto attributes = compute().attributes;
+        static constexpr GLsizei stride = sizeof(Vertex);
+
+        static_assert(compute().size == sizeof(Vertex),
+                      "vertex layout must list all members of the vertex struct in declaration order");
+
+        //! Whether the computed offsets match the vertex struct.
+        static bool isMatching() {
+            Vertex vertex {};
+            const auto* base = reinterpret_cast<const std::byte*>(&vertex);
+            auto offsetOf = [&](const auto& member) {
+                return static_cast<GLuint>(reinterpret_cast<const std::byte*>(&member) - base);
+            };
+
+            size_t index = 0;
+            return offsetOf(vertex.*First) == attributes[index++].offset &&
+                   ((offsetOf(vertex.*Rest) == attributes[index++].offset) && ...);
+        }
+    };
+
+    //! Attributes of interleaved vertices, read from binding point `0` of a vertex array.
+    struct Format {
+        std::vector<Attribute> attributes {};
+        GLsizei stride { 0 };
+
+        auto operator<=>(const Format&) const = default;
+
+        /** Append an attribute after the previous ones.
+         *
+         * @note `Snorm2101010` attributes have 4 components in one element.
+         */
+        template <Component T>
+        void add(GLuint index, GLuint count, bool normalized) {
+            if (std::is_same_v<T, Snorm2101010> && count != 4)
+                throw std::runtime_error("GL_INT_2_10_10_10_REV vertex attribute requires 4 components!");
+
+            Attribute attribute {};
+            attribute.index = index;
+            attribute.count = static_cast<GLint>(count);
+            attribute.type = componentType<T>();
+            attribute.normalized = normalized || isNormalized<T> || std::is_same_v<T, Snorm2101010>;
+            attribute.offset = static_cast<GLuint>(stride);
+            attributes.push_back(attribute);
+
+            stride += static_cast<GLsizei>(std::is_same_v<T, Snorm2101010> ? sizeof(T) : sizeof(T) * count);
+        }
+
+        //! Get the format of a layout, throws if the layout doesn't match its vertex struct.
+        template <auto... Members>
+        static Format from(Layout<Members...>) {
+            using L = Layout<Members...>;
+            if (!L::isMatching())
+                throw std::runtime_error("vertex layout members aren't listed in their declaration order!");
+
+            Format format {};
+            format.attributes.assign(L::attributes.begin(), L::attributes.end());
+            format.stride = L::stride;
+            return format;
+        }
+
+        //! Set the attribute formats on a vertex array. (wrapper of `glVertexArrayAttribFormat`)
+        void apply(GLuint vertexArray) const;
+    };
+}
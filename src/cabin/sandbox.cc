@@ -4,6 +4,7 @@
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
+#include "core/memorybudget.h"
 
 namespace cabin {
 
@@ -62,6 +63,8 @@ namespace cabin {
 
             glfwSwapBuffers(window);
             glfwPollEvents();
+
+            core::MemoryBudget::getShared().endFrame();
         }
     }
 
@@ -0,0 +1,104 @@
+#include "memorypanel.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+#include <imgui.h>
+
+namespace {
+    constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+    const char* getCategoryName(cabin::core::MemoryBudget::Category category) {
+        switch (category) {
+            case cabin::core::MemoryBudget::Category::Texture:      return "Texture";
+            case cabin::core::MemoryBudget::Category::VertexBuffer: return "Vertex Buffer";
+            case cabin::core::MemoryBudget::Category::RenderBuffer: return "Render Buffer";
+        }
+        return "Unknown";
+    }
+}
+
+namespace cabin::utils {
+    MemoryPanel::MemoryPanel(core::MemoryBudget& budget)
+    : m_budget(budget), m_budgetMiB(static_cast<int>(budget.getBudget() / (1024 * 1024))) {}
+
+    void MemoryPanel::draw(bool* isOpen) {
+        using Category = core::MemoryBudget::Category;
+
+        ImGui::SetNextWindowSize(ImVec2(460, 420), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("GPU Memory", isOpen)) {
+            ImGui::End();
+            return;
+        }
+
+        ImGui::SeparatorText("Budget");
+        if (ImGui::InputInt("Budget (MiB)", &m_budgetMiB, 64)) {
+            m_budgetMiB = std::max(m_budgetMiB, 0);
+            m_budget.setBudget(static_cast<size_t>(m_budgetMiB) * 1024 * 1024);
+        }
+
+        double residentMiB = m_budget.getResidentSize() / MEBIBYTE;
+        if (m_budget.getBudget() != 0) {
+            double budgetMiB = m_budget.getBudget() / MEBIBYTE;
+            char overlay[64];
+            std::snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB", residentMiB, budgetMiB);
+            ImGui::ProgressBar(static_cast<float>(std::min(residentMiB / budgetMiB, 1.0)), ImVec2(-1.0f, 0.0f), overlay);
+        } else {
+            ImGui::Text("Resident: %.1f MiB (unlimited)", residentMiB);
+        }
+
+        for (Category category : { Category::Texture, Category::VertexBuffer, Category::RenderBuffer })
+            ImGui::BulletText("%s: %.1f MiB", getCategoryName(category), m_budget.getResidentSize(category) / MEBIBYTE);
+        ImGui::BulletText("Evicted: %.1f MiB (%zu evictions, %zu reloads)", m_budget.getEvictedSize() / MEBIBYTE,
+                          m_budget.getEvictionCount(), m_budget.getReloadCount());
+
+        ImGui::SeparatorText("Objects");
+        std::vector<core::MemoryBudget::Allocation> allocations = m_budget.getAllocations();
+        std::sort(allocations.begin(), allocations.end(), [](const auto& a, const auto& b) {
+            return a.size > b.size;
+        });
+
+        if (ImGui::BeginTable("allocations", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                                ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY)) {
+            ImGui::TableSetupColumn("Type");
+            ImGui::TableSetupColumn("Id");
+            ImGui::TableSetupColumn("Format");
+            ImGui::TableSetupColumn("Extent");
+            ImGui::TableSetupColumn("MiB");
+            ImGui::TableSetupColumn("State");
+            ImGui::TableHeadersRow();
+
+            uint64_t frame = m_budget.getFrame();
+            for (const auto& allocation : allocations) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", getCategoryName(allocation.category));
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", allocation.id);
+                ImGui::TableNextColumn();
+                if (allocation.format != 0)
+                    ImGui::Text("0x%04X", allocation.format);
+                ImGui::TableNextColumn();
+                if (allocation.category == Category::VertexBuffer)
+                    ImGui::Text("-");
+                else if (allocation.depth > 1)
+                    ImGui::Text("%dx%dx%d, %d levels", allocation.width, allocation.height, allocation.depth, allocation.levels);
+                else
+                    ImGui::Text("%dx%d, %d levels", allocation.width, allocation.height, allocation.levels);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", allocation.size / MEBIBYTE);
+                ImGui::TableNextColumn();
+                if (!allocation.isResident)
+                    ImGui::Text("evicted");
+                else if (allocation.category != Category::Texture)
+                    ImGui::Text("resident");
+                else
+                    ImGui::Text("%s, %llu frames ago", allocation.isEvictable ? "evictable" : "pinned",
+                                static_cast<unsigned long long>(frame - allocation.lastUsedFrame));
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include "cabin/core/memorybudget.h"
+
+namespace cabin::utils {
+
+    /** GPU Memory Panel
+     *
+     * --------------------------
+     * `MemoryPanel` shows the resident size of each category of a
+     *  `core::MemoryBudget` against its budget, and lists the tracked
+     *  objects by size, with their formats and residency. The budget
+     *  can be adjusted from the panel.
+     *
+     * @note Should be drawn inside `Sandbox::interfaceFrame`.
+     *
+     * @see Usage example:
+     *       sandbox/hello_pbr/main.cc
+     */
+    class MemoryPanel {
+    public:
+        explicit MemoryPanel(core::MemoryBudget& budget = core::MemoryBudget::getShared());
+
+        /** Draw the panel as an ImGui window.
+         *
+         * @param isOpen Shows a close button when not `nullptr`.
+         */
+        void draw(bool* isOpen = nullptr);
+
+    private:
+        core::MemoryBudget& m_budget;
+        int m_budgetMiB { 0 };
+    };
+}
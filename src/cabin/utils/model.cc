@@ -1,11 +1,18 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "model.h"
+#include <set>
+#include <tuple>
+#include <algorithm>
+#include <future>
+#include <cstdint>
 #include <stdexcept>
+#include <filesystem>
 
 #include <glm/gtc/quaternion.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
 #include "cabin/utils/console.h"
+#include "cabin/utils/threadpool.h"
 
 namespace {
     template <typename T>
@@ -14,13 +21,156 @@ namespace {
         assert(container.size() > index && index >= 0);
     #endif
     }
+
+    //! Image loader of tinygltf, only keeping the encoded bytes for decoding later.
+    bool deferImageData(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+                        int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* userData) {
+        auto encodedImages = static_cast<std::vector<std::vector<unsigned char>>*>(userData);
+        if (encodedImages->size() <= static_cast<size_t>(imageIndex))
+            encodedImages->resize(imageIndex + 1);
+
+        (*encodedImages)[imageIndex].assign(bytes, bytes + size);
+        return true;
+    }
+
+    //! Decode the same way as the default image loader of tinygltf, which expands images to RGBA.
+    void decodeImageData(tinygltf::Image& image, const std::vector<unsigned char>& bytes) {
+        stbi_set_flip_vertically_on_load_thread(false);
+
+        const int component = 4;
+        int width, height, fileComponent;
+        int size = static_cast<int>(bytes.size());
+
+        void* data;
+        int bits;
+        if (stbi_is_16_bit_from_memory(bytes.data(), size)) {
+            data = stbi_load_16_from_memory(bytes.data(), size, &width, &height, &fileComponent, component);
+            bits = 16;
+        } else {
+            data = stbi_load_from_memory(bytes.data(), size, &width, &height, &fileComponent, component);
+            bits = 8;
+        }
+
+        if (!data)
+            throw std::runtime_error(std::format("failed to decode image \"{}\": {}", image.name, stbi_failure_reason()));
+
+        image.width = width;
+        image.height = height;
+        image.component = component;
+        image.bits = bits;
+        image.pixel_type = bits == 16 ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+
+        auto pixels = static_cast<const unsigned char*>(data);
+        image.image.assign(pixels, pixels + static_cast<size_t>(width) * height * component * (bits / 8));
+        stbi_image_free(data);
+    }
+}
+
+namespace {
+    //! Bump when the encoded output changes, so that stale cached textures are ignored.
+    constexpr uint64_t TEXTURE_CACHE_VERSION = 2;
+
+    uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    //! View the pixels of a decoded image, without copying them.
+    cabin::core::Texture::Image viewImage(const tinygltf::Image& image) {
+        cabin::core::Texture::Image view {};
+        view.pixels = std::shared_ptr<void>(const_cast<unsigned char*>(image.image.data()), [](void*) {});
+        view.width = image.width;
+        view.height = image.height;
+
+        if (image.component == 1)
+            view.srcFormat = GL_RED;
+        else if (image.component == 2)
+            view.srcFormat = GL_RG;
+        else if (image.component == 3)
+            view.srcFormat = GL_RGB;
+        else if (image.component == 4)
+            view.srcFormat = GL_RGBA;
+        else
+            throw std::runtime_error(
+                    std::format("unsupported image format, with comp({})", image.component)
+                );
+
+        if (image.bits == 8)
+            view.compType = GL_UNSIGNED_BYTE;
+        else if (image.bits == 16)
+            view.compType = GL_UNSIGNED_SHORT;
+        else
+            throw std::runtime_error(
+                    std::format("unsupported image storage type, with bits({})", image.bits)
+                );
+
+        return view;
+    }
+
+    //! Compress the mipmap chain of a decoded 8-bit RGBA image.
+    cabin::core::CompressedImage compressImage(const tinygltf::Image& image, const cabin::core::MipmapChain& chain,
+                                               bool isNormalMap) {
+        GLenum format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        if (isNormalMap) {
+            format = GL_COMPRESSED_RG_RGTC2;
+        } else {
+            for (size_t i = 3; i < image.image.size(); i += 4) {
+                if (image.image[i] != 255) {
+                    format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                    break;
+                }
+            }
+        }
+
+        return cabin::core::CompressedImage::encode(chain, format);
+    }
+
+    void uploadLayer(GLuint arrayId, GLint layer, const cabin::core::CompressedImage& image) {
+        for (GLint level = 0; level < static_cast<GLint>(image.levels.size()); level++) {
+            const auto& data = image.levels[level];
+            glCompressedTextureSubImage3D(arrayId, level, 0, 0, layer,
+                                          std::max(image.width >> level, 1), std::max(image.height >> level, 1), 1,
+                                          image.format, static_cast<GLsizei>(data.size()), data.data());
+        }
+    }
+
+    //! Upload a mipmap chain into a layer, with `GL_UNPACK_ALIGNMENT` of 1 unless streamed by the uploader.
+    void uploadLayer(GLuint arrayId, GLint layer, const cabin::core::MipmapChain& chain,
+                     cabin::core::TextureUploader* uploader = nullptr) {
+        for (GLint level = 0; level < static_cast<GLint>(chain.levels.size()); level++) {
+            const cabin::core::Texture::Image& image = chain.levels[level];
+            if (uploader) {
+                uploader->upload(arrayId, level, 0, 0, layer, image.width, image.height,
+                                 image.srcFormat, image.compType, image.pixels.get());
+            } else {
+                glTextureSubImage3D(arrayId, level, 0, 0, layer, image.width, image.height, 1,
+                                    image.srcFormat, image.compType, image.pixels.get());
+            }
+        }
+    }
 }
 
 namespace cabin::utils {
+    Model::Builder& Model::Builder::setTextureUploader(core::TextureUploader& uploader) {
+        m_textureUploader = &uploader;
+        return *this;
+    }
+
+    Model::Builder& Model::Builder::setTextureCache(const std::string& directory) {
+        m_textureCacheDirectory = directory;
+        return *this;
+    }
+
     Model::Builder& Model::Builder::fromGLB(const std::string& path) {
         Console::info(std::format("loading glb model: \"{}\"", path));
 
         tinygltf::TinyGLTF loader {};
+        loader.SetImageLoader(deferImageData, &m_encodedImages);
+
         std::string loadError {}, loadWarn {};
         bool res = loader.LoadBinaryFromFile(&m_model, &loadError, &loadWarn, path);
 
@@ -29,6 +179,7 @@ namespace cabin::utils {
         if (!res)
             throw std::runtime_error(std::format("failed to load glb model: {}", loadError));
 
+        decodeImages();
         loadModel();
         return *this;
     }
@@ -37,6 +188,8 @@ namespace cabin::utils {
         Console::info(std::format("loading glTF model: \"{}\"", path));
 
         tinygltf::TinyGLTF loader {};
+        loader.SetImageLoader(deferImageData, &m_encodedImages);
+
         std::string loadError {}, loadWarn {};
         bool res = loader.LoadASCIIFromFile(&m_model, &loadError, &loadWarn, path);
 
@@ -45,6 +198,7 @@ namespace cabin::utils {
         if (!res)
             throw std::runtime_error(std::format("failed to load glTF model: {}", loadError));
 
+        decodeImages();
         loadModel();
         return *this;
     }
@@ -53,15 +207,133 @@ namespace cabin::utils {
         Model result {};
         result.meshes.swap(m_meshes);
         result.textures.swap(m_textures);
+        result.geometry = std::move(m_geometry);
         return result;
     }
 
+    void Model::Builder::decodeImages() {
+        m_compressedImages.assign(m_model.images.size(), std::nullopt);
+        m_mipmapChains.assign(m_model.images.size(), std::nullopt);
+        m_imageSources.assign(m_model.images.size(), ImageSource {});
+
+        // Color textures are sRGB encoded by glTF, others hold linear data.
+        std::vector<bool> isNormalMap(m_model.images.size(), false);
+        std::vector<bool> isSrgb(m_model.images.size(), false);
+        auto markImage = [this](int textureIndex, std::vector<bool>& roles) {
+            if (textureIndex < 0 || static_cast<size_t>(textureIndex) >= m_model.textures.size())
+                return;
+
+            int imageIndex = m_model.textures[textureIndex].source;
+            if (imageIndex >= 0 && static_cast<size_t>(imageIndex) < roles.size())
+                roles[imageIndex] = true;
+        };
+        for (const auto& material : m_model.materials) {
+            markImage(material.normalTexture.index, isNormalMap);
+            markImage(material.pbrMetallicRoughness.baseColorTexture.index, isSrgb);
+            markImage(material.emissiveTexture.index, isSrgb);
+        }
+
+        std::vector<std::future<void>> decodings {};
+        for (size_t i = 0; i < m_encodedImages.size() && i < m_model.images.size(); i++) {
+            if (m_encodedImages[i].empty())
+                continue;
+
+            decodings.push_back(ThreadPool::getShared().submit([this, i, isNormal = isNormalMap[i], isColor = isSrgb[i]] {
+                loadImage(i, isNormal, isColor && !isNormal);
+            }));
+        }
+
+        // Wait for all decodings before reporting any error, since they write into the model.
+        for (auto& decoding : decodings)
+            decoding.wait();
+        for (auto& decoding : decodings)
+            decoding.get();
+
+        m_encodedImages.clear();
+    }
+
+    void Model::Builder::loadImage(size_t imageIndex, bool isNormalMap, bool isSrgb) {
+        const std::vector<unsigned char>& bytes = m_encodedImages[imageIndex];
+        ImageSource& source = m_imageSources[imageIndex];
+        source.isSrgb = isSrgb;
+
+        std::string cachePath {};
+        if (!m_textureCacheDirectory.empty()) {
+            uint64_t hash = hashBytes(&TEXTURE_CACHE_VERSION, sizeof(TEXTURE_CACHE_VERSION));
+            hash = hashBytes(&isNormalMap, sizeof(isNormalMap), hash);
+            hash = hashBytes(&isSrgb, sizeof(isSrgb), hash);
+            hash = hashBytes(bytes.data(), bytes.size(), hash);
+            cachePath = std::format("{}/{:016x}.ktx2", m_textureCacheDirectory, hash);
+
+            if (std::filesystem::exists(cachePath)) {
+                try {
+                    m_compressedImages[imageIndex] = core::CompressedImage::loadKTX2(cachePath);
+                    source.cachePath = cachePath;
+                    return;
+                } catch (const std::exception& e) {
+                    Console::info(std::format("ignored cached texture, {}", e.what()));
+                }
+            }
+        }
+
+        tinygltf::Image& image = m_model.images[imageIndex];
+        decodeImageData(image, bytes);
+
+        // Cooked images are filtered once, so they can afford the sharper filter.
+        if (!cachePath.empty() && image.bits == 8) {
+            core::MipmapChain chain = core::MipmapChain::generate(viewImage(image), core::Texture::ALL_MIPMAP_LEVELS,
+                                                                  isSrgb, core::MipmapChain::Filter::Kaiser);
+            m_compressedImages[imageIndex] = compressImage(image, chain, isNormalMap);
+            try {
+                m_compressedImages[imageIndex]->saveKTX2(cachePath);
+                source.cachePath = cachePath;
+            } catch (const std::exception& e) {
+                Console::info(e.what());
+                source.bytes = std::make_shared<const std::vector<unsigned char>>(bytes);
+            }
+            return;
+        }
+
+        // Encoded images are far smaller than their levels on the GPU, so they're kept for reloading.
+        m_mipmapChains[imageIndex] = core::MipmapChain::generate(viewImage(image), core::Texture::ALL_MIPMAP_LEVELS, isSrgb);
+        source.bytes = std::make_shared<const std::vector<unsigned char>>(bytes);
+    }
+
     void Model::Builder::loadModel() {
+        loadTextures();
+
+        // Pages are sized to hold every mesh once, nodes instancing meshes again may open more pages.
+        GLsizeiptr vertexSize = 0, indexSize = 0;
+        for (const tinygltf::Mesh& mesh : m_model.meshes) {
+            for (const tinygltf::Primitive& primitive : mesh.primitives) {
+                auto position = primitive.attributes.find("POSITION");
+                if (position != primitive.attributes.end() && position->second >= 0 &&
+                    position->second < static_cast<int>(m_model.accessors.size()))
+                    vertexSize += m_model.accessors[position->second].count * sizeof(Vertex);
+                if (primitive.indices >= 0 && primitive.indices < static_cast<int>(m_model.accessors.size())) {
+                    const tinygltf::Accessor& accessor = m_model.accessors[primitive.indices];
+                    int componentSize = std::max(tinygltf::GetComponentSizeInBytes(accessor.componentType), 1);
+                    indexSize += (accessor.count * componentSize + 3) / 4 * 4;
+                }
+            }
+        }
+
+        m_geometry = core::GeometryPool::Builder()
+                         .setPageSize(std::max<GLsizeiptr>(vertexSize, sizeof(Vertex)), std::max<GLsizeiptr>(indexSize, 4))
+                         .setLayout(core::vertex::Layout<&Vertex::position, &Vertex::normal, &Vertex::texCoord> {})
+                         .build();
+
         tinygltf::Scene& scene = m_model.scenes[m_model.defaultScene];
         for (auto& node : scene.nodes) {
             indexChecker(m_model.nodes, node);
             loadNode(m_model.nodes[node]);
         }
+
+        if (m_textureUploader)
+            m_textureUploader->flush();
+        m_compressedImages.clear();
+        m_mipmapChains.clear();
+        m_imageSources.clear();
     }
 
     void Model::Builder::loadNode(const tinygltf::Node& node) {
@@ -174,46 +446,42 @@ namespace cabin::utils {
                 vertices[j].normal = normalBufferPtr[j];
                 vertices[j].texCoord = texCoordBufferPtr[j];
             }
-            result[i].vertices = core::VertexBuffer::Builder()
-                                        .setBuffer(vertices.data(), vertices.size() * sizeof(Vertex), GL_STATIC_DRAW)
-                                        .addAttribute<float>(0, 3)
-                                        .addAttribute<float>(1, 3)
-                                        .addAttribute<float>(2, 2)
-                                        .build();
 
             /* Indices */
-            size_t indexCount = m_model.accessors[primitive.indices].count;
-            std::vector<unsigned int> indices (indexCount);
-
-            static const int supportedIndexType[2] = {
-                TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
-                TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT
-            };
-
-            bool hasIndices = false;
-            for (int j = 0; j < 2; j++) {
-                bufferFetchRes = fetchBufferPointer(primitive.indices, 
-                                    TINYGLTF_TYPE_SCALAR, supportedIndexType[j], indexCount);
-                if (bufferFetchRes.has_value()) {
-                    if (supportedIndexType[j] == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
-                        auto bufferPtr = reinterpret_cast<unsigned int*>(bufferFetchRes.value());
-                        for (size_t k = 0; k < indexCount; k++)
-                            indices[k] = bufferPtr[k];
+            // Indices keep their width in the geometry pool, primitives without indices draw arrays.
+            if (primitive.indices >= 0) {
+                size_t indexCount = m_model.accessors[primitive.indices].count;
+
+                static const int supportedIndexType[3] = {
+                    TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+                    TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT,
+                    TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE
+                };
+
+                bool hasIndices = false;
+                for (int j = 0; j < 3; j++) {
+                    bufferFetchRes = fetchBufferPointer(primitive.indices, 
+                                        TINYGLTF_TYPE_SCALAR, supportedIndexType[j], indexCount);
+                    if (bufferFetchRes.has_value()) {
+                        if (supportedIndexType[j] == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+                            result[i].mesh = m_geometry.allocate(vertices.data(), vertexCount,
+                                                 static_cast<const unsigned int*>(bufferFetchRes.value()), indexCount);
+                        else if (supportedIndexType[j] == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+                            result[i].mesh = m_geometry.allocate(vertices.data(), vertexCount,
+                                                 static_cast<const unsigned short*>(bufferFetchRes.value()), indexCount);
+                        else
+                            result[i].mesh = m_geometry.allocate(vertices.data(), vertexCount,
+                                                 static_cast<const unsigned char*>(bufferFetchRes.value()), indexCount);
+                        hasIndices = true;
+                        break;
                     }
-                    else {
-                        auto bufferPtr = reinterpret_cast<unsigned short*>(bufferFetchRes.value());
-                        for (size_t k = 0; k < indexCount; k++)
-                            indices[k] = bufferPtr[k];
-                    }
-                    hasIndices = true;
-                    break;
                 }
-            }
-
-            if (!hasIndices)
-                throw std::runtime_error("invalid \"primitive's indices\". Require( SCALAR, UINT | USHORT )");
 
-            result[i].indices.swap(indices);
+                if (!hasIndices)
+                    throw std::runtime_error("invalid \"primitive's indices\". Require( SCALAR, UINT | USHORT | UBYTE )");
+            } else {
+                result[i].mesh = m_geometry.allocate(vertices.data(), vertexCount);
+            }
 
             /* Material */
             tinygltf::Material& material = m_model.materials[primitive.material];
@@ -222,19 +490,19 @@ namespace cabin::utils {
 
             textureIndex = material.pbrMetallicRoughness.baseColorTexture.index;
             if (textureIndex >= 0)
-                result[i].material.baseColorTexture = loadTexture(textureIndex);
+                result[i].material.baseColorTexture = m_textureLayers.at(textureIndex);
             textureIndex = material.pbrMetallicRoughness.metallicRoughnessTexture.index;
             if (textureIndex >= 0)
-                result[i].material.metallicRoughnessTexture = loadTexture(textureIndex);
+                result[i].material.metallicRoughnessTexture = m_textureLayers.at(textureIndex);
             textureIndex = material.normalTexture.index;
             if (textureIndex >= 0)
-                result[i].material.normalTexture = loadTexture(textureIndex);
+                result[i].material.normalTexture = m_textureLayers.at(textureIndex);
             textureIndex = material.emissiveTexture.index;
             if (textureIndex >= 0)
-                result[i].material.emissiveTexture = loadTexture(textureIndex);
+                result[i].material.emissiveTexture = m_textureLayers.at(textureIndex);
             textureIndex = material.occlusionTexture.index;
             if (textureIndex >= 0)
-                result[i].material.occlusionTexture = loadTexture(textureIndex);
+                result[i].material.occlusionTexture = m_textureLayers.at(textureIndex);
 
             std::vector<double>& factorHD = material.pbrMetallicRoughness.baseColorFactor;
             if (factorHD.size() == 4)
@@ -264,142 +532,239 @@ namespace cabin::utils {
         (m_meshes.end() - 1)->swap(result);
     }
 
-    size_t Model::Builder::loadTexture(int textureIndex) {
-        indexChecker(m_model.textures, textureIndex);
+    void Model::Builder::loadTextures() {
+        struct SamplerInfo {
+            GLenum minFilter, magFilter, wrapS, wrapT;
+        };
+
+        // Images sharing an array must match in size, format and levels, and the sampler is per array.
+        // Textures of the same image and sampler state share one layer of the array.
+        using ArrayKey = std::tuple<GLsizei, GLsizei, GLenum, GLsizei, GLenum, GLenum, GLenum, GLenum>;
+        std::map<ArrayKey, std::map<int, std::vector<int>>> arrays {};
+
+        std::set<int> textureIndices {};
+        for (const auto& material : m_model.materials) {
+            for (int textureIndex : { material.pbrMetallicRoughness.baseColorTexture.index,
+                                      material.pbrMetallicRoughness.metallicRoughnessTexture.index,
+                                      material.normalTexture.index, material.emissiveTexture.index,
+                                      material.occlusionTexture.index }) {
+                if (textureIndex >= 0)
+                    textureIndices.insert(textureIndex);
+            }
+        }
 
-        if (m_loadedTextures.find(textureIndex) == m_loadedTextures.end()) {
-            indexChecker(m_model.images, m_model.textures[textureIndex].source);
+        // S3TC formats are an extension, drivers without it get the decoded levels.
+        for (size_t i = 0; i < m_compressedImages.size(); i++) {
+            if (m_compressedImages[i] && !core::CompressedImage::isSupported(m_compressedImages[i]->format)) {
+                m_mipmapChains[i] = m_compressedImages[i]->decode();
+                m_compressedImages[i].reset();
+            }
+        }
 
+        for (int textureIndex : textureIndices) {
+            indexChecker(m_model.textures, textureIndex);
             tinygltf::Texture& texture = m_model.textures[textureIndex];
-            tinygltf::Image& image = m_model.images[texture.source];
+            indexChecker(m_model.images, texture.source);
 
-            GLenum format;
-            if (image.component == 1)
-                format = GL_RED;
-            else if (image.component == 2)
-                format = GL_RG;
-            else if (image.component == 3)
-                format = GL_RGB;
-            else if (image.component == 4)
-                format = GL_RGBA;
-            else
-                throw std::runtime_error(
-                        std::format("unsupported image format, with comp({})", image.component)
-                    );
-
-            GLenum compType;
-            if (image.bits == 8)
-                compType = GL_UNSIGNED_BYTE;
-            else if (image.bits == 16)
-                compType = GL_UNSIGNED_SHORT;
-            else
-                throw std::runtime_error(
-                        std::format("unsupported image storage type, with bits({})", image.bits)
-                    );
-
-            GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
-            GLenum magFilter = GL_LINEAR;
-            GLenum wrapS = GL_CLAMP_TO_EDGE;
-            GLenum wrapT = GL_CLAMP_TO_EDGE;
+            SamplerInfo info { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
             if (texture.sampler >= 0) {
                 indexChecker(m_model.samplers, texture.sampler);
                 tinygltf::Sampler& sampler = m_model.samplers[texture.sampler];
                 if (sampler.minFilter != -1)
-                    minFilter = sampler.minFilter;
+                    info.minFilter = sampler.minFilter;
                 if (sampler.magFilter != -1)
-                    magFilter = sampler.magFilter;
+                    info.magFilter = sampler.magFilter;
 
-                wrapS = sampler.wrapS;
-                wrapT = sampler.wrapT;
+                info.wrapS = sampler.wrapS;
+                info.wrapT = sampler.wrapT;
             }
 
-            GLuint texID;
-            glGenTextures(1, &texID);
-            glBindTexture(GL_TEXTURE_2D, texID);
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, 
-                                           format, compType, image.image.data());
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            m_textures.emplace_back(texID, GL_TEXTURE_2D, format, image.width, image.height, 0);
-            m_loadedTextures[textureIndex] = m_textures.size() - 1;
+            // Compressed images carry their mipmap levels, others have theirs generated.
+            GLsizei width, height, levels;
+            GLenum format;
+            if (const auto& compressed = m_compressedImages[texture.source]) {
+                width = compressed->width;
+                height = compressed->height;
+                levels = static_cast<GLsizei>(compressed->levels.size());
+                format = compressed->format;
+            } else {
+                // Images without encoded bytes weren't decoded in background.
+                std::optional<core::MipmapChain>& chain = m_mipmapChains[texture.source];
+                if (!chain)
+                    chain = core::MipmapChain::generate(viewImage(m_model.images[texture.source]));
+
+                const core::Texture::Image& base = chain->levels.front();
+                width = base.width;
+                height = base.height;
+                levels = static_cast<GLsizei>(chain->levels.size());
+                format = core::Texture::getSizedFormat(base.srcFormat, base.compType);
+            }
+
+            ArrayKey key { width, height, format, levels, info.minFilter, info.magFilter, info.wrapS, info.wrapT };
+            arrays[key][texture.source].push_back(textureIndex);
+        }
+
+        GLint maxLayers;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+        size_t layerTotal = 0;
+        for (const auto& [key, imageLayers] : arrays) {
+            auto [width, height, format, levels, minFilter, magFilter, wrapS, wrapT] = key;
+            std::vector<std::pair<int, std::vector<int>>> layers(imageLayers.begin(), imageLayers.end());
+            layerTotal += layers.size();
+
+            for (size_t first = 0; first < layers.size(); first += maxLayers) {
+                auto layerCount = static_cast<GLsizei>(std::min<size_t>(layers.size() - first, maxLayers));
+
+                std::vector<ImageSource> sources {};
+                for (GLint layer = 0; layer < layerCount; layer++) {
+                    int imageIndex = layers[first + layer].first;
+                    if (static_cast<size_t>(imageIndex) < m_imageSources.size())
+                        sources.push_back(m_imageSources[imageIndex]);
+                }
+                bool isReloadable = sources.size() == static_cast<size_t>(layerCount) &&
+                                    std::all_of(sources.begin(), sources.end(), [](const ImageSource& source) {
+                                        return !source.cachePath.empty() || source.bytes;
+                                    });
+
+                core::Texture::Builder builder {};
+                builder.asEmpty2DArray(width, height, layerCount, format, levels)
+                       .setFilter(minFilter, magFilter)
+                       .setWrap(wrapS, wrapT);
+                if (isReloadable) {
+                    builder.setReloader([sources, levels](GLuint arrayId) {
+                        reloadLayers(arrayId, sources, levels);
+                    });
+                }
+                core::Texture array = builder.build();
+                GLuint arrayId = array.id.value();
+
+                if (!m_textureUploader)
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+                for (GLint layer = 0; layer < layerCount; layer++) {
+                    const auto& [imageIndex, textureIndices] = layers[first + layer];
+
+                    if (const auto& compressed = m_compressedImages[imageIndex])
+                        uploadLayer(arrayId, layer, compressed.value());
+                    else
+                        uploadLayer(arrayId, layer, m_mipmapChains[imageIndex].value(), m_textureUploader);
+
+                    for (int textureIndex : textureIndices)
+                        m_textureLayers[textureIndex] = TextureLayer { m_textures.size(), layer };
+                }
+
+                m_textures.push_back(std::move(array));
+            }
         }
 
-        return m_loadedTextures[textureIndex];
+        Console::info(std::format("loaded {} textures as {} layers of {} texture arrays",
+                                  textureIndices.size(), layerTotal, m_textures.size()));
+    }
+
+    void Model::Builder::reloadLayers(GLuint arrayId, const std::vector<ImageSource>& sources, GLsizei levels) {
+        std::vector<std::optional<core::CompressedImage>> compressedImages(sources.size());
+        std::vector<std::optional<core::MipmapChain>> mipmapChains(sources.size());
+        std::vector<tinygltf::Image> images(sources.size());
+
+        // Layers are decoded in parallel, the same way as they were loaded.
+        ThreadPool::getShared().parallelFor(sources.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                const ImageSource& source = sources[i];
+                if (!source.cachePath.empty()) {
+                    compressedImages[i] = core::CompressedImage::loadKTX2(source.cachePath);
+                } else {
+                    // The first level of the chain shares the decoded pixels.
+                    decodeImageData(images[i], *source.bytes);
+                    mipmapChains[i] = core::MipmapChain::generate(viewImage(images[i]), levels, source.isSrgb);
+                }
+            }
+        });
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (GLint layer = 0; layer < static_cast<GLint>(sources.size()); layer++) {
+            if (compressedImages[layer] && !core::CompressedImage::isSupported(compressedImages[layer]->format))
+                uploadLayer(arrayId, layer, compressedImages[layer]->decode());
+            else if (compressedImages[layer])
+                uploadLayer(arrayId, layer, compressedImages[layer].value());
+            else
+                uploadLayer(arrayId, layer, mipmapChains[layer].value());
+        }
     }
 
     Model::Model(Model&& right) noexcept {
         meshes.swap(right.meshes);
         textures.swap(right.textures);
+        std::swap(geometry, right.geometry);
     }
 
     Model& Model::operator=(Model&& right) noexcept {
         meshes.swap(right.meshes);
         textures.swap(right.textures);
+        std::swap(geometry, right.geometry);
         return *this;
     }
 
     void Model::draw(const core::Shader& shader) const {
+        // Material textures select the shader variant, instead of branching at runtime.
+        const auto baseColorFeature         = shader.getFeature("BASE_COLOR_TEXTURE");
+        const auto metallicRoughnessFeature = shader.getFeature("METALLIC_ROUGHNESS_TEXTURE");
+        const auto normalFeature            = shader.getFeature("NORMAL_TEXTURE");
+        const auto emissiveFeature          = shader.getFeature("EMISSIVE_TEXTURE");
+        const auto occlusionFeature         = shader.getFeature("OCCLUSION_TEXTURE");
+
+        // Texture arrays stay bound across primitives, which then only switch layers.
+        std::optional<size_t> boundTextures[5] {};
+
         for (auto& mesh : meshes) {
             for (auto& primitive : mesh) {
-                shader.bind();
-
-                shader.setInt("baseColorTexMarker", 0);
-                shader.setVec4("baseColorFactor", glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-                if (primitive.material.baseColorTexture.has_value()) {
-                    textures[primitive.material.baseColorTexture.value()].active(0);
-                    shader.setInt("baseColorTexture", 0);
-                    shader.setInt("baseColorTexMarker", 1);
-                }
-                if (primitive.material.baseColorFactor.has_value()) {
-                    shader.setVec4("baseColorFactor", primitive.material.baseColorFactor.value());
-                }
+                const Material& material = primitive.material;
+
+                uint32_t featureMask = 0;
+                if (material.baseColorTexture.has_value())
+                    featureMask |= baseColorFeature.mask;
+                if (material.metallicRoughnessTexture.has_value())
+                    featureMask |= metallicRoughnessFeature.mask;
+                if (material.normalTexture.has_value())
+                    featureMask |= normalFeature.mask;
+                if (material.emissiveTexture.has_value())
+                    featureMask |= emissiveFeature.mask;
+                if (material.occlusionTexture.has_value())
+                    featureMask |= occlusionFeature.mask;
+
+                const core::Shader& variant = shader.getVariant(featureMask);
+                variant.bind();
+
+                auto bindTexture = [&](const TextureLayer& texture, GLuint unit, const char* samplerName, const char* layerName) {
+                    if (boundTextures[unit] != texture.texture) {
+                        textures[texture.texture].active(unit);
+                        boundTextures[unit] = texture.texture;
+                    }
+                    variant.setInt(samplerName, static_cast<int>(unit));
+                    variant.setInt(layerName, texture.layer);
+                };
 
-                shader.setInt("metallicRoughnessTexMarker", 0);
-                shader.setFloat("metallicFactor", 0.0f);
-                shader.setFloat("roughnessFactor", 0.0f);
-                if (primitive.material.metallicRoughnessTexture.has_value()) {
-                    textures[primitive.material.metallicRoughnessTexture.value()].active(1);
-                    shader.setInt("metallicRoughnessTexture", 1);
-                    shader.setInt("metallicRoughnessTexMarker", 1);
-                }
-                if (primitive.material.metallicFactor.has_value())
-                    shader.setFloat("metallicFactor", primitive.material.metallicFactor.value());
-                if (primitive.material.roughnessFactor.has_value())
-                    shader.setFloat("roughnessFactor", primitive.material.roughnessFactor.value());
-
-                shader.setInt("normalTexMarker", 0);
-                if (primitive.material.normalTexture.has_value()) {
-                    textures[primitive.material.normalTexture.value()].active(2);
-                    shader.setInt("normalTexture", 2);
-                    shader.setInt("normalTexMarker", 1);
-                }
+                variant.setVec4("baseColorFactor", material.baseColorFactor.value_or(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+                if (material.baseColorTexture.has_value())
+                    bindTexture(material.baseColorTexture.value(), 0, "baseColorTexture", "baseColorLayer");
 
-                shader.setInt("emissiveTexMarker", 0);
-                shader.setVec3("emissiveFactor", glm::vec3(0.0f));
-                if (primitive.material.emissiveTexture.has_value()) {
-                    textures[primitive.material.emissiveTexture.value()].active(3);
-                    shader.setInt("emissiveTexture", 3);
-                    shader.setInt("emissiveTexMarker", 1);
-                }
-                if (primitive.material.emissiveFactor.has_value())
-                    shader.setVec3("emissiveFactor", primitive.material.emissiveFactor.value());
-
-                shader.setInt("occlusionTexMarker", 0);
-                if (primitive.material.occlusionTexture.has_value()) {
-                    textures[primitive.material.occlusionTexture.value()].active(4);
-                    shader.setInt("occlusionTexture", 4);
-                    shader.setInt("occlusionTexMarker", 1);
-                }
+                variant.setFloat("metallicFactor", material.metallicFactor.value_or(0.0f));
+                variant.setFloat("roughnessFactor", material.roughnessFactor.value_or(0.0f));
+                if (material.metallicRoughnessTexture.has_value())
+                    bindTexture(material.metallicRoughnessTexture.value(), 1, "metallicRoughnessTexture", "metallicRoughnessLayer");
+
+                if (material.normalTexture.has_value())
+                    bindTexture(material.normalTexture.value(), 2, "normalTexture", "normalLayer");
 
-                primitive.vertices.bind();
-                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(primitive.indices.size()), 
-                               GL_UNSIGNED_INT, primitive.indices.data());
+                variant.setVec3("emissiveFactor", material.emissiveFactor.value_or(glm::vec3(0.0f)));
+                if (material.emissiveTexture.has_value())
+                    bindTexture(material.emissiveTexture.value(), 3, "emissiveTexture", "emissiveLayer");
+
+                if (material.occlusionTexture.has_value())
+                    bindTexture(material.occlusionTexture.value(), 4, "occlusionTexture", "occlusionLayer");
+
+                geometry.draw(primitive.mesh, GL_TRIANGLES);
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -8,7 +9,10 @@
 
 #include "cabin/core/shader.h"
 #include "cabin/core/texture.h"
-#include "cabin/core/vertexbuffer.h"
+#include "cabin/core/mipmapchain.h"
+#include "cabin/core/compressedimage.h"
+#include "cabin/core/textureuploader.h"
+#include "cabin/core/geometrypool.h"
 
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #define TINYGLTF_NO_INCLUDE_STB_IMAGE
@@ -24,12 +28,18 @@ namespace cabin::utils {
             glm::vec2 texCoord;
         };
 
+        //! Layer of a `GL_TEXTURE_2D_ARRAY` holding a material texture.
+        struct TextureLayer {
+            size_t texture { 0 };   //!< Index into `Model::textures`.
+            GLint layer { 0 };
+        };
+
         struct Material {
-            std::optional<size_t> baseColorTexture         {};
-            std::optional<size_t> metallicRoughnessTexture {};
-            std::optional<size_t> normalTexture            {};
-            std::optional<size_t> emissiveTexture          {};
-            std::optional<size_t> occlusionTexture         {};
+            std::optional<TextureLayer> baseColorTexture         {};
+            std::optional<TextureLayer> metallicRoughnessTexture {};
+            std::optional<TextureLayer> normalTexture            {};
+            std::optional<TextureLayer> emissiveTexture          {};
+            std::optional<TextureLayer> occlusionTexture         {};
 
             std::optional<glm::vec4> baseColorFactor {};
             std::optional<float> metallicFactor      {};
@@ -37,10 +47,10 @@ namespace cabin::utils {
             std::optional<glm::vec3> emissiveFactor  {};
         };
 
+        //! Material of a primitive, and its vertices and indices (in their glTF width) in `Model::geometry`.
         struct Primitive {
             Material material {};
-            core::VertexBuffer vertices {};
-            std::vector<unsigned int> indices {};
+            core::GeometryPool::MeshID mesh { 0 };
         };
 
         using Mesh = std::vector<Primitive>;
@@ -52,22 +62,76 @@ namespace cabin::utils {
             Builder(Builder&&) = delete;
             Builder(const Builder&) = delete;
 
+            /** Stream textures of the model through the uploader, instead of client memory.
+             *
+             * @note Should be set before `fromGLB` or `fromGLTF`, and the uploader
+             *       must outlive the builder.
+             */
+            Builder& setTextureUploader(core::TextureUploader& uploader);
+
+            /** Compress textures of the model to BCn formats, cached as KTX2 files in the directory.
+             *
+             * @note Normal maps are encoded as BC5, images using alpha as BC3, others as BC1.
+             *       The first load encodes images on the shared thread pool, later loads
+             *       skip image decoding. Should be set before `fromGLB` or `fromGLTF`.
+             *
+             * @warning Normal maps only keep the X and Y components, so shaders should
+             *          reconstruct Z.
+             */
+            Builder& setTextureCache(const std::string& directory);
+
             Builder& fromGLB(const std::string& path);
             Builder& fromGLTF(const std::string& path);
 
             Model build();
 
         private:
+            //! Decode images collected while parsing, on the shared thread pool.
+            void decodeImages();
+
+            /** Load an image from the texture cache, or decode it and generate its mipmap
+             *  chain (then compress it into the cache).
+             *
+             * @param isSrgb Whether the image holds colors, filtered in linear space.
+             */
+            void loadImage(size_t imageIndex, bool isNormalMap, bool isSrgb);
+
             void loadModel();
             void loadNode(const tinygltf::Node& node);
             void loadMesh(const tinygltf::Mesh& mesh, const glm::mat4& transform);
-            size_t loadTexture(int textureIndex);
+
+            /** Upload the textures used by materials into texture arrays.
+             *
+             * @note Images of the same size, format, level count and sampler share
+             *       an array, so that materials mostly differ by layers, not textures.
+             *       Textures of one image and sampler state share a layer.
+             *       Arrays whose images all have a source are evictable by `core::MemoryBudget`.
+             */
+            void loadTextures();
+
+        private:
+            //! Where an image is reloaded from, after its texture array is evicted.
+            struct ImageSource {
+                std::string cachePath {};                                   //!< KTX2 file of the texture cache.
+                std::shared_ptr<const std::vector<unsigned char>> bytes {}; //!< Encoded image, without cache.
+                bool isSrgb { false };
+            };
+
+            //! Decode the images of an evicted texture array again, and upload them into its layers.
+            static void reloadLayers(GLuint arrayId, const std::vector<ImageSource>& sources, GLsizei levels);
 
         private:
             tinygltf::Model m_model {};
+            std::vector<std::vector<unsigned char>> m_encodedImages {};
+            std::vector<std::optional<core::CompressedImage>> m_compressedImages {};
+            std::vector<std::optional<core::MipmapChain>> m_mipmapChains {};
+            std::vector<ImageSource> m_imageSources {};
+            std::string m_textureCacheDirectory {};
             std::vector<Mesh> m_meshes {};
+            core::GeometryPool m_geometry {};
             std::vector<core::Texture> m_textures {};
-            std::map<size_t, size_t> m_loadedTextures {};
+            std::map<int, TextureLayer> m_textureLayers {};
+            core::TextureUploader* m_textureUploader { nullptr };
         };
 
     public:
@@ -77,10 +141,25 @@ namespace cabin::utils {
         Model(const Model& right) = delete;
         Model& operator=(const Model& right) = delete;
 
+        /** Draw all primitives of the model.
+         *
+         * @note Each primitive is drawn with the shader variant enabling the
+         *       declared features of its material textures, among
+         *       `BASE_COLOR_TEXTURE`, `METALLIC_ROUGHNESS_TEXTURE`, `NORMAL_TEXTURE`,
+         *       `EMISSIVE_TEXTURE` and `OCCLUSION_TEXTURE`.
+         *
+         *       Material textures are `sampler2DArray`s (units 0 to 4), and their
+         *       layers are set as `int` uniforms, e.g. `baseColorLayer`. Arrays
+         *       already bound by the previous primitive aren't bound again.
+         *
+         *       Primitives are drawn from the pages of `geometry` with base vertices,
+         *       so primitives of the same page don't rebind any buffer.
+         */
         void draw(const core::Shader& shader) const;
 
     public:
         std::vector<Mesh> meshes {};
         std::vector<core::Texture> textures {};
+        core::GeometryPool geometry {};
     };
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "cabin/core/vertexbuffer.h"
 
 #include <cmath>
+#include <vector>
+#include <cstring>
 #include <glad/glad.h>
 #include <glm/geometric.hpp>
 #include <glm/ext/scalar_constants.hpp>
@@ -62,29 +64,55 @@ namespace {
         -1.0, -1.0, 0.0,  0.0, 0.0, 1.0,  0.0, 0.0,
          1.0, -1.0, 0.0,  0.0, 0.0, 1.0,  1.0, 0.0
     };
+
+    constexpr size_t SHAPE_VERTEX_SIZE = 8;
+
+    struct alignas(4) ShapeVertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+    static_assert(sizeof(ShapeVertex) == SHAPE_VERTEX_SIZE * sizeof(float));
+
+    using ShapeLayout = cabin::core::vertex::Layout<&ShapeVertex::position, &ShapeVertex::normal, &ShapeVertex::texCoord>;
+
+    //! Build an indexed vertex buffer from a triangle list, merging its identical vertices.
+    cabin::core::VertexBuffer weldVertices(const float* triangles, size_t vertexCount) {
+        std::vector<float> vertices {};
+        std::vector<unsigned char> indices {};
+        for (size_t i = 0; i < vertexCount; i++) {
+            const float* vertex = triangles + i * SHAPE_VERTEX_SIZE;
+
+            size_t index = 0;
+            size_t uniqueCount = vertices.size() / SHAPE_VERTEX_SIZE;
+            while (index < uniqueCount &&
+                   std::memcmp(vertices.data() + index * SHAPE_VERTEX_SIZE, vertex, SHAPE_VERTEX_SIZE * sizeof(float)) != 0)
+                index++;
+
+            if (index == uniqueCount)
+                vertices.insert(vertices.end(), vertex, vertex + SHAPE_VERTEX_SIZE);
+            indices.push_back(static_cast<unsigned char>(index));
+        }
+
+        return cabin::core::VertexBuffer::Builder()
+                        .setBuffer(vertices.data(), vertices.size() * sizeof(float), GL_STATIC_DRAW)
+                        .setIndices(indices.data(), indices.size())
+                        .setLayout(ShapeLayout {})
+                        .build();
+    }
 }
 
 namespace cabin::utils {
 
     Shape::Builder& Shape::Builder::asCube() {
-        m_vertices = core::VertexBuffer::Builder()
-                                .setBuffer(SHAPE_CUBE_VERTICES, sizeof(SHAPE_CUBE_VERTICES), GL_STATIC_DRAW)
-                                .addAttribute<float>(0, 3)
-                                .addAttribute<float>(1, 3)
-                                .addAttribute<float>(2, 2)
-                                .build();
+        m_vertices = weldVertices(SHAPE_CUBE_VERTICES, 36);
         m_count = 36;
 
         return *this;
     }
 
     Shape::Builder& Shape::Builder::asPlane() {
-        m_vertices = core::VertexBuffer::Builder()
-                                .setBuffer(SHAPE_PLANE_VERTICES, sizeof(SHAPE_PLANE_VERTICES), GL_STATIC_DRAW)
-                                .addAttribute<float>(0, 3)
-                                .addAttribute<float>(1, 3)
-                                .addAttribute<float>(2, 2)
-                                .build();
+        m_vertices = weldVertices(SHAPE_PLANE_VERTICES, 6);
         m_count = 6;
         
         return *this;
@@ -136,30 +164,28 @@ namespace cabin::utils {
             }
         }
 
-        struct alignas(4) Vertex {
-            glm::vec3 position;
-            glm::vec3 normal;
-            glm::vec2 texCoord;
-        };
-        std::vector<Vertex> vertices(6 * (2 * division - 1) * (division - 1));
-        
-        for (size_t i = 0; i < 6 * (2 * division - 1) * (division - 1); i += 3) {
-            for (size_t j = 0; j < 3; j++) {
-                size_t index = indices[i + j];
-                vertices[i + j].position = positions[index];
-                vertices[i + j].normal = positions[index];
-                vertices[i + j].texCoord = texCoords[index];
-            }
+        std::vector<ShapeVertex> vertices(positions.size());
+
+        for (size_t i = 0; i < vertices.size(); i++) {
+            vertices[i].position = positions[i];
+            vertices[i].normal = positions[i];
+            vertices[i].texCoord = texCoords[i];
         }
 
-        m_vertices = core::VertexBuffer::Builder()
-                                .setBuffer(vertices.data(), vertices.size() * sizeof(Vertex), GL_STATIC_DRAW)
-                                .addAttribute<float>(0, 3)
-                                .addAttribute<float>(1, 3)
-                                .addAttribute<float>(2, 2)
-                                .build();
+        // Vertices are shared by the triangles around them, so 16-bit indices cover the usual divisions.
+        core::VertexBuffer::Builder builder {};
+        builder.setBuffer(vertices.data(), vertices.size() * sizeof(ShapeVertex), GL_STATIC_DRAW)
+               .setLayout(ShapeLayout {});
+
+        if (vertices.size() <= 0xFFFF) {
+            std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            builder.setIndices(shortIndices.data(), shortIndices.size());
+        } else {
+            builder.setIndices(indices.data(), indices.size());
+        }
+        m_vertices = builder.build();
         
-        m_count = static_cast<GLsizei>(vertices.size());
+        m_count = static_cast<GLsizei>(indices.size());
         
         return *this;
     }
@@ -184,7 +210,6 @@ namespace cabin::utils {
     }
 
     void Shape::draw() {
-        vertices.bind();
-        glDrawArrays(GL_TRIANGLES, 0, count);
+        vertices.draw(GL_TRIANGLES);
     }
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+namespace cabin::utils {
+
+    //! Pool owning the current thread, if it's a worker.
+    static thread_local const ThreadPool* currentPool = nullptr;
+
+    ThreadPool::ThreadPool(size_t threadCount) {
+        threadCount = std::max<size_t>(threadCount, 1);
+        try {
+            for (size_t i = 0; i < threadCount; i++)
+                m_workers.emplace_back([this] { runWorker(); });
+        } catch (...) {
+            // Destroying joinable threads terminates, so join the started ones first.
+            stopWorkers();
+            throw;
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        stopWorkers();
+    }
+
+    void ThreadPool::stopWorkers() {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_condition.notify_all();
+
+        for (auto& worker : m_workers)
+            worker.join();
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& func) {
+        size_t taskCount = std::min(count, getThreadCount() * 4);
+        if (taskCount <= 1 || isWorkerThread()) {
+            func(0, count);
+            return;
+        }
+
+        std::vector<std::future<void>> tasks {};
+        for (size_t i = 0; i < taskCount; i++) {
+            size_t begin = count * i / taskCount, end = count * (i + 1) / taskCount;
+            tasks.push_back(submit([&func, begin, end] { func(begin, end); }));
+        }
+
+        // Wait for all ranges before reporting any error, since they reference `func`.
+        for (auto& task : tasks)
+            task.wait();
+        for (auto& task : tasks)
+            task.get();
+    }
+
+    size_t ThreadPool::getThreadCount() const {
+        return m_workers.size();
+    }
+
+    bool ThreadPool::isWorkerThread() const {
+        return currentPool == this;
+    }
+
+    ThreadPool& ThreadPool::getShared() {
+        static ThreadPool pool {};
+        return pool;
+    }
+
+    void ThreadPool::runWorker() {
+        currentPool = this;
+        while (true) {
+            std::function<void()> task {};
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait(lock, [this] { return m_isStopping || !m_tasks.empty(); });
+
+                // Drain the queue before stopping, so that no future is left broken.
+                if (m_tasks.empty())
+                    return;
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ */
+
+#pragma once
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <future>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+namespace cabin::utils {
+
+    /** Worker Thread Pool
+     *
+     * --------------------------
+     * `ThreadPool` runs submitted tasks on a fixed set of worker
+     *  threads, in submission order. Results and exceptions of a
+     *  task are delivered by the returned `std::future`.
+     *
+     * @note Tasks must not touch the OpenGL context, which is only
+     *       current on the main thread.
+     *
+     * @see Usage example:
+     *       src/cabin/utils/model.cc (glTF image decoding)
+     */
+    class ThreadPool {
+    public:
+        //! Start the workers, at least one.
+        explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+
+        ThreadPool(ThreadPool&&) = delete;
+        ThreadPool(const ThreadPool&) = delete;
+
+        //! Finish all submitted tasks, and join the workers.
+        ~ThreadPool();
+
+        template <typename Func>
+        std::future<std::invoke_result_t<Func>> submit(Func&& func) {
+            // `std::function` requires copyable targets, so share the task instead.
+            auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Func>()>>(std::forward<Func>(func));
+            std::future<std::invoke_result_t<Func>> result = task->get_future();
+            {
+                std::scoped_lock lock(m_mutex);
+                m_tasks.emplace_back([task] { (*task)(); });
+            }
+            m_condition.notify_one();
+            return result;
+        }
+
+        /** Split `[0, count)` into ranges run on the workers, and wait for all of them.
+         *
+         * @param func Called with `(begin, end)` of each range.
+         *
+         * @note Runs inline when called from a worker, see `isWorkerThread`.
+         *       The first error of the ranges is rethrown.
+         */
+        void parallelFor(size_t count, const std::function<void(size_t, size_t)>& func);
+
+        size_t getThreadCount() const;
+
+        /** Check whether the calling thread is a worker of this pool.
+         *
+         * @note Tasks waiting for other tasks of the same pool may deadlock,
+         *       so nested work should run inline on workers.
+         */
+        bool isWorkerThread() const;
+
+        //! Get the pool shared by cabin, e.g. for decoding images in background.
+        static ThreadPool& getShared();
+
+    private:
+        void runWorker();
+
+        //! Let workers finish the queued tasks, and join them.
+        void stopWorkers();
+
+    private:
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        std::deque<std::function<void()>> m_tasks {};
+        bool m_isStopping { false };
+        std::vector<std::thread> m_workers {};
+    };
+}
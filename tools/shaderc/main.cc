@@ -0,0 +1,153 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ *
+ *
+ * `cabin-shaderc` flattens cabin shader files offline, with the same
+ *  `core::ShaderProcesser` used at runtime, so that syntax errors and
+ *  missing used files fail the build instead of the launch.
+ *
+ *  Usage: `cabin-shaderc [-o <directory>] [-s] [-m <directory>] <file.shader>...`
+ *
+ *   - Without `-o`, shaders are only validated.
+ *   - `-o`: write `{name}.shaderbundle` of each shader into the directory,
+ *           which `core::Shader::Builder::fromFile` loads in place of the
+ *           shader file.
+ *   - `-s`: also write flattened stage sources `{name}.vert`, `.geom`,
+ *           `.frag` or `.comp` next to the bundle, for inspection or for
+ *           offline compilers.
+ *   - `-m`: write stage sources of the base variant into the directory,
+ *           as `{hash}.vert`, `.geom`, `.frag` or `.comp` named like the
+ *           SPIR-V modules looked up by `core::Shader::Builder::setSpirvDirectory`,
+ *           to be compiled into `{hash}.spv`, e.g. by `glslangValidator -G`.
+ *
+ *  Stages carry `#line` directives, numbering files as listed in the
+ *  header comment of the stage sources, so that driver errors point
+ *  back to the original files. Sources written by `-m` carry none,
+ *  since they must match the sources compiled at runtime.
+ */
+
+#include <string>
+#include <vector>
+#include <format>
+#include <fstream>
+#include <cstdlib>
+#include <utility>
+#include <stdexcept>
+#include <filesystem>
+
+#include "cabin/utils/console.h"
+#include "cabin/core/shader.h"
+#include "cabin/core/shaderprocesser.h"
+using namespace cabin;
+
+void writeStageSource(const std::string& path, const core::ShaderProcesser::Result& result, const std::string& stage) {
+    std::ofstream file(path, std::ios::trunc);
+    file << result.version << "\n";
+    for (size_t i = 0; i < result.dependencies.size(); i++)
+        file << std::format("// #line file {}: {}\n", i, result.dependencies[i]);
+    file << stage;
+
+    if (!file.good())
+        throw std::runtime_error(std::format("failed to write stage source \"{}\"", path));
+}
+
+void writeSpirvSources(const std::string& directory, const core::ShaderProcesser::Result& result) {
+    std::filesystem::create_directories(directory);
+
+    const std::pair<const std::string*, const char*> stages[] = {
+        { &result.vertex, ".vert" }, { &result.geometory, ".geom" },
+        { &result.fragment, ".frag" }, { &result.compute, ".comp" }
+    };
+    for (const auto& [stage, extension] : stages) {
+        if (stage->empty())
+            continue;
+
+        // Same as the stage source built by `core::Shader::Builder` without features.
+        std::string source = result.version + "\n" + *stage;
+        std::string path = (std::filesystem::path(directory) / (core::Shader::getSpirvModuleName(source) + extension)).string();
+
+        std::ofstream file(path, std::ios::trunc);
+        file << source;
+        if (!file.good())
+            throw std::runtime_error(std::format("failed to write stage source \"{}\"", path));
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string outputDirectory {};
+    std::string spirvDirectory {};
+    bool hasStageSources = false;
+    std::vector<std::string> inputPaths {};
+
+    bool isUsageError = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o") {
+            if (i + 1 < argc)
+                outputDirectory = argv[++i];
+            else
+                isUsageError = true;
+        }
+        else if (arg == "-m") {
+            if (i + 1 < argc)
+                spirvDirectory = argv[++i];
+            else
+                isUsageError = true;
+        }
+        else if (arg == "-s")
+            hasStageSources = true;
+        else
+            inputPaths.push_back(arg);
+    }
+
+    if (isUsageError || inputPaths.empty() || (hasStageSources && outputDirectory.empty())) {
+        utils::Console::error("usage: cabin-shaderc [-o <directory>] [-s] [-m <directory>] <file.shader>...");
+        return EXIT_FAILURE;
+    }
+
+    // Report all broken shaders at once, rather than stopping at the first one.
+    size_t failureCount = 0;
+    for (const auto& inputPath : inputPaths) {
+        try {
+            core::ShaderProcesser processer(inputPath);
+            processer.setLineDirectives(true);
+            core::ShaderProcesser::Result result = processer.process();
+
+            if (!outputDirectory.empty()) {
+                std::string outputPath = (std::filesystem::path(outputDirectory) / std::filesystem::path(inputPath).stem()).string();
+                core::ShaderProcesser::saveBundle(result, outputPath + ".shaderbundle");
+
+                if (hasStageSources) {
+                    const std::pair<const std::string*, const char*> stages[] = {
+                        { &result.vertex, ".vert" }, { &result.geometory, ".geom" },
+                        { &result.fragment, ".frag" }, { &result.compute, ".comp" }
+                    };
+                    for (const auto& [stage, extension] : stages) {
+                        if (!stage->empty())
+                            writeStageSource(outputPath + extension, result, *stage);
+                    }
+                }
+            }
+
+            if (!spirvDirectory.empty())
+                writeSpirvSources(spirvDirectory, core::ShaderProcesser(inputPath).process());
+
+            utils::Console::info(std::format("flattened \"{}\" ({} files, {} features)",
+                                             inputPath, result.dependencies.size(), result.features.size()));
+        } catch (const std::exception& e) {
+            utils::Console::error(std::format("\"{}\": {}", inputPath, e.what()));
+            failureCount++;
+        }
+    }
+
+    if (failureCount) {
+        utils::Console::error(std::format("{} of {} shaders failed", failureCount, inputPaths.size()));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,3 @@
+target("cabin-shaderc")
+    set_kind("binary")
+    add_files("main.cc")
@@ -0,0 +1,118 @@
+/**
+ * cabin-framework (https://github.com/anpydx/cabin)
+ *
+ * Copyright (c) 2025 anpyd, All Rights Reserved.
+ * Licensed under the MIT License.
+ *
+ *
+ * `cabin-texturec` cooks images into BCn compressed KTX2 files offline,
+ *  with the same `core::CompressedImage` encoder used by the texture
+ *  cache of `utils::Model`, loadable by `core::Texture::Builder::fromFileKTX2`.
+ *
+ *  Usage: `cabin-texturec -o <directory> [-f bc1|bc3|bc4|bc5] [-s] [-m] [-k] <image>...`
+ *
+ *   - `-o`: write `{name}.ktx2` of each image into the directory.
+ *   - `-f`: the BCn format, by default BC3 for images with alpha, BC1 otherwise.
+ *   - `-s`: encode color images to the sRGB variant of BC1 or BC3, e.g. base colors.
+ *   - `-m`: also encode the complete mipmap chain, downsampled with the Kaiser filter
+ *           of `core::MipmapChain` (in linear space for sRGB formats).
+ *   - `-k`: keep the orientation of images, rather than flipping them
+ *           vertically as `core::Texture::Builder::fromFile2D` does.
+ */
+
+#include <string>
+#include <vector>
+#include <format>
+#include <cstdlib>
+#include <filesystem>
+
+#include "cabin/utils/console.h"
+#include "cabin/core/compressedimage.h"
+using namespace cabin;
+
+int main(int argc, char** argv) {
+    std::string outputDirectory {};
+    std::string formatName {};
+    bool isSrgb = false;
+    bool hasMipmap = false;
+    bool flip = true;
+    std::vector<std::string> inputPaths {};
+
+    bool isUsageError = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o") {
+            if (i + 1 < argc)
+                outputDirectory = argv[++i];
+            else
+                isUsageError = true;
+        }
+        else if (arg == "-f") {
+            if (i + 1 < argc)
+                formatName = argv[++i];
+            else
+                isUsageError = true;
+        }
+        else if (arg == "-s")
+            isSrgb = true;
+        else if (arg == "-m")
+            hasMipmap = true;
+        else if (arg == "-k")
+            flip = false;
+        else
+            inputPaths.push_back(arg);
+    }
+
+    GLenum format = 0;
+    if (formatName == "bc1")
+        format = isSrgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if (formatName == "bc3")
+        format = isSrgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    else if (formatName == "bc4")
+        format = GL_COMPRESSED_RED_RGTC1;
+    else if (formatName == "bc5")
+        format = GL_COMPRESSED_RG_RGTC2;
+
+    // BC4 and BC5 keep data channels, which have no sRGB variant.
+    bool isSrgbMismatch = isSrgb && (formatName == "bc4" || formatName == "bc5");
+    if (isUsageError || inputPaths.empty() || outputDirectory.empty() || (!formatName.empty() && !format) || isSrgbMismatch) {
+        utils::Console::error("usage: cabin-texturec -o <directory> [-f bc1|bc3|bc4|bc5] [-s] [-m] [-k] <image>...");
+        return EXIT_FAILURE;
+    }
+
+    // Report all broken images at once, rather than stopping at the first one.
+    size_t failureCount = 0;
+    for (const auto& inputPath : inputPaths) {
+        try {
+            core::Texture::Image image = core::Texture::decodeFile(inputPath, flip);
+
+            GLenum imageFormat = format;
+            if (!imageFormat && isSrgb)
+                imageFormat = image.srcFormat == GL_RGBA ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+            else if (!imageFormat)
+                imageFormat = image.srcFormat == GL_RGBA ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+            core::MipmapChain chain = core::MipmapChain::generate(
+                image, hasMipmap ? core::Texture::ALL_MIPMAP_LEVELS : 1, isSrgb, core::MipmapChain::Filter::Kaiser);
+            core::CompressedImage compressed = core::CompressedImage::encode(chain, imageFormat);
+
+            std::string outputPath = (std::filesystem::path(outputDirectory) / std::filesystem::path(inputPath).stem()).string() + ".ktx2";
+            compressed.saveKTX2(outputPath);
+
+            size_t sourceSize = static_cast<size_t>(image.width) * image.height * (image.srcFormat == GL_RGBA ? 4 : 3);
+            utils::Console::info(std::format("cooked \"{}\" ({} levels, {} KiB from {} KiB)",
+                                             inputPath, compressed.levels.size(), compressed.getSize() / 1024, sourceSize / 1024));
+        } catch (const std::exception& e) {
+            utils::Console::error(std::format("\"{}\": {}", inputPath, e.what()));
+            failureCount++;
+        }
+    }
+
+    if (failureCount) {
+        utils::Console::error(std::format("{} of {} images failed", failureCount, inputPaths.size()));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
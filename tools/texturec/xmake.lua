@@ -0,0 +1,3 @@
+target("cabin-texturec")
+    set_kind("binary")
+    add_files("main.cc")
@@ -0,0 +1,6 @@
+-- Cabin Tools
+
+add_deps("cabin")
+set_rundir("$(projectdir)")
+
+includes("shaderc", "texturec")
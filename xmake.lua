@@ -7,6 +7,7 @@ set_rules("mode.debug", "mode.release")
 
 add_requires("glad", "glfw", "glm", "stb", "tinygltf")
 add_requires("imgui", {configs = { glfw = true, opengl3 = true }})
+add_requires("glslang", {configs = { binaryonly = true }})
 add_packages("glad", "glfw", "glm", "stb", "imgui", "tinygltf")
 
-includes("src", "sandbox")
\ No newline at end of file
+includes("src", "sandbox", "tools")
\ No newline at end of file